@@ -100,6 +100,7 @@ void AdaptronicSelect::AdaptronicStartStream()
 void AdaptronicSelect::readyToRead()
 {
 
+        SampleTimeScope received(m_dashboard, SampleClock::now());
         auto reply = qobject_cast<QModbusReply *>(sender());
         qDebug()<< "recieve :" <<reply;
         if(!reply)
@@ -156,12 +156,6 @@ double add[] = FC_INFO_ADD;
 const double MIN_TPS_VOLT = 0.56;
 const double MAX_TPS_VOLT = 4.024;
 
-/**
- * These values depend on the installed wideband sensor.
- */
-const double MAX_AFR = 19.8;
-const double MIN_AFR = 9.8;
-
 
 /**
  * Limits the number of write requests to the fuel map.
@@ -171,36 +165,52 @@ const double MIN_AFR = 9.8;
 const int FUEL_MAP_MAX_WRITE_REQUESTS = 5;
 
 /**
- * The following values decide when autotune will be active.
+ * The rpm/load axes of the fuel map, used to share each AFR sample with the neighbour cells.
  */
-const double MIN_AUTOTUNE_WATER_TEMP = 65;
-const double MIN_AUTOTUNE_RPM = 500;
-const double MAX_AUTOTUNE_RPM = 4000;
-const double MAX_AUTOTUNE_TPS_CHANGE_RATE = 4; // volt / second
-const double MIN_AUTOTUNE_TPS_CHANGE_RATE = -4;
-const double MAX_AUTOTUNE_SPEED = 2; // km/h
-const double MAX_AUTOTUNE_TPS_VOLT = 2.0;
+const char* FUEL_MAP_AXES_FILE = "/home/pi/FuelMapAxes.csv";
+
+/**
+ * Per cell target AFR and number of samples required before a cell is corrected.
+ */
+const char* TARGET_AFR_MAP_FILE = "/home/pi/TargetAfrMap.csv";
+const char* MIN_CELL_SAMPLES_MAP_FILE = "/home/pi/MinCellSamplesMap.csv";
+
+/**
+ * The logged AFR data is saved here (periodically and on disconnect) and restored when the PFC has the same fuel map.
+ */
+const char* AUTOTUNE_STATE_FILE = "/home/pi/AutoTuneState.bin";
+const char* FUEL_MAP_FILE = "/home/pi/FuelMap.csv"; // input of the offline autotune tool
+const qint64 AUTOTUNE_CHECKPOINT_INTERVAL_MS = 60000;
+
 
 /**
  * The "master switch" of the autotune.
  */
 bool closedLoopEnabled = true;
 
+// The AFR transport delay in use (DEFAULT_AFR_TRANSPORT_DELAY_MS until set)
+int afrTransportDelayMs = DEFAULT_AFR_TRANSPORT_DELAY_MS;
+
 // The last logged AFR value(-1 = uninitialized)
 double loggedAFR = -1;
-double lastTpsVolt = MIN_TPS_VOLT;
-QTime lastLogTime = QTime::currentTime();
+// Sample time (SampleClock) of the last logged operating point
+qint64 lastLogTime = 0;
+// The latest operating points, used to find where the current AFR came from
+OperatingPointHistory operatingPointHistory;
+
+// The autotune state is only saved after the fuel map is read from the PFC (the state is tied to the map)
+bool fuelMapRead = false;
+qint64 lastAutoTuneCheckpointMs = 0;
 
 // Used for logging messages in fixed intervals
 long logSamplesCount = 0;
 // Log every this number of samples
 const int LOG_SAMPLE_COUNT_INTERVAL = 10;
 
-// Used to calculate and log the average value of aux3 (instead of logging each value)
+// aux3 is averaged over this number of samples (instead of logging each value)
 // This is done for 'erratic' readings ex. oil pressure
-double aux3Values[10];
-int aux3CalcIdx = 0;
-bool emitAux3Value = false;
+const int AUX3_SMOOTHING_WINDOW = 10;
+ChannelSmoother aux3Smoother(ChannelSmoother::Average, AUX3_SMOOTHING_WINDOW);
 
 Apexi::Apexi(QObject *parent)
         : QObject(parent), m_dashboard(Q_NULLPTR) {
@@ -235,11 +245,21 @@ void Apexi::clear() {
 void Apexi::openConnection(const QString &portName) {
     cout << "Logging level:" << LOG_LEVEL << endl
          << "Log Interval:" << LOG_SAMPLE_COUNT_INTERVAL << endl
-         << "Closed Loop:" << (closedLoopEnabled ? "Yes" : "No") << endl;
+         << "Closed Loop:" << (closedLoopEnabled ? "Yes" : "No") << endl
+         << "AFR Transport Delay:" << afrTransportDelayMs << "ms" << endl;
     if (LOG_LEVEL >= LOGGING_INFO) {
         cout << "Opening connection\n";
     }
     port = portName;
+    loadFuelMapAxes(FUEL_MAP_AXES_FILE);
+    // a table whose file is gone falls back to the defaults, so it does not survive the reconnect
+    loadTargetAfrMap(TARGET_AFR_MAP_FILE);
+    loadMinCellSamplesMap(MIN_CELL_SAMPLES_MAP_FILE);
+    // the checkpoint time of the previous connection must not hold back the checkpoints of this one
+    lastAutoTuneCheckpointMs = SampleClock::now();
+    operatingPointHistory.clear();
+    fuelMapRead = false;
+    aux3Smoother.reset();
     initSerialPort();
     m_serialport->setPortName(port);
     m_serialport->setBaudRate(QSerialPort::Baud57600);
@@ -268,6 +288,7 @@ void Apexi::closeConnection() {
     if (LOG_LEVEL >= LOGGING_INFO) {
         cout << "Closing connection\n";
     }
+    saveAutoTuneSession();
     disconnect(this->m_serialport, SIGNAL(readyRead()), this, SLOT(readyToRead()));
     disconnect(m_serialport, static_cast<void (QSerialPort::*)(QSerialPort::SerialPortError)>(&QSerialPort::error),
                this, &Apexi::handleError);
@@ -328,6 +349,7 @@ void Apexi::readyToRead() {
     if (LOG_LEVEL >= LOGGING_DEBUG) {
         cout << "readyToRead callback." << endl;
     }
+    SampleTimeScope received(m_dashboard, SampleClock::now());
     m_readData = m_serialport->readAll();
     m_dashboard->setRecvData(QString("Receive Data : " + m_readData.toHex()));
     Apexi::decodeResponseAndSendNextRequest(m_readData);
@@ -416,73 +438,87 @@ bool Apexi::isNotWOT() {
     return tpsVolt < MAX_AUTOTUNE_TPS_VOLT;
 }
 
+/**
+ * The load that corresponds to the MapP index, as decoded from the advanced data (not unit converted).
+ */
+double Apexi::getAutoTuneLoad() {
+    switch (Model) {
+        case 1:
+            return packageADV[1]; // Intakepress
+        case 2:
+            return packageADV2[1]; // EngLoad
+        case 3:
+            return packageADV3[1]; // Intakepress
+        default:
+            return 0;
+    }
+}
+
 void Apexi::updateAutoTuneLogs() {
-    const QTime now = QTime::currentTime();
+    // the operating points are on the same clock as every other sample, at the time the frame was received
+    const long nowMs = (long) m_dashboard->sampleTime();
 
     const int rpmIdx = packageMap[0]; // col MapN
     const int loadIdx = packageMap[1];// row MapP
     const double speed = (double) m_dashboard->speed();
     const double rpm = (double) m_dashboard->rpm(); // packageBasic[3];
+    const double load = getAutoTuneLoad();
+    const double rpmPos = getFuelMapRpmPosition(rpmIdx, rpm);
+    const double loadPos = getFuelMapLoadPosition(loadIdx, load);
     const double waterTemp = (double) m_dashboard->Watertemp(); // packageBasic[7];
     const double tpsVolt = (double) m_dashboard->ThrottleV();
 
-    const double timeDeltaSeconds = lastLogTime.msecsTo(now) / 1000.0;
-    const double tpsChangeRate = (tpsVolt - lastTpsVolt) / timeDeltaSeconds;
-    lastLogTime = now;
-    lastTpsVolt = tpsVolt;
+    lastLogTime = nowMs;
+    operatingPointHistory.record(nowMs, rpmPos, loadPos, rpm, load, tpsVolt);
 
-    bool shouldUpdateAfr = true;
+    // The current AFR is the result of the operating point one transport delay ago
+    AutoTuneOperatingPoint afrPoint;
+    const bool afrPointFound = operatingPointHistory.findAt(nowMs - afrTransportDelayMs, afrPoint);
+
+    AutoTuneGate gate = AUTOTUNE_GATE_OPEN;
     if (!closedLoopEnabled) {
         // Update AFR only when the closed loop is enabled
-        m_dashboard->setClosedLoop(0); // "Off: Closed Loop Disabled");
-        shouldUpdateAfr = false;
-    } else if (loggedAFR < MIN_AFR || loggedAFR > MAX_AFR) {
-        // AFR value should be within some bounds
-        m_dashboard->setClosedLoop(0); // "Off: AFR out of bounds");
-        shouldUpdateAfr = false;
-    } else if (waterTemp < MIN_AUTOTUNE_WATER_TEMP) {
-        // Engine should be warmed up
-        m_dashboard->setClosedLoop(0); // "Off: Engine not warmed up");
-        shouldUpdateAfr = false;
-    } else if (rpm < MIN_AUTOTUNE_RPM || rpm > MAX_AUTOTUNE_RPM) {
-        // Engine is actually started and revving up to a certain RPM
-        m_dashboard->setClosedLoop(0); // "Off: RPM to low or to high");
-        shouldUpdateAfr = false;
-    } else if (tpsChangeRate > MAX_AUTOTUNE_TPS_CHANGE_RATE || tpsChangeRate < MIN_AUTOTUNE_TPS_CHANGE_RATE){
-        // Do not auto tune on sudden throttle changes (do not mess with accel enrich etc)
-        m_dashboard->setClosedLoop(0); // "Off: Accel enrich or decel cut");
-        shouldUpdateAfr = false;
-    } else if(tpsVolt > MAX_AUTOTUNE_TPS_VOLT) {
-        // Do not autotune near WOT
-        m_dashboard->setClosedLoop(0); // "Off: WOT");
-        shouldUpdateAfr = false;
-    } else if (speed > MAX_AUTOTUNE_SPEED) {
-        // Do not autotune when moving.
-        m_dashboard->setClosedLoop(0); // "Off: Moving");
-        shouldUpdateAfr = false;
+        gate = AUTOTUNE_GATE_DISABLED;
+    } else if (!afrPointFound) {
+        // Not enough history yet (or gap in the data) to know where the AFR came from
+        gate = AUTOTUNE_GATE_NO_OPERATING_POINT;
     } else {
-        m_dashboard->setClosedLoop(1); // "Active");
-        shouldUpdateAfr = true;
+        gate = checkAutoTuneGate(loggedAFR, waterTemp, speed, afrPoint);
     }
+    const bool shouldUpdateAfr = gate == AUTOTUNE_GATE_OPEN;
+    m_dashboard->setClosedLoop(shouldUpdateAfr ? 1 : 0); // "Active" / "Off"
 
     if (shouldUpdateAfr) {
-        updateAFRData(rpmIdx, loadIdx, loggedAFR);
+        updateAFRData(afrPoint.rpmPos, afrPoint.loadPos, loggedAFR);
+    }
+
+    if (nowMs - lastAutoTuneCheckpointMs >= AUTOTUNE_CHECKPOINT_INTERVAL_MS) {
+        saveAutoTuneSession();
     }
 
     if (LOG_LEVEL >= LOGGING_DEBUG && (logSamplesCount % LOG_SAMPLE_COUNT_INTERVAL) == 0) {
-        cout << lastLogTime.toString("hh:mm:ss.zzz").toStdString()
-             << setprecision(3) << fixed
+        cout << setprecision(3) << fixed
+             << (lastLogTime / 1000.0) << "s"
              << ", ClosedLoopEnabled:" << (closedLoopEnabled ? "Yes" : "No")
              << ", AutoTuning:" << (shouldUpdateAfr ? "Yes" : "No")
+             << ", Gate:" << getAutoTuneGateName(gate)
              << ", WaterTemp:" << waterTemp
              << ", MapN:" << rpmIdx
              << ", MapP:" << loadIdx
+             << ", RpmPos:" << rpmPos
+             << ", LoadPos:" << loadPos
              << ", Rpm:" << rpm
+             << ", Load:" << load
              << ", Speed:" << speed
              << ", AFR:" << loggedAFR
-             << ", Tps:" << tpsVolt
-             << ", TimeDelta:" << timeDeltaSeconds
-             << ", TpsChangeRate:" << tpsChangeRate << endl;
+             << ", Tps:" << tpsVolt;
+        if (afrPointFound) {
+            cout << ", AfrRpmPos:" << afrPoint.rpmPos
+                 << ", AfrLoadPos:" << afrPoint.loadPos
+                 << ", AfrAge:" << (nowMs - afrPoint.timeMs)
+                 << ", TpsChangeRate:" << afrPoint.tpsChangeRate;
+        }
+        cout << endl;
     }
 }
 
@@ -568,6 +604,16 @@ void Apexi::decodePfcData(QByteArray rawmessagedata) {
                 break;
             case ID::FuelMapBatch8:
                 readFuelMap(8, rawmessagedata.data());
+                if (!fuelMapRead) {
+                    // first read of this connection (the map is also re-read after a timeout)
+                    fuelMapRead = true;
+                    saveCurrentFuelMap(FUEL_MAP_FILE);
+                    if (restoreAutoTuneState(AUTOTUNE_STATE_FILE) && LOG_LEVEL >= LOGGING_INFO) {
+                        cout << "Restored autotune state from " << AUTOTUNE_STATE_FILE << endl;
+                    }
+                    // nothing could be saved until now; the first checkpoint is one interval after the restore
+                    lastAutoTuneCheckpointMs = SampleClock::now();
+                }
                 if (LOG_LEVEL >= LOGGING_INFO) {
                     cout << "== Read the following fuel map ==\n";
                     for (int r = 0; r < 20; r++) {
@@ -880,18 +926,10 @@ void Apexi::decodeAuxBlack(QByteArray rawmessagedata) {
     m_dashboard->setauxcalc1(auxCalc1);
     m_dashboard->setauxcalc2(auxCalc2);
 
-    if (aux3CalcIdx == 9) {
-        emitAux3Value = true;
-    }
-    aux3Values[aux3CalcIdx] = auxCalc3;
-    aux3CalcIdx = (aux3CalcIdx + 1) % 10;
-    if (emitAux3Value) {
-        double sum = 0;
-        for (int i=0; i<10; i++) {
-            sum += aux3Values[i];
-        }
-        m_dashboard->setauxcalc3(sum / 10.0);
-    }
+    // published once the window is full, as the average of a few frames would not settle
+    const double aux3Average = aux3Smoother.add(auxCalc3);
+    if (aux3Smoother.isFull())
+        m_dashboard->setauxcalc3(aux3Average);
 
     m_dashboard->setauxcalc4(auxCalc4);
 
@@ -1085,6 +1123,27 @@ void Apexi::enableClosedLoop(bool enable) {
     closedLoopEnabled = enable;
 }
 
+/**
+ * Saves the logged AFR data, so that autotune continues from this point on the next connect.
+ */
+void Apexi::saveAutoTuneSession() {
+    if (!fuelMapRead || getCurrentFuelMapWriteRequest() != 0) {
+        // the map in the PFC is unknown or only partially written
+        return;
+    }
+    lastAutoTuneCheckpointMs = SampleClock::now();
+    if (!saveAutoTuneState(AUTOTUNE_STATE_FILE)) {
+        cout << "Failed to save autotune state" << endl;
+    } else if (LOG_LEVEL >= LOGGING_DEBUG) {
+        cout << "Saved autotune state to " << AUTOTUNE_STATE_FILE << endl;
+    }
+}
+
+void Apexi::setAfrTransportDelay(int delayMs) {
+    // a longer delay is not in the operating point history, so no AFR sample would be used
+    afrTransportDelayMs = qBound(0, delayMs, MAX_AFR_TRANSPORT_DELAY_MS);
+}
+
 void Apexi::setAuxCalcData(float aux1min, float aux1max,
                            float aux2min, float aux2max,
                            float aux3min, float aux3max,
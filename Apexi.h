@@ -62,6 +62,8 @@ private:
 
     void updateAutoTuneLogs();
 
+    double getAutoTuneLoad();
+
     double packageADV[33];
 
     struct fc_adv_info_t {
@@ -444,6 +446,8 @@ public
 
     void setAuxCalcData(float aux1min, float aux1max, float aux2min, float aux2max, float aux3min, float aux3max, QString Auxunit1, QString Auxunit2, QString Auxunit3);
     void enableClosedLoop(bool enable);
+    void setAfrTransportDelay(int delayMs);
+    void saveAutoTuneSession();
 
     signals:
     void sig_adaptronicReadFinished();
@@ -2,6 +2,11 @@
 #include <stdexcept>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <cmath>
 
 using namespace std;
 
@@ -22,15 +27,28 @@ double newFuelMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
 long afrSamplesCount = 0;
 
 /**
- * A table that holds the sum of the AFR values.
+ * A table that holds the weighted sum of the AFR values.
  */
 double loggedSumAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
 
 /**
- * A table that holds the total AFR samples per row/column.
+ * A table that holds the total AFR sample weight per row/column.
+ * A sample that falls exactly on a cell adds 1, a sample between cells is shared by its neighbours.
  */
 double loggedNumAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
 
+/**
+ * The rpm value at each column of the fuel map (as shown in FC-Edit).
+ * All zero means unknown; in that case each sample is credited entirely to the MapN cell.
+ */
+double fuelMapRpmAxis[FUEL_TABLE_SIZE];
+
+/**
+ * The load value at each row of the fuel map, in the same unit the load is logged.
+ * All zero means unknown; in that case each sample is credited entirely to the MapP cell.
+ */
+double fuelMapLoadAxis[FUEL_TABLE_SIZE];
+
 /**
  * The current request number when writing the map to PFC.
  */
@@ -42,17 +60,17 @@ int fuelMapWriteRequest;
 int fuelMapWriteAttemptInterval = 50;
 
 /**
- * This number of samples are required for each cell in order for this cell to
+ * This number of samples (sample weight) is required for each cell in order for this cell to
  * be eligible to be sent to PFC.
- * TODO should be table
+ * Zero means DEFAULT_MIN_CELL_SAMPLES.
  */
-int minCellSamples = 5;
+double minCellSamplesMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
 
 /**
- * This target AFR for each cell.
- * TODO should be table
+ * The target AFR for each cell.
+ * Zero means DEFAULT_TARGET_AFR.
  */
-double targetAFR = 14.7;
+double targetAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
 
 /**
  * This amount of cell changes are required in order for the map to be sent to PFC.
@@ -64,6 +82,20 @@ int minCellsChangesForWriteAttempt = 1;
  */
 int mapWriteCount = 0;
 
+/**
+ * Converts a human readable fuel value to the PFC format (rounded to the nearest PFC step).
+ */
+int toPfcFuelValue(double humanFuelValue) {
+    return (int)((humanFuelValue * 1000.0) / 4.0 + 0.5);
+}
+
+/**
+ * Converts a PFC fuel value to human readable format.
+ */
+double toHumanFuelValue(int pfcFuelValue) {
+    return (pfcFuelValue * 4.0) / 1000.0;
+}
+
 /**
  * Calculates the row of fuel map based on the provided fuel request number (1-FUEL_MAP_TOTAL_REQUESTS).
  *
@@ -112,7 +144,7 @@ void readFuelMap(int fuelRequestNumber, const char rawData[]) {
         unsigned char byte2 = rawData[i + 1];
 
         int fuelCellValue = (byte2 << 8) + byte1; // two byte big endian
-        double humanFuelValue = (fuelCellValue * 4.0) / 1000.0;
+        double humanFuelValue = toHumanFuelValue(fuelCellValue);
         currentFuelMap[row][col] = humanFuelValue;
 
         // Initially the new fuel map is equal to the current.
@@ -157,7 +189,7 @@ char* createFuelMapWritePacket(int fuelRequestNumber, double (&map)[FUEL_TABLE_S
     int dataIdx = 2;
     while(cellsWritenCount < FUEL_CELLS_PER_REQUEST) {
         // from human readable format to PFC format
-        fuelCell.celValue = (int)((map[row][col] * 1000.0) / 4.0);
+        fuelCell.celValue = toPfcFuelValue(map[row][col]);
         pfcDataPacket[dataIdx++] = fuelCell.celValueBytes[0];
         pfcDataPacket[dataIdx++] = fuelCell.celValueBytes[1];
 
@@ -188,23 +220,451 @@ char* getNextFuelMapWritePacket() {
 }
 
 /**
- * Updates the AFR in the provided position.
+ * Reads a line of FUEL_TABLE_SIZE comma separated values.
+ *
+ * @param in the stream to read from
+ * @param values where the values are stored
+ * @return true if FUEL_TABLE_SIZE values were read
+ */
+bool readFuelMapRow(istream &in, double (&values)[FUEL_TABLE_SIZE]) {
+    string line;
+    if (!getline(in, line)) {
+        return false;
+    }
+    stringstream lineStream(line);
+    string cell;
+    int idx = 0;
+    while (idx < FUEL_TABLE_SIZE && getline(lineStream, cell, ',')) {
+        values[idx++] = atof(cell.c_str());
+    }
+    return idx == FUEL_TABLE_SIZE;
+}
+
+/**
+ * Reads a FUEL_TABLE_SIZE x FUEL_TABLE_SIZE table; one line per row (load), comma separated columns (rpm).
+ * This is the same layout the fuel map is logged.
+ * The provided table is only changed when the entire file is valid (all values positive, or zero when allowed).
+ *
+ * @param fileName the file to read
+ * @param table where the values are stored
+ * @param allowZero whether zero is valid (ex. a cell that uses the default)
+ * @return true if the table was loaded
+ */
+bool readFuelMapTable(const char* fileName, double (&table)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE], bool allowZero = false) {
+    ifstream in(fileName);
+    double values[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        if (!in || !readFuelMapRow(in, values[row])) {
+            cout << "Could not load table from " << fileName << endl;
+            return false;
+        }
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            if (values[row][col] < 0 || (values[row][col] == 0 && !allowZero)) {
+                cout << "Invalid value at row:" << row << " col:" << col << " of " << fileName << endl;
+                return false;
+            }
+        }
+    }
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            table[row][col] = values[row][col];
+        }
+    }
+    return true;
+}
+
+/**
+ * Loads the rpm and load axes of the fuel map.
+ * The file has two lines of FUEL_TABLE_SIZE comma separated values; the first is the rpm axis and
+ * the second is the load axis. Both axes should be increasing.
+ *
+ * @param fileName the file to read
+ * @return true if both axes were loaded, otherwise the axes are left unknown
+ */
+bool loadFuelMapAxes(const char* fileName) {
+    ifstream in(fileName);
+    double rpmAxis[FUEL_TABLE_SIZE];
+    double loadAxis[FUEL_TABLE_SIZE];
+    if (!in || !readFuelMapRow(in, rpmAxis) || !readFuelMapRow(in, loadAxis)) {
+        cout << "Could not load fuel map axes from " << fileName << endl;
+        return false;
+    }
+    for (int i = 0; i < FUEL_TABLE_SIZE; i++) {
+        fuelMapRpmAxis[i] = rpmAxis[i];
+        fuelMapLoadAxis[i] = loadAxis[i];
+    }
+    return true;
+}
+
+/**
+ * Sets all the cells of a table to zero (the default).
+ */
+void clearFuelMapTable(double (&table)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE]) {
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            table[row][col] = 0;
+        }
+    }
+}
+
+/**
+ * Loads the target AFR of each cell (ex. richer targets in boost). Cells set to zero use DEFAULT_TARGET_AFR.
+ *
+ * @param fileName the file to read
+ * @return true if the table was loaded, otherwise DEFAULT_TARGET_AFR is used for all cells
+ */
+bool loadTargetAfrMap(const char* fileName) {
+    if (!readFuelMapTable(fileName, targetAfrMap, true)) {
+        clearFuelMapTable(targetAfrMap);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Loads the number of samples required for each cell before it is corrected. Cells set to zero use
+ * DEFAULT_MIN_CELL_SAMPLES.
+ *
+ * @param fileName the file to read
+ * @return true if the table was loaded, otherwise DEFAULT_MIN_CELL_SAMPLES is used for all cells
+ */
+bool loadMinCellSamplesMap(const char* fileName) {
+    if (!readFuelMapTable(fileName, minCellSamplesMap, true)) {
+        clearFuelMapTable(minCellSamplesMap);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Writes a FUEL_TABLE_SIZE x FUEL_TABLE_SIZE table in the layout read by readFuelMapTable.
+ *
+ * @param fileName the file to write
+ * @param table the values to write
+ * @return true if the table was written
+ */
+bool writeFuelMapTable(const char* fileName, const double (&table)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE]) {
+    ofstream out(fileName, ios::trunc);
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            out << table[row][col];
+            if (col < FUEL_TABLE_SIZE - 1) {
+                out << ",";
+            }
+        }
+        out << "\n";
+    }
+    out.close();
+    if (!out) {
+        cout << "Could not write table to " << fileName << endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Saves the fuel map that is in the PFC, so it can be used when tuning from recorded logs.
+ */
+bool saveCurrentFuelMap(const char* fileName) {
+    return writeFuelMapTable(fileName, currentFuelMap);
+}
+
+/**
+ * Saves the new (proposed) fuel map.
+ */
+bool saveNewFuelMap(const char* fileName) {
+    return writeFuelMapTable(fileName, newFuelMap);
+}
+
+/**
+ * Loads the fuel map that is in the PFC from a file (same layout as the logged fuel map).
+ * Used when the PFC is not connected, ex. when tuning from recorded logs.
+ *
+ * @param fileName the file to read
+ * @return true if the fuel map was loaded
+ */
+bool loadCurrentFuelMap(const char* fileName) {
+    if (!readFuelMapTable(fileName, currentFuelMap)) {
+        return false;
+    }
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            newFuelMap[row][col] = currentFuelMap[row][col];
+        }
+    }
+    return true;
+}
+
+/**
+ * Gets the target AFR of the provided cell.
+ */
+double getTargetAfr(int row, int col) {
+    return targetAfrMap[row][col] > 0 ? targetAfrMap[row][col] : DEFAULT_TARGET_AFR;
+}
+
+/**
+ * Gets the samples (sample weight) required before the provided cell is corrected.
+ */
+double getMinCellSamples(int row, int col) {
+    return minCellSamplesMap[row][col] > 0 ? minCellSamplesMap[row][col] : DEFAULT_MIN_CELL_SAMPLES;
+}
+
+/**
+ * Calculates the fractional position of the provided value on the given axis.
+ * The PFC index is trusted; the axis is only used to find how far the value is towards the next cell.
+ *
+ * @param idx the index reported by the PFC
+ * @param value the actual value (rpm or load)
+ * @param axis the axis of the fuel map
+ * @return the position on the axis (idx..idx+1)
+ */
+double getFuelMapPosition(int idx, double value, const double (&axis)[FUEL_TABLE_SIZE]) {
+    if (idx < 0 || idx >= FUEL_TABLE_SIZE - 1) {
+        return idx;
+    }
+    const double cellSpan = axis[idx + 1] - axis[idx];
+    if (cellSpan <= 0) {
+        // axis unknown (or invalid) around this cell
+        return idx;
+    }
+    double fraction = (value - axis[idx]) / cellSpan;
+    if (fraction < 0) {
+        fraction = 0;
+    } else if (fraction > 1) {
+        fraction = 1;
+    }
+    return idx + fraction;
+}
+
+/**
+ * Calculates the fractional rpm position (column) on the fuel map.
+ *
+ * @param rpmIdx the rpm index reported by the PFC (MapN)
+ * @param rpm the current rpm
+ * @return the position on the rpm axis
+ */
+double getFuelMapRpmPosition(int rpmIdx, double rpm) {
+    return getFuelMapPosition(rpmIdx, rpm, fuelMapRpmAxis);
+}
+
+/**
+ * Calculates the fractional load position (row) on the fuel map.
+ *
+ * @param loadIdx the load index reported by the PFC (MapP)
+ * @param load the current load
+ * @return the position on the load axis
+ */
+double getFuelMapLoadPosition(int loadIdx, double load) {
+    return getFuelMapPosition(loadIdx, load, fuelMapLoadAxis);
+}
+
+/**
+ * Adds a weighted AFR sample to the provided cell.
+ */
+void addWeightedAFR(double (&sumAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                    double (&numAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                    int row, int col, double weight, double afr) {
+    if (weight <= 0 || row >= FUEL_TABLE_SIZE || col >= FUEL_TABLE_SIZE) {
+        return;
+    }
+    sumAfrMap[row][col] += weight * afr;
+    numAfrMap[row][col] += weight;
+}
+
+/**
+ * Adds an AFR sample to the provided tables.
+ * The sample is shared by the four surrounding cells (bilinear weights), so a sample
+ * logged between cells also counts towards its neighbours.
  *
- * @param rpmIdx the row to update
- * @param loadIdx the column to update
+ * @param sumAfrMap the weighted sum of the AFR values
+ * @param numAfrMap the sum of the sample weights
+ * @param rpmPos the (fractional) column to update
+ * @param loadPos the (fractional) row to update
  * @param afr the new AFR value
  */
-void updateAFRData(int rpmIdx, int loadIdx, double afr) {
-    if (rpmIdx >= FUEL_TABLE_SIZE || loadIdx >= FUEL_TABLE_SIZE) {
+void addAFRSample(double (&sumAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  double (&numAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  double rpmPos, double loadPos, double afr) {
+    if (rpmPos < 0 || loadPos < 0 || rpmPos >= FUEL_TABLE_SIZE || loadPos >= FUEL_TABLE_SIZE) {
         throw std::out_of_range("RPM or Load index out of bounds!");
     }
+    const int col = (int) rpmPos;
+    const int row = (int) loadPos;
+    const double colFraction = rpmPos - col;
+    const double rowFraction = loadPos - row;
+
+    addWeightedAFR(sumAfrMap, numAfrMap, row, col, (1 - rowFraction) * (1 - colFraction), afr);
+    addWeightedAFR(sumAfrMap, numAfrMap, row, col + 1, (1 - rowFraction) * colFraction, afr);
+    addWeightedAFR(sumAfrMap, numAfrMap, row + 1, col, rowFraction * (1 - colFraction), afr);
+    addWeightedAFR(sumAfrMap, numAfrMap, row + 1, col + 1, rowFraction * colFraction, afr);
+}
+
+/**
+ * Updates the AFR in the provided position.
+ *
+ * @param rpmPos the (fractional) column to update
+ * @param loadPos the (fractional) row to update
+ * @param afr the new AFR value
+ */
+void updateAFRData(double rpmPos, double loadPos, double afr) {
+    addAFRSample(loggedSumAfrMap, loggedNumAfrMap, rpmPos, loadPos, afr);
     afrSamplesCount++;
+}
 
-    // sum afr values
-    loggedSumAfrMap[loadIdx][rpmIdx] += afr;
+/**
+ * Adds AFR data collected elsewhere (ex. from recorded logs) to the logged AFR data.
+ *
+ * @param sumAfrMap the weighted sum of the AFR values
+ * @param numAfrMap the sum of the sample weights
+ * @param samplesCount the number of samples
+ */
+void mergeAFRData(const double (&sumAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  const double (&numAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  long samplesCount) {
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            loggedSumAfrMap[row][col] += sumAfrMap[row][col];
+            loggedNumAfrMap[row][col] += numAfrMap[row][col];
+        }
+    }
+    afrSamplesCount += samplesCount;
+}
+
+/**
+ * Decides whether an AFR sample should be used for autotune.
+ *
+ * @param afr the AFR reading
+ * @param waterTemp the current water temperature
+ * @param speed the current speed
+ * @param afrPoint the operating point the AFR reading is aligned to
+ * @return AUTOTUNE_GATE_OPEN if the sample should be used, otherwise the reason it should not
+ */
+AutoTuneGate checkAutoTuneGate(double afr, double waterTemp, double speed, const AutoTuneOperatingPoint &afrPoint) {
+    if (afr < MIN_AFR || afr > MAX_AFR) {
+        // AFR value should be within some bounds
+        return AUTOTUNE_GATE_AFR_OUT_OF_BOUNDS;
+    } else if (waterTemp < MIN_AUTOTUNE_WATER_TEMP) {
+        // Engine should be warmed up
+        return AUTOTUNE_GATE_COLD_ENGINE;
+    } else if (afrPoint.rpm < MIN_AUTOTUNE_RPM || afrPoint.rpm > MAX_AUTOTUNE_RPM) {
+        // Engine is actually started and revving up to a certain RPM
+        return AUTOTUNE_GATE_RPM;
+    } else if (afrPoint.tpsChangeRate > MAX_AUTOTUNE_TPS_CHANGE_RATE ||
+               afrPoint.tpsChangeRate < MIN_AUTOTUNE_TPS_CHANGE_RATE) {
+        // Do not auto tune on sudden throttle changes (do not mess with accel enrich etc)
+        return AUTOTUNE_GATE_TPS_CHANGE;
+    } else if (afrPoint.tpsVolt > MAX_AUTOTUNE_TPS_VOLT) {
+        // Do not autotune near WOT
+        return AUTOTUNE_GATE_WOT;
+    } else if (speed > MAX_AUTOTUNE_SPEED) {
+        // Do not autotune when moving.
+        return AUTOTUNE_GATE_MOVING;
+    }
+    return AUTOTUNE_GATE_OPEN;
+}
 
-    // advance number of samples on cell
-    loggedNumAfrMap[loadIdx][rpmIdx]++;
+const char* getAutoTuneGateName(AutoTuneGate gate) {
+    switch (gate) {
+        case AUTOTUNE_GATE_OPEN:
+            return "Active";
+        case AUTOTUNE_GATE_DISABLED:
+            return "Off: Closed Loop Disabled";
+        case AUTOTUNE_GATE_NO_OPERATING_POINT:
+            return "Off: No operating point for AFR";
+        case AUTOTUNE_GATE_AFR_OUT_OF_BOUNDS:
+            return "Off: AFR out of bounds";
+        case AUTOTUNE_GATE_COLD_ENGINE:
+            return "Off: Engine not warmed up";
+        case AUTOTUNE_GATE_RPM:
+            return "Off: RPM to low or to high";
+        case AUTOTUNE_GATE_TPS_CHANGE:
+            return "Off: Accel enrich or decel cut";
+        case AUTOTUNE_GATE_WOT:
+            return "Off: WOT";
+        case AUTOTUNE_GATE_MOVING:
+            return "Off: Moving";
+        default:
+            return "Unknown";
+    }
+}
+
+OperatingPointHistory::OperatingPointHistory() : nextIdx(0), count(0) {
+}
+
+void OperatingPointHistory::clear() {
+    nextIdx = 0;
+    count = 0;
+}
+
+/**
+ * Records the current operating point; the oldest one is dropped when the history is full.
+ *
+ * @param timeMs the monotonic time of the operating point
+ */
+void OperatingPointHistory::record(long timeMs, double rpmPos, double loadPos, double rpm, double load, double tpsVolt) {
+    AutoTuneOperatingPoint &point = points[nextIdx];
+    point.timeMs = timeMs;
+    point.rpmPos = rpmPos;
+    point.loadPos = loadPos;
+    point.rpm = rpm;
+    point.load = load;
+    point.tpsVolt = tpsVolt;
+    point.tpsChangeRate = 0;
+    if (count > 0) {
+        const AutoTuneOperatingPoint &previous = get(0);
+        const long timeDeltaMs = timeMs - previous.timeMs;
+        if (timeDeltaMs > 0) {
+            point.tpsChangeRate = (tpsVolt - previous.tpsVolt) * 1000.0 / timeDeltaMs;
+        }
+    }
+
+    nextIdx = (nextIdx + 1) % OPERATING_POINT_HISTORY_SIZE;
+    if (count < OPERATING_POINT_HISTORY_SIZE) {
+        count++;
+    }
+}
+
+/**
+ * Gets a recorded operating point by age (0 is the latest).
+ */
+const AutoTuneOperatingPoint &OperatingPointHistory::get(int age) const {
+    return points[(nextIdx - 1 - age + OPERATING_POINT_HISTORY_SIZE) % OPERATING_POINT_HISTORY_SIZE];
+}
+
+/**
+ * Finds the operating point that was current at the provided time.
+ *
+ * @param timeMs the time to look for
+ * @param point set to the operating point found
+ * @return false if the history does not cover the provided time
+ */
+bool OperatingPointHistory::findAt(long timeMs, AutoTuneOperatingPoint &point) const {
+    for (int age = 0; age < count; age++) {
+        const AutoTuneOperatingPoint &candidate = get(age);
+        if (candidate.timeMs <= timeMs) {
+            // the next operating point (if any) should follow shortly, otherwise there was a gap in the data
+            const long gapMs = (age == 0 ? timeMs : get(age - 1).timeMs) - candidate.timeMs;
+            if (gapMs > MAX_OPERATING_POINT_GAP_MS) {
+                return false;
+            }
+            point = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Gets the latest recorded operating point.
+ *
+ * @return false if nothing is recorded
+ */
+bool OperatingPointHistory::getLatest(AutoTuneOperatingPoint &point) const {
+    if (count == 0) {
+        return false;
+    }
+    point = get(0);
+    return true;
 }
 
 /**
@@ -216,11 +676,12 @@ int calculateNewFuelMap() {
     int cellsChanged = 0;
     for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
         for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
-            if (loggedNumAfrMap[row][col] >= minCellSamples) {
-                // enough samples logged; re-calc fuel
+            if (loggedNumAfrMap[row][col] >= getMinCellSamples(row, col)) {
+                // enough sample weight logged; re-calc fuel from the weighted average
                 const double loggedAvgAfr = loggedSumAfrMap[row][col] / loggedNumAfrMap[row][col];
-                if (abs(loggedAvgAfr - targetAFR) >= MIN_AFR_DELTA) {
-                    const double newFuel = (loggedAvgAfr / targetAFR) * currentFuelMap[row][col];
+                const double targetAfr = getTargetAfr(row, col);
+                if (abs(loggedAvgAfr - targetAfr) >= MIN_AFR_DELTA) {
+                    const double newFuel = (loggedAvgAfr / targetAfr) * currentFuelMap[row][col];
                     newFuelMap[row][col] = newFuel;
                     cellsChanged++;
                     cout << "Changing fuel at row:" << row
@@ -242,9 +703,11 @@ void syncFuelTablesAndAfrData() {
     for (int row = 0; row < 20; row++) {
         for (int col = 0; col < 20; col++) {
             if (newFuelMap[row][col] != currentFuelMap[row][col]) {
+                // keep the value that the PFC actually holds, so the fuel map checksum matches the next read
+                newFuelMap[row][col] = toHumanFuelValue(toPfcFuelValue(newFuelMap[row][col]));
                 currentFuelMap[row][col] = newFuelMap[row][col];
                 // for each cell that is written to PFC as exact match reset the AFR samples.
-                if (loggedNumAfrMap[row][col] >= minCellSamples) {
+                if (loggedNumAfrMap[row][col] >= getMinCellSamples(row, col)) {
                     // this will exclude cells changed as neighbor cells
                     loggedSumAfrMap[row][col] = 0;
                     loggedNumAfrMap[row][col] = 0;
@@ -289,6 +752,99 @@ bool handleNextFuelMapWriteRequest(int maxWriteRequests) {
     }
 }
 
+/**
+ * Calculates a checksum (FNV-1a) of the fuel map that is currently in the PFC.
+ * The PFC raw cell values are used, so the checksum does not depend on floating point rounding.
+ */
+unsigned int getFuelMapChecksum() {
+    unsigned int checksum = 2166136261u;
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            const int fuelCellValue = toPfcFuelValue(currentFuelMap[row][col]);
+            checksum = (checksum ^ (fuelCellValue & 0xFF)) * 16777619u;
+            checksum = (checksum ^ ((fuelCellValue >> 8) & 0xFF)) * 16777619u;
+        }
+    }
+    return checksum;
+}
+
+/**
+ * Saves the logged AFR data so that autotune can continue after a restart.
+ * The state is tied to the checksum of the current fuel map; it is written to a temporary file
+ * first and then renamed, so a power loss while writing does not corrupt the previous state.
+ *
+ * File layout (native byte order):
+ * magic(4) | version(4) | fuel map checksum(4) | afrSamplesCount(8) | loggedSumAfrMap | loggedNumAfrMap
+ *
+ * @param fileName the state file
+ * @return true if the state was saved
+ */
+bool saveAutoTuneState(const char* fileName) {
+    const string tmpFileName = string(fileName) + ".tmp";
+    ofstream out(tmpFileName.c_str(), ios::binary | ios::trunc);
+    if (!out) {
+        cout << "Could not save autotune state to " << tmpFileName << endl;
+        return false;
+    }
+    const unsigned int checksum = getFuelMapChecksum();
+    const long long samplesCount = afrSamplesCount;
+    out.write(AUTOTUNE_STATE_MAGIC, sizeof(AUTOTUNE_STATE_MAGIC));
+    out.write(reinterpret_cast<const char*>(&AUTOTUNE_STATE_VERSION), sizeof(AUTOTUNE_STATE_VERSION));
+    out.write(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    out.write(reinterpret_cast<const char*>(&samplesCount), sizeof(samplesCount));
+    out.write(reinterpret_cast<const char*>(loggedSumAfrMap), sizeof(loggedSumAfrMap));
+    out.write(reinterpret_cast<const char*>(loggedNumAfrMap), sizeof(loggedNumAfrMap));
+    out.close();
+    if (!out) {
+        cout << "Could not save autotune state to " << tmpFileName << endl;
+        return false;
+    }
+    return rename(tmpFileName.c_str(), fileName) == 0;
+}
+
+/**
+ * Restores the logged AFR data saved by saveAutoTuneState.
+ * The state is only restored when it was saved for the fuel map that is currently in the PFC,
+ * so the fuel map should be read before calling this.
+ *
+ * @param fileName the state file
+ * @return true if the state was restored
+ */
+bool restoreAutoTuneState(const char* fileName) {
+    ifstream in(fileName, ios::binary);
+    if (!in) {
+        return false;
+    }
+    char magic[sizeof(AUTOTUNE_STATE_MAGIC)];
+    unsigned int version = 0;
+    unsigned int checksum = 0;
+    long long samplesCount = 0;
+    in.read(magic, sizeof(magic));
+    in.read(reinterpret_cast<char*>(&version), sizeof(version));
+    in.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+    in.read(reinterpret_cast<char*>(&samplesCount), sizeof(samplesCount));
+    if (!in || memcmp(magic, AUTOTUNE_STATE_MAGIC, sizeof(magic)) != 0 || version != AUTOTUNE_STATE_VERSION) {
+        cout << "Ignoring autotune state " << fileName << ": unknown format" << endl;
+        return false;
+    }
+    if (checksum != getFuelMapChecksum()) {
+        cout << "Ignoring autotune state " << fileName << ": saved for a different fuel map" << endl;
+        return false;
+    }
+    double sumAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
+    double numAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
+    in.read(reinterpret_cast<char*>(sumAfrMap), sizeof(sumAfrMap));
+    in.read(reinterpret_cast<char*>(numAfrMap), sizeof(numAfrMap));
+    if (!in) {
+        cout << "Ignoring autotune state " << fileName << ": truncated" << endl;
+        return false;
+    }
+    memcpy(loggedSumAfrMap, sumAfrMap, sizeof(loggedSumAfrMap));
+    memcpy(loggedNumAfrMap, numAfrMap, sizeof(loggedNumAfrMap));
+    afrSamplesCount = (long) samplesCount;
+    return true;
+}
+
 /**
  * Gets the value of the current fuel map in the provided row/column.
  * @param row the row of the map
@@ -309,6 +865,13 @@ double getNewFuel(int row, int col){
     return newFuelMap[row][col];
 }
 
+/**
+ * Gets the logged AFR sample weight of the provided row/column.
+ */
+double getLoggedAfrWeight(int row, int col) {
+    return loggedNumAfrMap[row][col];
+}
+
 int getCurrentFuelMapWriteRequest() {
     return fuelMapWriteRequest;
 }
@@ -319,7 +882,7 @@ void printLoggedAfrAvg(int printMapSize) {
         for(int c=0; c < printMapSize; c++) {
             const double avgAfr = loggedNumAfrMap[r][c] > 0 ? loggedSumAfrMap[r][c] / loggedNumAfrMap[r][c] : 0;
             cout << setw(4) << fixed << setprecision(1) << avgAfr
-                 << "(" << setw(4) << loggedNumAfrMap[r][c] << ")";
+                 << "(" << setw(4) << setprecision(1) << loggedNumAfrMap[r][c] << ")";
             if (c < printMapSize-1) {
                 cout << " | ";
             }
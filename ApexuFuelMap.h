@@ -32,16 +32,146 @@ static const double MIN_AFR_DELTA = 0.15;
  */
 static const double MAX_FUEL_PERCENTAGE_CHANGE = 0.3;
 
+/**
+ * The target AFR of the cells that are not defined in the target AFR table.
+ */
+static const double DEFAULT_TARGET_AFR = 14.7;
+
+/**
+ * The samples required for the cells that are not defined in the min samples table.
+ */
+static const double DEFAULT_MIN_CELL_SAMPLES = 5;
+
+/**
+ * The number of operating points kept in order to align the AFR readings with the cell that produced them.
+ */
+static const int OPERATING_POINT_HISTORY_SIZE = 32;
+
+/**
+ * Operating points further apart than this are not used for alignment (ex. after a timeout).
+ */
+static const long MAX_OPERATING_POINT_GAP_MS = 1000;
+
+/**
+ * The time it takes for the combustion to show in the wideband reading (exhaust transport and sensor delay).
+ * Used by the live autotune and the offline tool.
+ */
+static const int DEFAULT_AFR_TRANSPORT_DELAY_MS = 250;
+
+/**
+ * The longest AFR transport delay the operating point history covers. A live data cycle (5 requests at 19200 baud)
+ * takes at least ~60ms, so the 32 points span ~1.9s.
+ */
+static const int MAX_AFR_TRANSPORT_DELAY_MS = 1500;
+
+/**
+ * These values depend on the installed wideband sensor.
+ */
+static const double MAX_AFR = 19.8;
+static const double MIN_AFR = 9.8;
+
+/**
+ * The following values decide when autotune will be active.
+ */
+static const double MIN_AUTOTUNE_WATER_TEMP = 65;
+static const double MIN_AUTOTUNE_RPM = 500;
+static const double MAX_AUTOTUNE_RPM = 4000;
+static const double MAX_AUTOTUNE_TPS_CHANGE_RATE = 6; // volt / second, at the operating point the AFR is aligned to
+static const double MIN_AUTOTUNE_TPS_CHANGE_RATE = -6;
+static const double MAX_AUTOTUNE_SPEED = 2; // km/h
+static const double MAX_AUTOTUNE_TPS_VOLT = 2.0;
+
+/**
+ * Identifies the autotune state files; the version should change whenever the file layout changes.
+ */
+static const char AUTOTUNE_STATE_MAGIC[4] = {'P', 'T', 'A', 'T'};
+static const unsigned int AUTOTUNE_STATE_VERSION = 1;
+
 #include <sstream>
 
 using namespace std;
 
+/**
+ * The engine operating point at a given (monotonic) time.
+ */
+struct AutoTuneOperatingPoint {
+    long timeMs;
+    double rpmPos;
+    double loadPos;
+    double rpm;
+    double load;
+    double tpsVolt;
+    double tpsChangeRate; // volt / second, compared to the previous operating point
+};
+
+/**
+ * Whether an AFR sample is used for autotune, and if not why.
+ */
+enum AutoTuneGate {
+    AUTOTUNE_GATE_OPEN = 0,
+    AUTOTUNE_GATE_DISABLED,
+    AUTOTUNE_GATE_NO_OPERATING_POINT,
+    AUTOTUNE_GATE_AFR_OUT_OF_BOUNDS,
+    AUTOTUNE_GATE_COLD_ENGINE,
+    AUTOTUNE_GATE_RPM,
+    AUTOTUNE_GATE_TPS_CHANGE,
+    AUTOTUNE_GATE_WOT,
+    AUTOTUNE_GATE_MOVING,
+    AUTOTUNE_GATE_COUNT
+};
+
+/**
+ * A ring of the latest operating points.
+ * The wideband reading reflects the combustion of a few hundred millis earlier, so each AFR sample
+ * is matched with the operating point recorded one transport delay before.
+ */
+class OperatingPointHistory {
+public:
+    OperatingPointHistory();
+    void clear();
+    void record(long timeMs, double rpmPos, double loadPos, double rpm, double load, double tpsVolt);
+    bool findAt(long timeMs, AutoTuneOperatingPoint &point) const;
+    bool getLatest(AutoTuneOperatingPoint &point) const;
+
+private:
+    const AutoTuneOperatingPoint &get(int age) const;
+
+    AutoTuneOperatingPoint points[OPERATING_POINT_HISTORY_SIZE];
+    int nextIdx;
+    int count;
+};
+
 void readFuelMap(int fuelRequestNumber, const char* rawData);
 char* createFuelMapWritePacket(int fuelRequestNumber, double (&map)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE]);
 char* getNextFuelMapWritePacket();
-void updateAFRData(int rpmIdx, int loadIdx, double afr);
+bool loadFuelMapAxes(const char* fileName);
+bool loadTargetAfrMap(const char* fileName);
+bool loadMinCellSamplesMap(const char* fileName);
+double getTargetAfr(int row, int col);
+double getMinCellSamples(int row, int col);
+double getFuelMapRpmPosition(int rpmIdx, double rpm);
+double getFuelMapLoadPosition(int loadIdx, double load);
+AutoTuneGate checkAutoTuneGate(double afr, double waterTemp, double speed, const AutoTuneOperatingPoint &afrPoint);
+const char* getAutoTuneGateName(AutoTuneGate gate);
+void addAFRSample(double (&sumAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  double (&numAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  double rpmPos, double loadPos, double afr);
+void updateAFRData(double rpmPos, double loadPos, double afr);
+void mergeAFRData(const double (&sumAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  const double (&numAfrMap)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE],
+                  long samplesCount);
+bool writeFuelMapTable(const char* fileName, const double (&table)[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE]);
+bool saveCurrentFuelMap(const char* fileName);
+bool saveNewFuelMap(const char* fileName);
+bool loadCurrentFuelMap(const char* fileName);
+int calculateNewFuelMap();
+double getLoggedAfrWeight(int row, int col);
 bool handleNextFuelMapWriteRequest(int maxWriteRequests);
 
+unsigned int getFuelMapChecksum();
+bool saveAutoTuneState(const char* fileName);
+bool restoreAutoTuneState(const char* fileName);
+
 double getCurrentFuel(int row, int col);
 double getNewFuel(int row, int col);
 int getCurrentFuelMapWriteRequest();
@@ -12,6 +12,8 @@ Rectangle {
 //Timer is inacurate for real timing therefore we use some Javascript to measure time and update the frontend with the measured time via Timer
     property double startTime: 0
     property int msecondsElapsed: 0
+    // The offline tiles are drawn by MapTiles instead of the osm plugin
+    property bool tileCache: AppSettings.getBool("laptimer/tileCache", false)
 
     function restartCounter()  {
 
@@ -57,6 +59,18 @@ Rectangle {
             }
         }
     }
+    Connections{
+        target: Tracks
+        onTracksChanged :{changecountry.change()}
+    }
+    Connections{
+        target: Gps
+        onTrackSelected :{map.center= QtPositioning.coordinate(latitude, longitude),map.zoomLevel = zoomLevel,map.bearing = bearing,map.tilt = 0;if (mapItem.tileCache) MapTiles.prefetchTrack(name, Math.floor(zoomLevel))}
+    }
+    Connections{
+        target: mapItem.tileCache ? MapTiles : null
+        onTilesLoaded :{map.updateTiles()}
+    }
 
     Rectangle{
         anchors.fill: parent
@@ -82,6 +96,15 @@ Rectangle {
             }
 
         }
+        //The offline Map Tiles in /home/pi/maptiles/ are drawn by the tile layer of the map (MapTiles)
+        Plugin {
+            id: tileCachePlugin
+            name: "osm"
+            PluginParameter {
+                name: 'osm.mapping.providersrepository.disabled'
+                value: true
+            }
+        }
 
 
 
@@ -99,7 +122,7 @@ Rectangle {
             id: map
             height : 480
             width : 400
-            plugin: mapPlugin
+            plugin: mapItem.tileCache ? tileCachePlugin : mapPlugin
             zoomLevel: 16
             activeMapType: map.supportedMapTypes[1] //6 is good to get tracks
             copyrightsVisible : false
@@ -107,11 +130,41 @@ Rectangle {
             tilt: 0
             bearing: Dashboard.gpsbaering
             color: "black"
-
+            property int tileZoom: Math.floor(map.zoomLevel)
+            property string tileKey: mapItem.tileCache ? MapTiles.tileKey(map.center.latitude, map.center.longitude, map.tileZoom) : ""
+            // The tiles are only replaced when the centre moves to another tile, so they cover the view
+            // rotated by the bearing plus a tile
+            function updateTiles() {
+                if (!mapItem.tileCache)
+                    return;
+                var radius = Math.sqrt(map.width * map.width + map.height * map.height) / 2 / Math.pow(2, map.zoomLevel - map.tileZoom) + 256;
+                tileLayer.model = MapTiles.tilesAround(map.center.latitude, map.center.longitude, map.tileZoom, radius);
+            }
+            onTileKeyChanged: updateTiles()
+            Component.onCompleted: {if (mapItem.tileCache) MapTiles.load();updateTiles()}
+
+            // Offline tiles, decoded by MapTiles outside the GUI thread
+            MapItemView {
+                id: tileLayer
+                delegate: MapQuickItem {
+                    coordinate: QtPositioning.coordinate(modelData.latitude, modelData.longitude)
+                    zoomLevel: modelData.zoom
+                    anchorPoint.x: 0
+                    anchorPoint.y: 0
+                    sourceItem: Image {
+                        width: 256
+                        height: 256
+                        asynchronous: true
+                        cache: false
+                        source: "image://maptiles/" + modelData.zoom + "/" + modelData.x + "/" + modelData.y
+                    }
+                }
+            }
 
             // Draw a small red circle for current Vehicle Location
             MapQuickItem {
                 id: marker
+                z: 1
                 anchorPoint.x: 10
                 anchorPoint.y: 10
                 width: 15
@@ -131,8 +184,7 @@ Rectangle {
             height: 30
             anchors.left: map.right
             font.pixelSize: 20
-            //model: [ "Current Position","Australia","Germany","New Zealand","South Africa","United Kingdom","USA"]
-            model: ["Current Position","Australia","Germany","New Zealand","Malaysia","South Africa","USA"]
+            model: ["Current Position","Tracks"]
             delegate: ItemDelegate {
                 width: countryselect.width
                 text: countryselect.textRole ? (Array.isArray(control.model) ? modelData[control.textRole] : model[control.textRole]) : modelData
@@ -150,7 +202,7 @@ Rectangle {
             height: 30
             anchors.left: countryselect.right
             font.pixelSize: 20
-            model: [ "Wakefield Park"]
+            model: ["Tilt 0", "Tilt 45"]
             delegate: ItemDelegate {
                 width: trackselect.width
                 text: trackselect.textRole ? (Array.isArray(control.model) ? modelData[control.textRole] : model[control.textRole]) : modelData
@@ -184,7 +236,7 @@ Rectangle {
         }
         Grid {
             id:grid1
-            rows: 3
+            rows: 5
             columns: 2
             spacing: 5
             anchors.left: map.right
@@ -225,6 +277,26 @@ Rectangle {
                 font.bold: true
                 color: "#00ff00"
                 font.family: "Eurostile"}
+            Text { text: "Delta: "
+                font.pixelSize: 15
+                font.bold: true
+                color: "white"
+                font.family: "Eurostile"}
+            Text { text: (Dashboard.lapdelta > 0 ? "+" : "") + Dashboard.lapdelta.toFixed(2)
+                font.pixelSize: 30
+                font.bold: true
+                color: Dashboard.lapdelta > 0 ? "orangered" : "#00ff00"
+                font.family: "Eurostile"}
+            Text { text: "Last Sector: "
+                font.pixelSize: 15
+                font.bold: true
+                color: "white"
+                font.family: "Eurostile"}
+            Text { text: Dashboard.sectortime
+                font.pixelSize: 30
+                font.bold: true
+                color: "white"
+                font.family: "Eurostile"}
 
 
             Text { text: "GPS FIX type: "
@@ -313,14 +385,8 @@ Rectangle{
 
                 if (countryselect.textAt(countryselect.currentIndex) == "Current Position"){trackselect.model = ["Tilt 0", "Tilt 45"],map.center= QtPositioning.coordinate(-25.804219,28.300091)};
                 //if (countryselect.textAt(countryselect.currentIndex) == "Current Position"){trackselect.model = ["Tilt 0", "Tilt 45"],map.center= QtPositioning.coordinate(Dashboard.gpsLatitude,Dashboard.gpsLongitude)};
-                if (countryselect.textAt(countryselect.currentIndex) == "Australia"){trackselect.model = ["Barbagallo Raceway","Carrnell Raceway","Collie Motorplex","Wakefield Park"]};
-                if (countryselect.textAt(countryselect.currentIndex) == "Germany"){trackselect.model = ["Hockenheim","Nürburgring"]};
-                if (countryselect.textAt(countryselect.currentIndex) == "New Zealand"){trackselect.model = ["Pukekohe Park"]};
-                if (countryselect.textAt(countryselect.currentIndex) == "Malaysia"){trackselect.model = ["Sepang"]};
-
-                if (countryselect.textAt(countryselect.currentIndex) == "South Africa"){trackselect.model = ["Dezzi","Midvaal","Phakisa","Redstar","Zwartkops"]};
-                //if (countryselect.textAt(countryselect.currentIndex) == "United Kingdom"){trackselect.model = ["Silverstone"]};
-                if (countryselect.textAt(countryselect.currentIndex) == "USA"){trackselect.model = ["Buttonwillow"]};
+                // the tracks of the track database (Tracks.txt); selecting one sets its finish line and sectors
+                if (countryselect.textAt(countryselect.currentIndex) == "Tracks"){trackselect.model = Tracks.names};
                 console.log(countryselect.textAt(countryselect.currentIndex))
                 changetrack.change()
             }
@@ -332,21 +398,7 @@ Rectangle{
                 console.log(trackselect.textAt(trackselect.currentIndex))
                 if (trackselect.textAt(trackselect.currentIndex) == "Tilt 0"){map.tilt = 0};
                 if (trackselect.textAt(trackselect.currentIndex) == "Tilt 45"){map.tilt = 45};
-                if (trackselect.textAt(trackselect.currentIndex) == "Bruce McLaren Motorsport Park"){map.center= QtPositioning.coordinate(-38.666331,176.1430453,17),map.zoomLevel = 15.6,map.bearing  = 43,map.tilt = 0};
-                if (trackselect.textAt(trackselect.currentIndex) == "Redstar"){map.center= QtPositioning.coordinate(-26.074283, 28.751711),map.zoomLevel = 16,map.bearing  = 0,map.tilt = 0,Gps.defineFinishLine(-26.075097, 28.755060,-26.075111,28.755229,1)};
-                if (trackselect.textAt(trackselect.currentIndex) == "Utah Motorsport Park"){map.center= QtPositioning.coordinate(40.579618,-112.3805621,398),map.zoomLevel = 15.1 ,map.bearing  = 90,map.tilt = 0};
-                if (trackselect.textAt(trackselect.currentIndex) == "Wakefield Park"){map.center= QtPositioning.coordinate(-34.840764,149.686800),map.zoomLevel = 16,map.tilt = 0,map.bearing  = 0,Gps.defineFinishLine(-34.840111,149.685229,-34.840172,149.685433,1)};
-                if (trackselect.textAt(trackselect.currentIndex) == "Nürburgring"){map.center= QtPositioning.coordinate(50.358917, 6.965215),map.zoomLevel = 16,map.bearing  = 0,map.tilt = 0};
-                if (trackselect.textAt(trackselect.currentIndex) == "Zwartkops"){map.center= QtPositioning.coordinate(-25.809960, 28.111175),map.zoomLevel = 16.6,map.bearing  = 0,map.tilt = 0,Gps.defineFinishLine(-25.809477,28.112105,-25.809404,28.112276,1)};
-                if (trackselect.textAt(trackselect.currentIndex) == "Pukekohe Park"){map.center= QtPositioning.coordinate(-37.215300, 174.919707),map.zoomLevel = 15.6,map.tilt = 0,map.bearing  = 0,Gps.defineFinishLine(-37.215564,174.915710,-37.215510, 174.915914,1)}
-                if (trackselect.textAt(trackselect.currentIndex) == "Carrnell Raceway"){map.center= QtPositioning.coordinate(-28.685079, 151.938694),map.zoomLevel = 17,map.tilt = 0,map.bearing  = 22}
-                if (trackselect.textAt(trackselect.currentIndex) == "Phakisa"){map.center= QtPositioning.coordinate(-27.904231, 26.713996),map.zoomLevel = 15.6,map.tilt = 0,map.bearing  = 22}
-                if (trackselect.textAt(trackselect.currentIndex) == "Midvaal"){map.center= QtPositioning.coordinate(-26.612376, 28.059484),map.zoomLevel = 16,map.tilt = 0,map.bearing  = 22,Gps.defineFinishLine(-26.613392, 28.058586,-26.613509,28.058717,1)}
-                if (trackselect.textAt(trackselect.currentIndex) == "Dezzi"){map.center= QtPositioning.coordinate(-30.770474, 30.426004),map.zoomLevel = 16,map.tilt = 0,map.bearing  = 22}
-                if (trackselect.textAt(trackselect.currentIndex) == "Buttonwillow"){map.center= QtPositioning.coordinate(35.491242, -119.545396),map.zoomLevel = 15.4,map.tilt = 0,map.bearing  = 0,Gps.defineFinishLine(35.488681,-119.544514,35.488858,-119.544521,2)}
-                if (trackselect.textAt(trackselect.currentIndex) == "Sepang"){map.center= QtPositioning.coordinate(2.760217, 101.738092),map.zoomLevel = 15.6,map.tilt = 0,map.bearing  = 0,Gps.defineFinishLine(2.760652,101.738394,2.760894,101.738374,2)}
-                if (trackselect.textAt(trackselect.currentIndex) == "Barbagallo Raceway"){map.center= QtPositioning.coordinate(-31.664326, 115.789962),map.zoomLevel = 15.7,map.tilt = 0,map.bearing  = 0,Gps.defineFinishLine(-31.664168,115.786292,-31.664171,115.786459,1)}
-                if (trackselect.textAt(trackselect.currentIndex) == "Collie Motorplex"){map.center= QtPositioning.coordinate(-33.431971, 116.244369),map.zoomLevel = 16,map.tilt = 0,map.bearing  = 0,Gps.defineFinishLine(-33.430061,116.243180,-33.430184, 116.243386,1)}
+                if (countryselect.textAt(countryselect.currentIndex) == "Tracks" && trackselect.currentIndex >= 0){Gps.selectTrack(trackselect.textAt(trackselect.currentIndex))};
 
             }
         }
@@ -22,7 +22,11 @@ Item {
             id: startButton
             text: "Start"
             onClicked: {
-                if (refreshTimer.running == false) refreshTimer.running = true;
+                if (refreshTimer.running == false) {
+                    ChannelHistory.track("rpm");
+                    ChannelHistory.track("speed");
+                    refreshTimer.running = true;
+                }
 
 
             }
@@ -36,10 +40,11 @@ Item {
             }
         }
 }
+        // seconds, 0 is now
         ValueAxis {
             id: axisX
-            min: 0
-            max: 100
+            min: -60
+            max: 0
             tickCount: 5
         }
 
@@ -54,14 +59,14 @@ Item {
             max: 300
         }
 
-        SplineSeries {
+        LineSeries {
             id: series1
             name: "RPM"
             axisX: axisX
             axisY: axisY1
         }
 
-        SplineSeries {
+        LineSeries {
             id: series2
             name: "SPEED"
             axisX: axisX
@@ -72,40 +77,16 @@ Item {
     //
 
 
-    // Add data dynamically to the series
+    // The samples are recorded in C++ at the rate they are received; this only refreshes the view
     Timer {
-        property int amountOfData: 0 //So we know when we need to start
-        property int timeline: 0 // Start of the timeline
         id: refreshTimer
-        interval: 50
+        interval: 100
         running: false
         repeat: true
         onTriggered: {
-
-
-               timeline++;
-               amountOfData++; //This else is just to stop incrementing the variable unnecessarily
-
-                //series1.append(timeline, 3000);
-                //series2.append(timeline, 250);
-                series1.append(timeline, Dashboard.revs);
-                series2.append(timeline, Dashboard.speed);
-
-                if(amountOfData > axisX.max){
-                    axisX.min++;
-                    axisX.max++;
-                }
-
-
-                //remove all data points that are not visible anymore
-               if (series1.count > 100){
-
-                   series1.remove(0);
-                   series2.remove(0);
-
-                    console.log (series1.count);}
-
- }
+            ChannelHistory.updateSeries(series1, "rpm", -axisX.min, chartView.plotArea.width);
+            ChannelHistory.updateSeries(series2, "speed", -axisX.min, chartView.plotArea.width);
+        }
 }
     Rectangle{
     anchors.fill: parent
@@ -1087,6 +1087,42 @@ ListModel {
         stepsize : "20"
         divisor : "1"
     }
+    ListElement {
+        sourcename:"fusedHeading"
+        defaultsymbol: "°"
+        titlename:"Fused Heading"
+        decimalpoints : "0"
+        maxvalue : "360"
+        stepsize : "90"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"fusedLatitude"
+        defaultsymbol: ""
+        titlename:"Fused Latitude"
+        decimalpoints : "6"
+        maxvalue : "1"
+        stepsize : "1"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"fusedLongitude"
+        defaultsymbol: ""
+        titlename:"Fused Longitude"
+        decimalpoints : "6"
+        maxvalue : "1"
+        stepsize : "1"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"fusedSpeed"
+        defaultsymbol: "kph"
+        titlename:"Fused Speed"
+        decimalpoints : "0"
+        maxvalue : "320"
+        stepsize : "40"
+        divisor : "1"
+    }
     ListElement {
         sourcename:"Gear"
         defaultsymbol: ""
@@ -1931,6 +1967,78 @@ ListModel {
         stepsize : "10"
         divisor : "1"
     }
+    ListElement {
+        sourcename:"Mathchannel1"
+        defaultsymbol: ""
+        titlename:"Math Channel 1"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel2"
+        defaultsymbol: ""
+        titlename:"Math Channel 2"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel3"
+        defaultsymbol: ""
+        titlename:"Math Channel 3"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel4"
+        defaultsymbol: ""
+        titlename:"Math Channel 4"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel5"
+        defaultsymbol: ""
+        titlename:"Math Channel 5"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel6"
+        defaultsymbol: ""
+        titlename:"Math Channel 6"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel7"
+        defaultsymbol: ""
+        titlename:"Math Channel 7"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
+    ListElement {
+        sourcename:"Mathchannel8"
+        defaultsymbol: ""
+        titlename:"Math Channel 8"
+        decimalpoints : "2"
+        maxvalue : "100000"
+        stepsize : "10"
+        divisor : "1"
+    }
     ListElement {
         sourcename:"wastegatepress"
         defaultsymbol: "kPa"
@@ -4,18 +4,26 @@ import QtQuick.Controls 2.1
 
 Item {
     anchors.fill: parent
-    property double finalPower
-    property double finalTorque
-    property int finalTorqueRPM
-    property int finalPowerRPM
-    property double previousrpm
     property var powertext
     property var torquetext
     property var unit : Dashboard.units;
-    Component.onCompleted: {units.unitadjust()} // adjusts the Gauges to metric or imperial
+    Component.onCompleted: {units.unitadjust(),Dyno.readSavedRuns()} // adjusts the Gauges to metric or imperial
+
+    // the run is captured and binned by Dyno, the page only draws the finished curves
+    Connections {
+        target: Dyno
+        onRunFinished: {
+            Dyno.updateSeries(series1, "Power");
+            Dyno.updateSeries(series2, "Torque");
+        }
+        onCompareChanged: {
+            Dyno.updateSeries(series3, "ComparePower");
+            Dyno.updateSeries(series4, "CompareTorque");
+        }
+    }
 
     ChartView {
-        title: "PowerTune Virtual Dyno V1.0"
+        title: "PowerTune Virtual Dyno V1.0 (" + Dyno.state + ")"
         titleColor: "white"
         titleFont.pixelSize: parent.width /40
         id: chartView
@@ -33,8 +41,9 @@ Item {
             Button {
                 id: startButton
                 text: "Start"
+                enabled: Dyno.state == "idle" || Dyno.state == "finished"
                 onClicked: {
-                    if (refreshTimer.running == false) refreshTimer.running = true ,series2.clear(),series1.clear(), previousrpm = Dashboard.rpm, finalPower =0, finalTorque =0, finalTorqueRPM = 0, finalPowerRPM =0,startButton.enabled =false;
+                    series2.clear(),series1.clear(),Dyno.arm();
 
 
                 }
@@ -43,10 +52,27 @@ Item {
                 id: stopButton
                 text: "clear"
                 onClicked: {
-                    series2.clear(),series1.clear(),startButton.enabled =true;
+                    Dyno.cancel(),series2.clear(),series1.clear();
 
                 }
             }
+            Button {
+                id: saveButton
+                text: "Save"
+                enabled: Dyno.state == "finished"
+                onClicked: {
+                    Dyno.saveRun(Qt.formatDateTime(new Date(), "yyyyMMdd_hhmmss"));
+                }
+            }
+            ComboBox {
+                id: compareRun
+                width: chartView.width / 4
+                model: ["Compare"].concat(Dyno.savedRuns)
+                onActivated: {
+                    if (index == 0) Dyno.clearCompareRun();
+                    else Dyno.loadCompareRun(currentText);
+                }
+            }
         }
         ValueAxis {
             id: axisX
@@ -71,47 +97,34 @@ Item {
         }
 
 
-        SplineSeries {
+        LineSeries {
             id: series1
-            name: "Power " + finalPower + " " + powertext +" @" + finalPowerRPM + " RPM"
+            name: "Power " + Dyno.peakPower.toFixed(1) + " " + powertext +" @" + Dyno.peakPowerRpm + " RPM"
             axisX: axisX
             axisY: axisY1
         }
 
-        SplineSeries {
+        LineSeries {
             id: series2
-            name: "Torque " + finalTorque + " " + torquetext +" @" + finalTorqueRPM + " RPM"
+            name: "Torque " + Dyno.peakTorque.toFixed(1) + " " + torquetext +" @" + Dyno.peakTorqueRpm + " RPM"
             axisX: axisX
             axisY: axisY1
         }
-    }
-
-    //
 
+        LineSeries {
+            id: series3
+            name: "Compare " + Dyno.comparePeakPower.toFixed(1) + " " + powertext
+            style: Qt.DashLine
+            axisX: axisX
+            axisY: axisY1
+        }
 
-    // Add data dynamically to the series
-    Timer {
-
-        id: refreshTimer
-        interval: 50
-        running: false
-        repeat: true
-        onTriggered: {
-
-            if (previousrpm <= Dashboard.rpm)
-            {
-
-            previousrpm = Dashboard.rpm
-
-            if (finalPower < Dashboard.Power)
-            {finalPower = (Dashboard.Power).toFixed(1),finalPowerRPM = Dashboard.rpm}
-            if (finalTorque < Dashboard.Torque)
-            {finalTorque = (Dashboard.Torque).toFixed(1) ,finalTorqueRPM = Dashboard.rpm}
-            series1.append(Dashboard.rpm, Dashboard.Power);
-            series2.append(Dashboard.rpm, Dashboard.Torque);
-            }
-            if (previousrpm > Dashboard.rpm) {refreshTimer.running = false,startButton.enabled =true}
-
+        LineSeries {
+            id: series4
+            name: "Compare " + Dyno.comparePeakTorque.toFixed(1) + " " + torquetext
+            style: Qt.DashLine
+            axisX: axisX
+            axisY: axisY1
         }
     }
 
@@ -24,7 +24,24 @@ SOURCES += main.cpp \
     calculations.cpp \
     udpreceiver.cpp \
     arduino.cpp \
-    wifiscanner.cpp
+    wifiscanner.cpp \
+    channelsmoother.cpp \
+    unitconversion.cpp \
+    channelnotifyfilter.cpp \
+    channelhistory.cpp \
+    dynorun.cpp \
+    derivedchannels.cpp \
+    mathexpression.cpp \
+    mathchannels.cpp \
+    odometerjournal.cpp \
+    nmeaparser.cpp \
+    ubxparser.cpp \
+    laptrace.cpp \
+    trackdatabase.cpp \
+    gpsimufusion.cpp \
+    imubuffer.cpp \
+    maptilecache.cpp \
+    sampleclock.cpp
 
 
 RESOURCES += qml.qrc
@@ -50,7 +67,24 @@ HEADERS += \
     calculations.h \
     udpreceiver.h \
     arduino.h \
-    wifiscanner.h
+    wifiscanner.h \
+    channelsmoother.h \
+    unitconversion.h \
+    channelnotifyfilter.h \
+    channelhistory.h \
+    dynorun.h \
+    derivedchannels.h \
+    mathexpression.h \
+    mathchannels.h \
+    odometerjournal.h \
+    nmeaparser.h \
+    ubxparser.h \
+    laptrace.h \
+    trackdatabase.h \
+    gpsimufusion.h \
+    imubuffer.h \
+    maptilecache.h \
+    sampleclock.h
 
 
 FORMS +=
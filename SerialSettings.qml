@@ -87,10 +87,12 @@ Quick1.TabView {
                     property alias serialPortName: serialName.currentText
                     property alias gpsPortName: serialNameGPS.currentText
                     property alias gpsPortNameindex: serialNameGPS.currentIndex
+                    property alias gpsModeindex: gpsMode.currentIndex
                     //property alias gpsBaud: serialGPSBaud.currentText
                     //property alias gpsBaudindex: serialGPSBaud.currentIndex
                     property alias ecuType: ecuSelect.currentText
                     property alias closedLoop: closedLoopSwitch.checked
+                    property alias afrTransportDelay: afrDelay.text
                     property alias auxunit1: unitaux1.text
                     property alias aux1: aux1V0.text
                     property alias aux2: aux1V5.text
@@ -106,11 +108,13 @@ Quick1.TabView {
                     property alias unitSelector1: unitSelect1.currentIndex
                     property alias unitSelector: unitSelect.currentIndex
                     property alias unitSelector2: unitSelect2.currentIndex
-                    property alias odometervalue: odometer.text
-                    property alias tripmetervalue: tripmeter.text
+                    // the odometer is kept by Calculations; only read to take over the values of older versions
+                    property string odometervalue
+                    property string tripmetervalue
                     //property alias protocol : protocol.currentIndex
                     property alias smoothingrpm : smoothrpm.currentIndex
                     property alias smoothingspeed : smoothspeed.currentIndex
+                    Component.onCompleted: { if (odometervalue !== "") Calculations.restoreOdometer(odometervalue, tripmetervalue); }
 
 
                 }
@@ -190,6 +194,27 @@ Quick1.TabView {
                                 hoverEnabled: serialNameGPS.hoverEnabled
                             }
                         }
+                        Text {
+                            text: "GPS Mode: "
+                            font.pixelSize: windowbackround.width / 55
+                            color: "white"
+                        }
+                        ComboBox {
+                            id: gpsMode
+                            width: windowbackround.width / 5
+                            height: windowbackround.height /15
+                            font.pixelSize: windowbackround.width / 55
+                            model: ["NMEA 10Hz", "UBX 10Hz", "UBX 25Hz"]
+                            delegate: ItemDelegate {
+                                width: gpsMode.width
+                                text: gpsMode.textRole ? (Array.isArray(control.model) ? modelData[control.textRole] : model[control.textRole]) : modelData
+                                font.weight: gpsMode.currentIndex == index ? Font.DemiBold : Font.Normal
+                                font.family: gpsMode.font.family
+                                font.pixelSize: gpsMode.font.pixelSize
+                                highlighted: gpsMode.highlightedIndex == index
+                                hoverEnabled: gpsMode.hoverEnabled
+                            }
+                        }
                         Text {
                             text: "Speed units:"
                             font.pixelSize: windowbackround.width / 55
@@ -342,6 +367,20 @@ Quick1.TabView {
                             }
                             onCheckedChanged: closedLoopItem.toggle()
                         }
+                        Text {
+                            text: "AFR Delay (ms):"
+                            font.pixelSize: windowbackround.width / 55
+                            color: "white"
+                        }
+                        TextField {
+                            id: afrDelay
+                            width: windowbackround.width / 5
+                            height: windowbackround.height /15
+                            font.pixelSize: windowbackround.width / 55
+                            text: "250"
+                            inputMethodHints: Qt.ImhDigitsOnly
+                            onTextChanged: Apexi.setAfrTransportDelay(afrDelay.text)
+                        }
                         Text
                         {
                             text: "Odo:"
@@ -353,7 +392,7 @@ Quick1.TabView {
                             width: windowbackround.width / 5
                             height: windowbackround.height /15
                             font.pixelSize: windowbackround.width / 55
-                            text: qsTr("0")
+                            text: (Dashboard.Odo).toFixed(0)
                             inputMethodHints: Qt.ImhFormattedNumbersOnly
                             //enterKeyAction: EnterKeyAction.Next
                         }
@@ -370,8 +409,7 @@ Quick1.TabView {
                             height: windowbackround.height /15
                             font.pixelSize: windowbackround.width / 55
                             readOnly: true
-                            text: "0"
-                            Component.onCompleted: Dashboard.setTrip(tripmeter.text)
+                            text: (Dashboard.Trip).toFixed(1)
                         }
 
                         Text
@@ -724,6 +762,7 @@ Quick1.TabView {
                     // if (gpsswitch.checked == true)GPS.startGPScom(serialNameGPS.currentText,serialGPSBaud.currentText);
                     if (connectButtonGPS.enabled == false)
                     {
+                        Gps.setMode(gpsMode.currentIndex)
                         Gps.openConnection(serialNameGPS.currentText,"9600")
                         disconnectButtonGPS.enabled=true
                     }
@@ -1046,6 +1085,7 @@ Quick1.TabView {
                     property alias compassswitch: compass.checked
                     property alias tempswitch: tempsense.checked
                     property alias pressureswitch:pressuresens.checked
+                    property alias imurateindex: imuRate.currentIndex
 
                 }
 
@@ -1055,6 +1095,29 @@ Quick1.TabView {
                     spacing: senhatselector.width / 150
                     anchors.top :parent.top
                     anchors.topMargin: parent.height / 20
+                    Text {
+                        text: "IMU rate (Hz):"
+                        font.pixelSize: senhatselector.width / 55
+                        color: "white"
+                    }
+                    ComboBox {
+                        id: imuRate
+                        width: senhatselector.width / 5
+                        height: senhatselector.height /15
+                        font.pixelSize: senhatselector.width / 55
+                        model: [100, 200, 50]
+                        // set before the sensors are started by the switches below
+                        onCurrentIndexChanged: Sens.setImuRate(model[currentIndex])
+                        delegate: ItemDelegate {
+                            width: imuRate.width
+                            text: imuRate.textRole ? (Array.isArray(control.model) ? modelData[control.textRole] : model[control.textRole]) : modelData
+                            font.weight: imuRate.currentIndex == index ? Font.DemiBold : Font.Normal
+                            font.family: imuRate.font.family
+                            font.pixelSize: imuRate.font.pixelSize
+                            highlighted: imuRate.highlightedIndex == index
+                            hoverEnabled: imuRate.hoverEnabled
+                        }
+                    }
                     Switch {
                         id: accelsens
                         text: qsTr("Accelerometer")
@@ -1096,6 +1159,15 @@ Quick1.TabView {
                         }
                         Component.onCompleted: tabView.currentIndex = 3 // opens the 4th tab
                     }
+                    Button {
+                        id: calibrateImu
+                        text: "Calibrate IMU"
+                        width: senhatselector.width / 5
+                        height: senhatselector.height /15
+                        font.pixelSize: senhatselector.width / 55
+                        // the car has to stand still for a second
+                        onClicked: Sens.calibrateImu()
+                    }
 
 
                 }
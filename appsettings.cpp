@@ -2,9 +2,66 @@
 #include <QSettings>
 #include <QDebug>
 
-AppSettings::AppSettings(QObject *parent) : QObject(parent)
+AppSettings::AppSettings(QObject *parent)
+    : QObject(parent)
+    , m_settings("PowerTuneQML", "PowerTuneQMLGUI")
 {
+    foreach (const QString &key, m_settings.allKeys())
+        m_cache.insert(key, m_settings.value(key));
+    m_writeTimer.setSingleShot(true);
+    m_writeTimer.setInterval(WRITE_DELAY_MS);
+    connect(&m_writeTimer, &QTimer::timeout, this, &AppSettings::writePending);
+}
+
+AppSettings::~AppSettings()
+{
+    sync();
+}
+
+int AppSettings::getInt(const QString &key, const int &defaultValue) const
+{
+    return getValue(key, defaultValue).toInt();
+}
+
+qreal AppSettings::getReal(const QString &key, const qreal &defaultValue) const
+{
+    return getValue(key, defaultValue).toReal();
+}
+
+bool AppSettings::getBool(const QString &key, const bool &defaultValue) const
+{
+    return getValue(key, defaultValue).toBool();
+}
+
+QString AppSettings::getString(const QString &key, const QString &defaultValue) const
+{
+    return getValue(key, defaultValue).toString();
+}
 
+void AppSettings::setInt(const QString &key, const int &value)
+{
+    setValue(key, value);
+}
+
+void AppSettings::setReal(const QString &key, const qreal &value)
+{
+    setValue(key, value);
+}
+
+void AppSettings::setBool(const QString &key, const bool &value)
+{
+    setValue(key, value);
+}
+
+void AppSettings::setString(const QString &key, const QString &value)
+{
+    setValue(key, value);
+}
+
+void AppSettings::sync()
+{
+    m_writeTimer.stop();
+    writePending();
 }
 
 int AppSettings::getBaudRate()
@@ -92,12 +149,28 @@ void AppSettings::setLogging(const int &arg)
 
 void AppSettings::setValue(const QString &key, const QVariant &value)
 {
-    QSettings settings("PowerTuneQML", "PowerTuneQMLGUI", this);
-    settings.setValue(key, value);
+    QHash<QString, QVariant>::iterator cached = m_cache.find(key);
+    if (cached != m_cache.end() && *cached == value)
+        return;
+    m_cache.insert(key, value);
+    m_pending.insert(key);
+    // restarted on every change, so a burst of changes is written once
+    m_writeTimer.start();
+}
+
+QVariant AppSettings::getValue(const QString &key, const QVariant &defaultValue) const
+{
+    return m_cache.value(key, defaultValue);
 }
 
-QVariant AppSettings::getValue(const QString &key)
+void AppSettings::writePending()
 {
-    QSettings settings("PowerTuneQML", "PowerTuneQMLGUI", this);
-    return settings.value(key);
+    if (m_pending.isEmpty())
+        return;
+    foreach (const QString &key, m_pending)
+        m_settings.setValue(key, m_cache.value(key));
+    m_pending.clear();
+    m_settings.sync();
+    if (m_settings.status() != QSettings::NoError)
+        qDebug() << "Could not write settings" << m_settings.fileName();
 }
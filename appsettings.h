@@ -2,12 +2,36 @@
 #define APPSETTINGS_H
 
 #include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QVariant>
+#include <QSettings>
+#include <QTimer>
 
+/*
+ * The settings are read once into a cache; the getters never touch the settings file.
+ * Changes are written behind, WRITE_DELAY_MS after the last change, so a slider
+ * being dragged does not write the SD card on every step.
+ */
 class AppSettings : public QObject
 {
     Q_OBJECT
 public:
+    static const int WRITE_DELAY_MS = 1000;
+
     explicit AppSettings(QObject *parent = 0);
+    ~AppSettings();
+
+    Q_INVOKABLE int getInt(const QString &key, const int &defaultValue = 0) const;
+    Q_INVOKABLE qreal getReal(const QString &key, const qreal &defaultValue = 0) const;
+    Q_INVOKABLE bool getBool(const QString &key, const bool &defaultValue = false) const;
+    Q_INVOKABLE QString getString(const QString &key, const QString &defaultValue = QString()) const;
+    Q_INVOKABLE void setInt(const QString &key, const int &value);
+    Q_INVOKABLE void setReal(const QString &key, const qreal &value);
+    Q_INVOKABLE void setBool(const QString &key, const bool &value);
+    Q_INVOKABLE void setString(const QString &key, const QString &value);
+    // Writes the pending changes now
+    Q_INVOKABLE void sync();
 
     Q_INVOKABLE int getBaudRate();
     Q_INVOKABLE void setBaudRate(const int &arg);
@@ -35,9 +59,17 @@ public:
 
 
 
+private slots:
+    void writePending();
+
 private:
     void setValue(const QString &key, const QVariant &value);
-    QVariant getValue(const QString &key);
+    QVariant getValue(const QString &key, const QVariant &defaultValue = QVariant()) const;
+
+    QSettings m_settings;
+    QHash<QString, QVariant> m_cache;
+    QSet<QString> m_pending;
+    QTimer m_writeTimer;
 };
 
 #endif // APPSETTINGS_H
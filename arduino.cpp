@@ -80,6 +80,7 @@ void Arduino::handleError(QSerialPort::SerialPortError serialPortError)
 
 void Arduino::readyToRead()
 {
+    SampleTimeScope received(m_dashboard, SampleClock::now());
     QByteArray test;
     test =m_readData = m_serialport->readAll();
     QString fileName = "AdaptronicOutputTest.txt";
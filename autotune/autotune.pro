@@ -0,0 +1,15 @@
+# Offline autotune; proposes a fuel map from recorded Apexi logs (see autotunebatch.cpp).
+TEMPLATE = app
+TARGET = autotune
+
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+LIBS += -pthread
+QMAKE_CXXFLAGS += -pthread
+
+INCLUDEPATH += ..
+
+SOURCES += autotunebatch.cpp \
+    ../ApexiFuelMap.cpp
+
+HEADERS += ../ApexuFuelMap.h
@@ -0,0 +1,289 @@
+/**
+ * Offline autotune; proposes a fuel map from recorded Apexi logs.
+ *
+ * The logs are the ones written by the datalogger while connected to the PFC (Apexi layout).
+ * The same fuel map code and gating rules of the live autotune are used, so the outcome is
+ * the same as driving the logs with the PFC connected, minus the fuel map writes.
+ *
+ * Usage:
+ *   autotune --map FuelMap.csv [--axes FuelMapAxes.csv] [--target TargetAfrMap.csv]
+ *            [--min-samples MinCellSamplesMap.csv] [--delay ms] [--load-column name]
+ *            [--imperial] [--threads n] [--out prefix] log1.csv [log2.csv ...]
+ *
+ * Writes <prefix>_fuel.csv (the proposed fuel map) and <prefix>_confidence.csv
+ * (logged sample weight / required samples per cell, capped to 1).
+ */
+#include "ApexuFuelMap.h"
+#include <stdexcept>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdlib>
+#include <cmath>
+
+using namespace std;
+
+/**
+ * The datalogger columns used for autotune.
+ */
+const char* TIME_COLUMN = "Time(S)";
+const char* RPM_COLUMN = "RPM";
+const char* SPEED_COLUMN = "Speed";
+const char* WATER_TEMP_COLUMN = "WtrTemp";
+const char* AFR_COLUMN = "WideBand";
+const char* LOAD_IDX_COLUMN = "MAPP";
+const char* RPM_IDX_COLUMN = "MAPN";
+const char* TPS_VOLT_COLUMN = "VTA V";
+
+struct AutoTuneOptions {
+    string mapFile;
+    string axesFile;
+    string targetFile;
+    string minSamplesFile;
+    string loadColumn;
+    string outPrefix = "AutoTune";
+    int delayMs = DEFAULT_AFR_TRANSPORT_DELAY_MS;
+    int threads = 0;
+    bool imperial = false;
+    vector<string> logFiles;
+};
+
+/**
+ * The AFR data collected from a single log.
+ */
+struct LogResult {
+    double sumAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
+    double numAfrMap[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
+    long rows;
+    long samples;
+    long gateCount[AUTOTUNE_GATE_COUNT];
+    bool valid;
+};
+
+void splitCsvLine(const string &line, vector<string> &cells) {
+    cells.clear();
+    stringstream lineStream(line);
+    string cell;
+    while (getline(lineStream, cell, ',')) {
+        cells.push_back(cell);
+    }
+}
+
+int findColumn(const vector<string> &header, const string &name) {
+    for (size_t i = 0; i < header.size(); i++) {
+        if (header[i] == name) {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Runs a single log through the autotune gating rules.
+ * Only touches the provided result, so logs can be processed in parallel.
+ *
+ * @param fileName the log to read
+ * @param options the autotune options
+ * @param result where the AFR data is collected
+ */
+void processLog(const string &fileName, const AutoTuneOptions &options, LogResult &result) {
+    ifstream in(fileName.c_str());
+    string line;
+    vector<string> cells;
+    if (!in || !getline(in, line)) {
+        cout << "Could not read log " << fileName << endl;
+        return;
+    }
+    splitCsvLine(line, cells);
+    const int timeCol = findColumn(cells, TIME_COLUMN);
+    const int rpmCol = findColumn(cells, RPM_COLUMN);
+    const int speedCol = findColumn(cells, SPEED_COLUMN);
+    const int waterTempCol = findColumn(cells, WATER_TEMP_COLUMN);
+    const int afrCol = findColumn(cells, AFR_COLUMN);
+    const int loadIdxCol = findColumn(cells, LOAD_IDX_COLUMN);
+    const int rpmIdxCol = findColumn(cells, RPM_IDX_COLUMN);
+    const int tpsVoltCol = findColumn(cells, TPS_VOLT_COLUMN);
+    const int loadCol = options.loadColumn.empty() ? -1 : findColumn(cells, options.loadColumn);
+    if (timeCol < 0 || rpmCol < 0 || speedCol < 0 || waterTempCol < 0 || afrCol < 0 ||
+        loadIdxCol < 0 || rpmIdxCol < 0 || tpsVoltCol < 0 || (!options.loadColumn.empty() && loadCol < 0)) {
+        cout << "Skipping " << fileName << "; not an Apexi log" << endl;
+        return;
+    }
+    int lastCol = 0;
+    const int cols[] = {timeCol, rpmCol, speedCol, waterTempCol, afrCol, loadIdxCol, rpmIdxCol, tpsVoltCol, loadCol};
+    for (int col : cols) {
+        if (col > lastCol) {
+            lastCol = col;
+        }
+    }
+
+    OperatingPointHistory history;
+    result.valid = true;
+    while (getline(in, line)) {
+        splitCsvLine(line, cells);
+        if ((int) cells.size() <= lastCol) {
+            continue;
+        }
+        result.rows++;
+        const long timeMs = lround(atof(cells[timeCol].c_str()) * 1000);
+        const int rpmIdx = atoi(cells[rpmIdxCol].c_str());
+        const int loadIdx = atoi(cells[loadIdxCol].c_str());
+        const double rpm = atof(cells[rpmCol].c_str());
+        const double load = loadCol >= 0 ? atof(cells[loadCol].c_str()) : 0;
+        const double tpsVolt = atof(cells[tpsVoltCol].c_str());
+        const double afr = atof(cells[afrCol].c_str());
+        double speed = atof(cells[speedCol].c_str());
+        double waterTemp = atof(cells[waterTempCol].c_str());
+        if (options.imperial) {
+            speed = speed * 1.609344;
+            waterTemp = (waterTemp - 32) / 1.8;
+        }
+        const double rpmPos = getFuelMapRpmPosition(rpmIdx, rpm);
+        const double loadPos = loadCol >= 0 ? getFuelMapLoadPosition(loadIdx, load) : loadIdx;
+
+        history.record(timeMs, rpmPos, loadPos, rpm, load, tpsVolt);
+
+        // The current AFR is the result of the operating point one transport delay ago
+        AutoTuneOperatingPoint afrPoint;
+        AutoTuneGate gate = AUTOTUNE_GATE_NO_OPERATING_POINT;
+        if (history.findAt(timeMs - options.delayMs, afrPoint)) {
+            gate = checkAutoTuneGate(afr, waterTemp, speed, afrPoint);
+        }
+        if (gate == AUTOTUNE_GATE_OPEN) {
+            try {
+                addAFRSample(result.sumAfrMap, result.numAfrMap, afrPoint.rpmPos, afrPoint.loadPos, afr);
+                result.samples++;
+            } catch (const std::out_of_range &e) {
+                gate = AUTOTUNE_GATE_NO_OPERATING_POINT;
+            }
+        }
+        result.gateCount[gate]++;
+    }
+}
+
+void printUsage() {
+    cout << "Usage: autotune --map FuelMap.csv [--axes FuelMapAxes.csv] [--target TargetAfrMap.csv]\n"
+         << "                [--min-samples MinCellSamplesMap.csv] [--delay ms] [--load-column name]\n"
+         << "                [--imperial] [--threads n] [--out prefix] log1.csv [log2.csv ...]" << endl;
+}
+
+bool parseOptions(int argc, char *argv[], AutoTuneOptions &options) {
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--map" && hasValue) {
+            options.mapFile = argv[++i];
+        } else if (arg == "--axes" && hasValue) {
+            options.axesFile = argv[++i];
+        } else if (arg == "--target" && hasValue) {
+            options.targetFile = argv[++i];
+        } else if (arg == "--min-samples" && hasValue) {
+            options.minSamplesFile = argv[++i];
+        } else if (arg == "--delay" && hasValue) {
+            options.delayMs = atoi(argv[++i]);
+        } else if (arg == "--load-column" && hasValue) {
+            options.loadColumn = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = atoi(argv[++i]);
+        } else if (arg == "--out" && hasValue) {
+            options.outPrefix = argv[++i];
+        } else if (arg == "--imperial") {
+            options.imperial = true;
+        } else if (arg.compare(0, 2, "--") == 0) {
+            cout << "Unknown option " << arg << endl;
+            return false;
+        } else {
+            options.logFiles.push_back(arg);
+        }
+    }
+    return !options.mapFile.empty() && !options.logFiles.empty() && options.delayMs >= 0
+           && options.delayMs <= MAX_AFR_TRANSPORT_DELAY_MS;
+}
+
+int main(int argc, char *argv[]) {
+    AutoTuneOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+    if (!loadCurrentFuelMap(options.mapFile.c_str())) {
+        return 1;
+    }
+    if (!options.axesFile.empty() && !loadFuelMapAxes(options.axesFile.c_str())) {
+        return 1;
+    }
+    if (!options.targetFile.empty() && !loadTargetAfrMap(options.targetFile.c_str())) {
+        return 1;
+    }
+    if (!options.minSamplesFile.empty() && !loadMinCellSamplesMap(options.minSamplesFile.c_str())) {
+        return 1;
+    }
+
+    const size_t logCount = options.logFiles.size();
+    vector<LogResult> results(logCount); // value initialized; all zero
+    unsigned int threadCount = options.threads > 0 ? options.threads : thread::hardware_concurrency();
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    if (threadCount > logCount) {
+        threadCount = logCount;
+    }
+    atomic<size_t> nextLog(0);
+    vector<thread> workers;
+    for (unsigned int t = 0; t < threadCount; t++) {
+        workers.push_back(thread([&]() {
+            size_t idx;
+            while ((idx = nextLog++) < logCount) {
+                processLog(options.logFiles[idx], options, results[idx]);
+            }
+        }));
+    }
+    for (thread &worker : workers) {
+        worker.join();
+    }
+
+    // merge in the order of the logs so the outcome does not depend on the thread scheduling
+    long rows = 0;
+    long gateCount[AUTOTUNE_GATE_COUNT] = {0};
+    for (size_t i = 0; i < logCount; i++) {
+        const LogResult &result = results[i];
+        if (!result.valid) {
+            continue;
+        }
+        mergeAFRData(result.sumAfrMap, result.numAfrMap, result.samples);
+        rows += result.rows;
+        for (int gate = 0; gate < AUTOTUNE_GATE_COUNT; gate++) {
+            gateCount[gate] += result.gateCount[gate];
+        }
+    }
+    cout << "== Processed " << rows << " rows from " << logCount << " logs ==" << endl;
+    for (int gate = 0; gate < AUTOTUNE_GATE_COUNT; gate++) {
+        if (gateCount[gate] > 0) {
+            cout << getAutoTuneGateName((AutoTuneGate) gate) << ": " << gateCount[gate] << endl;
+        }
+    }
+
+    const int cellsChanged = calculateNewFuelMap();
+    double confidence[FUEL_TABLE_SIZE][FUEL_TABLE_SIZE];
+    for (int row = 0; row < FUEL_TABLE_SIZE; row++) {
+        for (int col = 0; col < FUEL_TABLE_SIZE; col++) {
+            const double minSamples = getMinCellSamples(row, col);
+            const double weight = getLoggedAfrWeight(row, col);
+            confidence[row][col] = (minSamples <= 0 || weight >= minSamples) ? 1 : weight / minSamples;
+        }
+    }
+    logFuelData(FUEL_TABLE_SIZE);
+
+    const string fuelFile = options.outPrefix + "_fuel.csv";
+    const string confidenceFile = options.outPrefix + "_confidence.csv";
+    if (!saveNewFuelMap(fuelFile.c_str()) || !writeFuelMapTable(confidenceFile.c_str(), confidence)) {
+        return 1;
+    }
+    cout << "== " << cellsChanged << " cells changed; wrote " << fuelFile
+         << " and " << confidenceFile << " ==" << endl;
+    return 0;
+}
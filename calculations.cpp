@@ -8,6 +8,8 @@
 
 #include "calculations.h"
 #include "dashboard.h"
+#include "derivedchannels.h"
+#include <QtMath>
 #include <QDebug>
 
 qreal Power;
@@ -15,11 +17,10 @@ qreal Torque;
 qreal odometer;
 qreal tripmeter;
 qreal traveleddistance;
-QTime startTime = QTime::currentTime();
 int weight; //just set this to 1300 for testing
 int gearratio;
 int odoisset;
-int PreviousSpeed;
+qreal PreviousSpeed;
 int Gear1;
 int Gear2;
 int Gear3;
@@ -28,9 +29,15 @@ int Gear5;
 int Gear6;
 int GearN;
 
+const char *ODOMETER_JOURNAL_FILE = "/home/pi/Odometer.journal";
+
 calculations::calculations(QObject *parent)
     : QObject(parent)
     , m_dashboard(Q_NULLPTR)
+    , m_derivedChannels(Q_NULLPTR)
+    , m_odometerJournal(ODOMETER_JOURNAL_FILE)
+    , m_odometerLoaded(false)
+    , m_odometerTime(0)
 
 {
 
@@ -38,65 +45,128 @@ calculations::calculations(QObject *parent)
 calculations::calculations(DashBoard *dashboard, QObject *parent)
     : QObject(parent)
     , m_dashboard(dashboard)
+    , m_derivedChannels(new DerivedChannels(dashboard, this))
+    , m_odometerJournal(ODOMETER_JOURNAL_FILE)
+    , m_odometerLoaded(false)
+    , m_odometerTime(0)
+{
+    m_odometerLoaded = m_odometerJournal.load(odometer, tripmeter);
+    if (m_odometerLoaded)
+    {
+        m_dashboard->setOdo(odometer);
+        m_dashboard->setTrip(tripmeter);
+    }
+    addDerivedChannels();
+}
+
+// Each calculation is done when one of its inputs changed, instead of every 25 ms
+void calculations::addDerivedChannels()
+{
+    m_derivedChannels->addChannel(QStringList() << "Gear",
+                                  QStringList() << "gearcalcactivation" << "rpm" << "speed" << "gearcalc1" << "gearcalc2"
+                                                << "gearcalc3" << "gearcalc4" << "gearcalc5" << "gearcalc6",
+                                  [this]() { calculateGear(); });
+    m_derivedChannels->addChannel(QStringList() << "Odo" << "Trip",
+                                  QStringList() << "speed" << DerivedChannels::TICK_INPUT,
+                                  [this]() { calculateOdometer(); });
+    m_derivedChannels->addChannel(QStringList() << "Power" << "Torque",
+                                  QStringList() << "accely" << "speed" << "rpm" << "Weight" << "units",
+                                  [this]() { calculatePower(); });
+}
+
+void calculations::restoreOdometer(const qreal &Odometer, const qreal &Trip)
 {
+    if (m_odometerLoaded)
+        return;
+    m_odometerLoaded = true;
+    odometer = Odometer;
+    tripmeter = Trip;
+    m_dashboard->setOdo(odometer);
+    m_dashboard->setTrip(tripmeter);
+    m_odometerJournal.update(odometer, tripmeter, true);
+}
 
+// The odometer entered in the settings; shown in whole units, so only a different value is taken
+void calculations::setOdometer(const qreal &Odometer)
+{
+    if (qAbs(Odometer - odometer) < 1)
+        return;
+    odometer = Odometer;
+    m_dashboard->setOdo(odometer);
+    m_odometerJournal.update(odometer, tripmeter, true);
 }
 
 void calculations::start()
 {
-    connect(&m_updatetimer, &QTimer::timeout, this, &calculations::calculate);
-    odometer = m_dashboard->Odo();
-    tripmeter = m_dashboard->Trip();
-    m_updatetimer.start(25);
+    PreviousSpeed = m_dashboard->speed();
+    m_odometerTime = SampleClock::now();
+    m_derivedChannels->start();
 
 }
 void calculations::stop()
 {
-    m_updatetimer.stop();
+    m_derivedChannels->stop();
+    m_odometerJournal.update(odometer, tripmeter, true);
 }
 void calculations::resettrip()
 {
     tripmeter = 0;
     m_dashboard->setTrip(0);
+    m_odometerJournal.update(odometer, tripmeter, true);
 
 }
 
 
-void calculations::calculate()
+void calculations::calculateGear()
 {
+   if (m_dashboard->gearcalcactivation() != 1)
+       return;
+   //Gear Calculation borrowed from Raspexi big thanks to Jacob Donley
+   //The first gear whose band (halfway to the next ratio) rpm / speed falls in; 0 (neutral / clutch) above 1.5 times the first gear ratio
+   const int ratios[] = {0, m_dashboard->gearcalc1(), m_dashboard->gearcalc2(), m_dashboard->gearcalc3(),
+                         m_dashboard->gearcalc4(), m_dashboard->gearcalc5(), m_dashboard->gearcalc6()};
+   int N = m_dashboard->rpm() / (m_dashboard->speed() == 0.0 ? 0.01 : m_dashboard->speed());
+   int CurrentGear = 0;
+   if (N <= ratios[1] * 1.5)
+   {
+       for (int gear = 1; gear <= 6; gear++)
+       {
+           // 5th and 6th gear are optional
+           if (gear >= 5 && ratios[gear] == 0)
+               break;
+           const qreal threshold = gear < 6 ? (ratios[gear] + ratios[gear + 1]) / 2.0 : ratios[gear] / 2.0;
+           if (N > threshold)
+           {
+               CurrentGear = gear;
+               break;
+           }
+       }
+   }
+   m_dashboard->setGear(CurrentGear);
+   //qDebug()<<"Gear"<< m_dashboard->Gear();
+}
 
-    weight = m_dashboard->Weight();
-    //qDebug() << "Weight" << weight;
-
-    //starting the timer again with 25 ms
-    m_updatetimer.start(25);
-
-   if (m_dashboard->gearcalcactivation() == 1)
-     {
-     //Gear Calculation borrowed from Raspexi big thanks to Jacob Donley
-     int N = m_dashboard->rpm() / (m_dashboard->speed() == 0.0 ? 0.01 : m_dashboard->speed()); 
-     int CurrentGear = (N > (m_dashboard->gearcalc1()*1.5) ? 0.0 : (N > ((m_dashboard->gearcalc1() + m_dashboard->gearcalc2()) / 2.0) ? 1.0 : (N > ((m_dashboard->gearcalc2() + m_dashboard->gearcalc3()) / 2.0) ? 2.0 : (N > ((m_dashboard->gearcalc3() + m_dashboard->gearcalc4()) / 2.0) ? 3.0 : (N > ((m_dashboard->gearcalc4() + m_dashboard->gearcalc5()) / 2.0) ? 4.0 : (m_dashboard->gearcalc5() == 0 ? 0.0 : (N > ((m_dashboard->gearcalc5() + m_dashboard->gearcalc6()) / 2.0) ? 5.0 : (m_dashboard->gearcalc6() == 0 ? 0.0 : (N > (m_dashboard->gearcalc6() / 2.0) ? 6.0 : 0.0)))))))));
-     m_dashboard->setGear(CurrentGear);
-     //qDebug()<<"Gear"<< m_dashboard->Gear();
-    }
-/*
-
-     qDebug()<<"Gear1"<< m_dashboard->gearcalc1();
-     qDebug()<<"Gear2"<< m_dashboard->gearcalc2();
-     qDebug()<<"Gear3"<< m_dashboard->gearcalc3();
-     qDebug()<<"Gear4"<< m_dashboard->gearcalc4();
-     qDebug()<<"Gear5"<< m_dashboard->gearcalc5();
-     qDebug()<<"Gear6"<< m_dashboard->gearcalc6();
-*/
-
-
-    //Odometer
-    traveleddistance = ((startTime.msecsTo(QTime::currentTime())) * ((m_dashboard->speed()) / 3600000)); // Odometer
+void calculations::calculateOdometer()
+{
+    //Odometer; trapezoidal integration of speed (km/h or mph) over the time the samples were received,
+    //so changes of the system time (GPS / NTP) and timer delays do not change the distance
+    const qreal speed = m_dashboard->speed();
+    const qint64 now = qMax(m_odometerTime, m_dashboard->sampleTime());
+    traveleddistance = (now - m_odometerTime) * ((PreviousSpeed + speed) / 2 / 3600000.0);
+    m_odometerTime = now;
+    PreviousSpeed = speed;
     odometer += traveleddistance;
     tripmeter += traveleddistance;
     m_dashboard->setOdo(odometer);
     m_dashboard->setTrip(tripmeter);
-    startTime.restart(); //(QTime::currentTime())
+    // written when the car stops, so nothing is lost when the ignition is switched off
+    m_odometerJournal.update(odometer, tripmeter, speed == 0);
+}
+
+void calculations::calculatePower()
+{
+    weight = m_dashboard->Weight();
+    //qDebug() << "Weight" << weight;
 
     // Virtual Dyno to calculate Wheel Power and Wheel Torque
 
@@ -4,8 +4,10 @@
 #include <QObject>
 #include <QTime>
 #include <QTimer>
+#include "odometerjournal.h"
 
 class DashBoard;
+class DerivedChannels;
 
 class calculations : public QObject
 {
@@ -18,9 +20,14 @@ public:
     explicit calculations(QObject *parent = 0);
     explicit calculations(DashBoard *dashboard, QObject *parent = 0);
 
+    DerivedChannels *derivedChannels() const { return m_derivedChannels; }
+
+    // Takes over the odometer kept by an older version in the QML settings, if there is no journal yet
+    Q_INVOKABLE void restoreOdometer(const qreal &Odometer, const qreal &Trip);
+    void setOdometer(const qreal &Odometer);
+
 public slots:
 
-    void calculate();
     void start();
     void stop();
     void resettrip();
@@ -28,8 +35,16 @@ public slots:
 
 
 private:
+    void addDerivedChannels();
+    void calculateGear();
+    void calculateOdometer();
+    void calculatePower();
+
     DashBoard *m_dashboard;
-    QTimer      m_updatetimer;
+    DerivedChannels *m_derivedChannels;
+    OdometerJournal m_odometerJournal;
+    bool m_odometerLoaded;
+    qint64 m_odometerTime;
 
 };
 
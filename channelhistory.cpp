@@ -0,0 +1,291 @@
+#include "channelhistory.h"
+#include "sampleclock.h"
+#include <QtCharts/QXYSeries>
+#include <QtMath>
+#include <QDebug>
+
+ChannelRing::ChannelRing(int capacity)
+    : m_time(capacity)
+    , m_value(capacity)
+    , m_head(0)
+    , m_count(0)
+    , m_total(0)
+{
+    // a level is only useful while a block is smaller than the ring
+    for (qint64 blockSize = LOD_FACTOR; blockSize < capacity; blockSize *= LOD_FACTOR)
+        m_levels.append(QVector<LodBlock>(capacity / blockSize + 2));
+}
+
+void ChannelRing::append(qint64 timeMs, qreal value)
+{
+    if (m_time.isEmpty())
+        return;
+    // the time stamps of sources that are merged into a channel may be slightly out of order
+    if (m_count)
+        timeMs = qMax(timeMs, timeAt(m_count - 1));
+    int idx;
+    if (m_count < m_time.size()) {
+        idx = physical(m_count);
+        m_count++;
+    } else {
+        idx = m_head;
+        m_head = (m_head + 1) % m_time.size();
+    }
+    m_time[idx] = timeMs;
+    m_value[idx] = value;
+    updateLevels(timeMs, value);
+    m_total++;
+}
+
+void ChannelRing::updateLevels(qint64 timeMs, qreal value)
+{
+    qint64 blockSize = LOD_FACTOR;
+    for (int level = 0; level < m_levels.size(); level++, blockSize *= LOD_FACTOR) {
+        QVector<LodBlock> &blocks = m_levels[level];
+        LodBlock &block = blocks[(m_total / blockSize) % blocks.size()];
+        if (m_total % blockSize == 0) {
+            block.minTime = block.maxTime = timeMs;
+            block.minValue = block.maxValue = value;
+        } else if (value < block.minValue) {
+            block.minTime = timeMs;
+            block.minValue = value;
+        } else if (value > block.maxValue) {
+            block.maxTime = timeMs;
+            block.maxValue = value;
+        }
+    }
+}
+
+void ChannelRing::clear()
+{
+    m_head = 0;
+    m_count = 0;
+    m_total = 0;
+}
+
+int ChannelRing::lowerBound(qint64 timeMs) const
+{
+    int low = 0;
+    int high = m_count;
+    while (low < high) {
+        const int mid = (low + high) / 2;
+        if (timeAt(mid) < timeMs)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+    return low;
+}
+
+bool ChannelRing::valueAt(qint64 timeMs, qreal &value) const
+{
+    const int idx = lowerBound(timeMs + 1) - 1;
+    if (idx < 0)
+        return false;
+    value = valueAt(idx);
+    return true;
+}
+
+void ChannelRing::merge(const LodBlock &from, LodBlock &block, bool &valid)
+{
+    if (!valid) {
+        block = from;
+        valid = true;
+        return;
+    }
+    if (from.minValue < block.minValue) {
+        block.minTime = from.minTime;
+        block.minValue = from.minValue;
+    }
+    if (from.maxValue > block.maxValue) {
+        block.maxTime = from.maxTime;
+        block.maxValue = from.maxValue;
+    }
+}
+
+void ChannelRing::mergeSamples(int first, int end, LodBlock &block, bool &valid) const
+{
+    for (int i = first; i < end; i++) {
+        const LodBlock sample = {timeAt(i), valueAt(i), timeAt(i), valueAt(i)};
+        merge(sample, block, valid);
+    }
+}
+
+// min and max in the order they occurred, so peaks are kept
+void ChannelRing::appendBlock(const LodBlock &block, QVector<QPointF> &points)
+{
+    if (block.minTime <= block.maxTime) {
+        points.append(QPointF(block.minTime, block.minValue));
+        if (block.maxTime != block.minTime)
+            points.append(QPointF(block.maxTime, block.maxValue));
+    } else {
+        points.append(QPointF(block.maxTime, block.maxValue));
+        points.append(QPointF(block.minTime, block.minValue));
+    }
+}
+
+void ChannelRing::decimate(int first, int end, int maxPoints, QVector<QPointF> &points) const
+{
+    first = qMax(0, first);
+    end = qMin(m_count, end);
+    const int count = end - first;
+    if (count <= 0)
+        return;
+    if (maxPoints <= 0 || count <= maxPoints) {
+        for (int i = first; i < end; i++)
+            points.append(QPointF(timeAt(i), valueAt(i)));
+        return;
+    }
+    const int buckets = qMax(1, maxPoints / 2);
+    const qint64 samplesPerBucket = count / buckets;
+
+    // the coarsest level with blocks that are not bigger than a bucket
+    int level = 0;
+    qint64 blockSize = 1;
+    while (level < m_levels.size() && blockSize * LOD_FACTOR <= samplesPerBucket) {
+        blockSize *= LOD_FACTOR;
+        level++;
+    }
+
+    LodBlock block;
+    bool valid = false;
+    if (level == 0) {
+        for (int b = 0; b < buckets; b++) {
+            valid = false;
+            mergeSamples(first + qint64(count) * b / buckets, first + qint64(count) * (b + 1) / buckets, block, valid);
+            if (valid)
+                appendBlock(block, points);
+        }
+        return;
+    }
+
+    // samples [first, end) in the numbering of the level blocks
+    const qint64 absoluteFirst = m_total - m_count + first;
+    const qint64 absoluteEnd = m_total - m_count + end;
+    const qint64 blockFirst = (absoluteFirst + blockSize - 1) / blockSize;
+    const qint64 blockEnd = absoluteEnd / blockSize;
+    const QVector<LodBlock> &blocks = m_levels[level - 1];
+    const qint64 blocksPerBucket = qMax<qint64>(1, samplesPerBucket / blockSize);
+
+    const qint64 headEnd = qMin(absoluteEnd, blockFirst * blockSize);
+    const qint64 tailFirst = qMax(headEnd, blockEnd * blockSize);
+
+    // partial block at the start
+    mergeSamples(first, first + int(headEnd - absoluteFirst), block, valid);
+    qint64 blocksInBucket = 0;
+    for (qint64 j = blockFirst; j < blockEnd; j++) {
+        merge(blocks[j % blocks.size()], block, valid);
+        if (++blocksInBucket == blocksPerBucket) {
+            appendBlock(block, points);
+            valid = false;
+            blocksInBucket = 0;
+        }
+    }
+    // partial block at the end
+    mergeSamples(end - int(absoluteEnd - tailFirst), end, block, valid);
+    if (valid)
+        appendBlock(block, points);
+}
+
+ChannelHistory::ChannelHistory(QObject *parent)
+    : QObject(parent)
+{
+}
+
+int ChannelHistory::addChannel(const QString &channel)
+{
+    QHash<QString, int>::const_iterator slot = m_slotIndex.constFind(channel);
+    if (slot != m_slotIndex.constEnd())
+        return slot.value();
+    m_slots.append(Channel());
+    m_slotIndex.insert(channel, m_slots.size() - 1);
+    return m_slots.size() - 1;
+}
+
+void ChannelHistory::track(const QString &channel, const int &capacity)
+{
+    const int slot = m_slotIndex.value(channel, -1);
+    if (slot < 0) {
+        qWarning() << "Channel" << channel << "is not recorded";
+        return;
+    }
+    Channel &recorded = m_slots[slot];
+    if (recorded.tracked && recorded.ring.capacity() == capacity)
+        return;
+    recorded.ring = ChannelRing(qMax(1, capacity));
+    recorded.tracked = true;
+}
+
+void ChannelHistory::untrack(const QString &channel)
+{
+    const int slot = m_slotIndex.value(channel, -1);
+    if (slot < 0)
+        return;
+    m_slots[slot].ring = ChannelRing();
+    m_slots[slot].tracked = false;
+}
+
+void ChannelHistory::clear(const QString &channel)
+{
+    for (QHash<QString, int>::const_iterator slot = m_slotIndex.constBegin(); slot != m_slotIndex.constEnd(); ++slot) {
+        if (channel.isEmpty() || slot.key() == channel)
+            m_slots[slot.value()].ring.clear();
+    }
+}
+
+qint64 ChannelHistory::now() const
+{
+    return SampleClock::now();
+}
+
+const ChannelRing *ChannelHistory::ring(const QString &channel) const
+{
+    const int slot = m_slotIndex.value(channel, -1);
+    return slot >= 0 && m_slots[slot].tracked ? &m_slots[slot].ring : Q_NULLPTR;
+}
+
+void ChannelHistory::updateSeries(QAbstractSeries *series, const QString &channel, const qreal &seconds, const int &maxPoints)
+{
+    const qint64 nowMs = now();
+    QXYSeries *xySeries = qobject_cast<QXYSeries *>(series);
+    const ChannelRing *channelRing = ring(channel);
+    if (!xySeries || !channelRing)
+        return;
+    m_points.clear();
+    channelRing->decimate(channelRing->lowerBound(nowMs - qRound64(seconds * 1000)), channelRing->size(), maxPoints, m_points);
+    for (int i = 0; i < m_points.size(); i++)
+        m_points[i].setX((m_points[i].x() - nowMs) / 1000.0);
+    xySeries->replace(m_points);
+}
+
+void ChannelHistory::updateSeriesRange(QAbstractSeries *series, const QString &channel, const qint64 &fromMs, const qint64 &toMs, const int &maxPoints)
+{
+    QXYSeries *xySeries = qobject_cast<QXYSeries *>(series);
+    const ChannelRing *channelRing = ring(channel);
+    if (!xySeries || !channelRing)
+        return;
+    m_points.clear();
+    channelRing->decimate(channelRing->lowerBound(fromMs), channelRing->lowerBound(toMs + 1), maxPoints, m_points);
+    for (int i = 0; i < m_points.size(); i++)
+        m_points[i].setX((m_points[i].x() - fromMs) / 1000.0);
+    xySeries->replace(m_points);
+}
+
+void ChannelHistory::updateXYSeries(QAbstractSeries *series, const QString &xChannel, const QString &yChannel, const qint64 &sinceMs, const int &maxPoints)
+{
+    QXYSeries *xySeries = qobject_cast<QXYSeries *>(series);
+    const ChannelRing *xRing = ring(xChannel);
+    const ChannelRing *yRing = ring(yChannel);
+    if (!xySeries || !xRing || !yRing)
+        return;
+    const int first = yRing->lowerBound(sinceMs);
+    const int count = yRing->size() - first;
+    const int step = (maxPoints > 0 && count > maxPoints) ? qCeil(qreal(count) / maxPoints) : 1;
+    m_points.clear();
+    for (int i = first; i < yRing->size(); i += step) {
+        qreal x;
+        if (xRing->valueAt(yRing->timeAt(i), x))
+            m_points.append(QPointF(x, yRing->valueAt(i)));
+    }
+    xySeries->replace(m_points);
+}
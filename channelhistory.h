@@ -0,0 +1,128 @@
+#ifndef CHANNELHISTORY_H
+#define CHANNELHISTORY_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QPointF>
+#include <QtCharts/QAbstractSeries>
+
+QT_CHARTS_USE_NAMESPACE
+
+/*
+ * The latest samples of a channel, oldest first.
+ * Fixed capacity ring; once full the oldest sample is overwritten.
+ *
+ * Next to the samples a level of detail pyramid is kept: level k holds the min and max
+ * of each block of LOD_FACTOR^k samples. A long time range is then decimated from the
+ * coarsest level that still gives enough points, so the cost depends on the number of
+ * points drawn and not on the number of samples in the range.
+ */
+class ChannelRing
+{
+public:
+    static const int LOD_FACTOR = 8;
+
+    explicit ChannelRing(int capacity = 0);
+
+    void append(qint64 timeMs, qreal value);
+    void clear();
+    int size() const { return m_count; }
+    int capacity() const { return m_time.size(); }
+    qint64 timeAt(int idx) const { return m_time[physical(idx)]; }
+    qreal valueAt(int idx) const { return m_value[physical(idx)]; }
+    // Index of the first sample at or after timeMs (size() if none)
+    int lowerBound(qint64 timeMs) const;
+    // Value of the channel at timeMs (the sample at or before it)
+    bool valueAt(qint64 timeMs, qreal &value) const;
+    // Appends about maxPoints points (x is the time in ms) of the samples [first, end), keeping the min and max
+    void decimate(int first, int end, int maxPoints, QVector<QPointF> &points) const;
+
+private:
+    struct LodBlock {
+        qint64 minTime;
+        qreal minValue;
+        qint64 maxTime;
+        qreal maxValue;
+    };
+
+    int physical(int idx) const { return (m_head + idx) % m_time.size(); }
+    void updateLevels(qint64 timeMs, qreal value);
+    void mergeSamples(int first, int end, LodBlock &block, bool &valid) const;
+    static void merge(const LodBlock &from, LodBlock &block, bool &valid);
+    static void appendBlock(const LodBlock &block, QVector<QPointF> &points);
+
+    QVector<qint64> m_time;
+    QVector<qreal> m_value;
+    int m_head;
+    int m_count;
+    qint64 m_total; // samples appended since the last clear
+    // m_levels[k - 1] holds the blocks of LOD_FACTOR^k samples; block j is at j % size
+    QVector<QVector<LodBlock> > m_levels;
+};
+
+/*
+ * Records the history of DashBoard channels, timestamped as they are received,
+ * and hands it to the charts in batches that are decimated to the chart width.
+ *
+ * A source declares its channels once and records by the slot it got back, so a sample
+ * costs no lookup of the channel name.
+ */
+class ChannelHistory : public QObject
+{
+    Q_OBJECT
+
+public:
+    // 10 minutes at 20 samples per second
+    static const int DEFAULT_CAPACITY = 12000;
+
+    explicit ChannelHistory(QObject *parent = 0);
+
+    // Declares a channel a source records and returns its slot; only those channels can be tracked
+    int addChannel(const QString &channel);
+    Q_INVOKABLE void track(const QString &channel, const int &capacity = DEFAULT_CAPACITY);
+    Q_INVOKABLE void untrack(const QString &channel);
+    Q_INVOKABLE void clear(const QString &channel = QString());
+    // SampleClock::now()
+    Q_INVOKABLE qint64 now() const;
+
+    // Replaces the points of a line series with the last seconds of a channel (x in seconds, 0 is now)
+    Q_INVOKABLE void updateSeries(QAbstractSeries *series, const QString &channel, const qreal &seconds, const int &maxPoints);
+    // Replaces the points of a line series with the samples of a channel between fromMs and toMs (x in seconds since fromMs),
+    // ex. to zoom into a whole session
+    Q_INVOKABLE void updateSeriesRange(QAbstractSeries *series, const QString &channel, const qint64 &fromMs, const qint64 &toMs, const int &maxPoints);
+    // Replaces the points of a line series with a channel plotted against another channel since sinceMs (ex. power over rpm)
+    Q_INVOKABLE void updateXYSeries(QAbstractSeries *series, const QString &xChannel, const QString &yChannel, const qint64 &sinceMs, const int &maxPoints);
+
+    // A sample of the DashBoard, with the time it was received
+    void record(int slot, const qint64 &timeMs, const qreal &value)
+    {
+        Channel &channel = m_slots[slot];
+        if (channel.tracked && !channel.timestamped)
+            channel.ring.append(timeMs, value);
+    }
+    // Records a sample of a source that is not the DashBoard, ex. from a batch of a sensor. record()
+    // then skips the channel, so the source can set decimated values on the DashBoard meanwhile.
+    void recordAt(int slot, const qint64 &timeMs, const qreal &value)
+    {
+        Channel &channel = m_slots[slot];
+        channel.timestamped = true;
+        if (channel.tracked)
+            channel.ring.append(timeMs, value);
+    }
+    const ChannelRing *ring(const QString &channel) const;
+
+private:
+    struct Channel {
+        Channel() : tracked(false), timestamped(false) {}
+        ChannelRing ring;
+        bool tracked;
+        bool timestamped;
+    };
+
+    QVector<Channel> m_slots;
+    QHash<QString, int> m_slotIndex; // channel -> slot
+    QVector<QPointF> m_points;
+};
+
+#endif // CHANNELHISTORY_H
@@ -0,0 +1,64 @@
+#include "channelnotifyfilter.h"
+#include <QtMath>
+
+ChannelNotifyFilter::ChannelNotifyFilter()
+    : m_deadband(0)
+    , m_decimals(-1)
+    , m_displayScale(1)
+    , m_minIntervalMs(0)
+    , m_lastValue(0)
+    , m_lastNotifyMs(0)
+    , m_hasNotified(false)
+    , m_pending(false)
+{
+}
+
+void ChannelNotifyFilter::setDeadband(qreal deadband)
+{
+    m_deadband = deadband > 0 ? deadband : 0;
+}
+
+void ChannelNotifyFilter::setDecimals(int decimals)
+{
+    m_decimals = decimals;
+    m_displayScale = decimals >= 0 ? qPow(10, decimals) : 1;
+}
+
+void ChannelNotifyFilter::setMaxRate(qreal maxRate)
+{
+    m_minIntervalMs = maxRate > 0 ? qRound64(1000 / maxRate) : 0;
+}
+
+bool ChannelNotifyFilter::isVisibleChange(qreal value) const
+{
+    if (!m_hasNotified)
+        return true;
+    if (m_decimals >= 0 && qRound64(value * m_displayScale) == qRound64(m_lastValue * m_displayScale))
+        return false;
+    if (m_deadband > 0 && qAbs(value - m_lastValue) < m_deadband)
+        return false;
+    return true;
+}
+
+ChannelNotifyFilter::Decision ChannelNotifyFilter::check(qreal value, qint64 nowMs)
+{
+    if (!isVisibleChange(value)) {
+        // back within the band of the last notified value; nothing to flush
+        m_pending = false;
+        return Suppress;
+    }
+    if (m_hasNotified && m_minIntervalMs > 0 && nowMs - m_lastNotifyMs < m_minIntervalMs) {
+        m_pending = true;
+        return Defer;
+    }
+    notified(value, nowMs);
+    return Notify;
+}
+
+void ChannelNotifyFilter::notified(qreal value, qint64 nowMs)
+{
+    m_lastValue = value;
+    m_lastNotifyMs = nowMs;
+    m_hasNotified = true;
+    m_pending = false;
+}
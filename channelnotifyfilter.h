@@ -0,0 +1,51 @@
+#ifndef CHANNELNOTIFYFILTER_H
+#define CHANNELNOTIFYFILTER_H
+
+#include <QtGlobal>
+
+/*
+ * Decides whether a change of a channel is worth a change notification.
+ * The value itself is always stored exactly (ex. for logging); only the
+ * notification that wakes up the QML bindings is filtered.
+ *
+ * decimals >= 0 : notify when the value rounded to the displayed decimals changes
+ * deadband > 0  : notify when the value moved at least deadband since the last notification
+ * maxRate > 0   : notify at most maxRate times per second; the latest value is
+ *                 notified once the interval has passed (see pendingSince)
+ */
+class ChannelNotifyFilter
+{
+public:
+    enum Decision {
+        Notify,
+        Suppress,
+        Defer
+    };
+
+    ChannelNotifyFilter();
+
+    void setDeadband(qreal deadband);
+    void setDecimals(int decimals);
+    void setMaxRate(qreal maxRate);
+    int decimals() const { return m_decimals; }
+    qint64 minIntervalMs() const { return m_minIntervalMs; }
+
+    Decision check(qreal value, qint64 nowMs);
+    bool isPending() const { return m_pending; }
+    bool isDue(qint64 nowMs) const { return m_pending && nowMs - m_lastNotifyMs >= m_minIntervalMs; }
+    void notified(qreal value, qint64 nowMs);
+
+private:
+    bool isVisibleChange(qreal value) const;
+
+    qreal m_deadband;
+    int m_decimals;
+    qreal m_displayScale;
+    qint64 m_minIntervalMs;
+    qreal m_lastValue;
+    qint64 m_lastNotifyMs;
+    bool m_hasNotified;
+    bool m_pending;
+};
+
+#endif // CHANNELNOTIFYFILTER_H
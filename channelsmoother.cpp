@@ -0,0 +1,103 @@
+#include "channelsmoother.h"
+#include <QtNumeric>
+#include <algorithm>
+
+ChannelSmoother::ChannelSmoother()
+    : m_mode(None)
+    , m_window(0)
+    , m_count(0)
+    , m_next(0)
+    , m_sum(0)
+    , m_sumCompensation(0)
+    , m_ema(0)
+{
+}
+
+ChannelSmoother::ChannelSmoother(Mode mode, int window)
+    : ChannelSmoother()
+{
+    configure(mode, window);
+}
+
+ChannelSmoother::Mode ChannelSmoother::modeFromString(const QString &mode)
+{
+    const QString lower = mode.toLower();
+    if (lower == "average" || lower == "ma")
+        return Average;
+    if (lower == "ema" || lower == "exponential")
+        return EMA;
+    if (lower == "median")
+        return Median;
+    return None;
+}
+
+void ChannelSmoother::configure(Mode mode, int window)
+{
+    if (window < 2)
+        mode = None;
+    if (mode == Median && window > MAX_MEDIAN_WINDOW)
+        window = MAX_MEDIAN_WINDOW;
+    m_mode = mode;
+    m_window = (mode == None) ? 0 : window;
+    // EMA keeps no history; the other modes keep the last window values
+    m_ring.fill(0, (mode == Average || mode == Median) ? m_window : 0);
+    m_sorted.clear();
+    m_sorted.reserve(mode == Median ? m_window : 0);
+    reset();
+}
+
+void ChannelSmoother::reset()
+{
+    m_count = 0;
+    m_next = 0;
+    m_sum = 0;
+    m_sumCompensation = 0;
+    m_ema = 0;
+    m_sorted.clear();
+}
+
+qreal ChannelSmoother::add(qreal value)
+{
+    if (qIsNaN(value))
+        return value;
+    switch (m_mode) {
+    case Average: {
+        qreal delta = value;
+        if (m_count == m_window)
+            delta -= m_ring[m_next];
+        else
+            m_count++;
+        m_ring[m_next] = value;
+        m_next = (m_next + 1) % m_window;
+        // compensated running sum, so rounding errors do not build up over a long session
+        const qreal y = delta - m_sumCompensation;
+        const qreal t = m_sum + y;
+        m_sumCompensation = (t - m_sum) - y;
+        m_sum = t;
+        return m_sum / m_count;
+    }
+    case EMA:
+        if (m_count == 0) {
+            m_count = 1;
+            m_ema = value;
+        } else {
+            m_ema += (2.0 / (m_window + 1)) * (value - m_ema);
+        }
+        return m_ema;
+    case Median: {
+        if (m_count == m_window) {
+            const qreal oldest = m_ring[m_next];
+            m_sorted.erase(std::lower_bound(m_sorted.begin(), m_sorted.end(), oldest));
+        } else {
+            m_count++;
+        }
+        m_ring[m_next] = value;
+        m_next = (m_next + 1) % m_window;
+        m_sorted.insert(std::upper_bound(m_sorted.begin(), m_sorted.end(), value), value);
+        const int mid = m_count / 2;
+        return (m_count % 2) ? m_sorted[mid] : (m_sorted[mid - 1] + m_sorted[mid]) / 2;
+    }
+    default:
+        return value;
+    }
+}
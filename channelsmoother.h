@@ -0,0 +1,55 @@
+#ifndef CHANNELSMOOTHER_H
+#define CHANNELSMOOTHER_H
+
+#include <QVector>
+#include <QString>
+
+/*
+ * Smooths the values of a single channel over a fixed window.
+ * The window is a ring buffer allocated when the smoother is configured,
+ * so adding a value does not allocate or shift any data.
+ *
+ * Average : running sum, constant time per value
+ * EMA     : exponential moving average (alpha = 2 / (window + 1)), constant time per value
+ * Median  : median of the last window values, for spiky channels (ex. oil pressure)
+ */
+class ChannelSmoother
+{
+public:
+    enum Mode {
+        None,
+        Average,
+        EMA,
+        Median
+    };
+
+    // The window of the median filter is kept small; it is sorted on insert
+    static const int MAX_MEDIAN_WINDOW = 31;
+
+    ChannelSmoother();
+    ChannelSmoother(Mode mode, int window);
+
+    static Mode modeFromString(const QString &mode);
+
+    void configure(Mode mode, int window);
+    void reset();
+    qreal add(qreal value);
+
+    Mode mode() const { return m_mode; }
+    int window() const { return m_window; }
+    // The window holds window values (Average, Median)
+    bool isFull() const { return m_count >= m_window; }
+
+private:
+    Mode m_mode;
+    int m_window;
+    int m_count;
+    int m_next;
+    qreal m_sum;
+    qreal m_sumCompensation;
+    qreal m_ema;
+    QVector<qreal> m_ring;
+    QVector<qreal> m_sorted;
+};
+
+#endif // CHANNELSMOOTHER_H
@@ -31,6 +31,12 @@
 #include "udpreceiver.h"
 #include "arduino.h"
 #include "wifiscanner.h"
+#include "channelhistory.h"
+#include "dynorun.h"
+#include "trackdatabase.h"
+#include "gpsimufusion.h"
+#include "maptilecache.h"
+#include "mathchannels.h"
 #include <QDebug>
 #include <QTime>
 #include <QTimer>
@@ -68,7 +74,13 @@ Connect::Connect(QObject *parent) :
     m_datalogger(Q_NULLPTR),
     m_calculations(Q_NULLPTR),
     m_arduino(Q_NULLPTR),
-    m_wifiscanner(Q_NULLPTR)
+    m_wifiscanner(Q_NULLPTR),
+    m_channelHistory(Q_NULLPTR),
+    m_dynoRun(Q_NULLPTR),
+    m_mathChannels(Q_NULLPTR),
+    m_trackDatabase(Q_NULLPTR),
+    m_gpsImuFusion(Q_NULLPTR),
+    m_mapTileCache(Q_NULLPTR)
 
 {
 
@@ -76,15 +88,31 @@ Connect::Connect(QObject *parent) :
     m_dashBoard = new DashBoard(this);
     m_appSettings = new AppSettings(this);
     m_gopro = new GoPro(this);
-    m_gps = new GPS(m_dashBoard, this);
+    m_trackDatabase = new TrackDatabase(this);
+    m_trackDatabase->load();
+    m_gps = new GPS(m_dashBoard, m_trackDatabase, this);
+    m_mapTileCache = new MapTileCache(m_trackDatabase, QString(MapTileCache::DEFAULT_DIRECTORY), this);
     m_adaptronicselect= new AdaptronicSelect(m_dashBoard, this);
     m_udpreceiver= new udpreceiver(m_dashBoard, this);
     m_apexi= new Apexi(m_dashBoard, this);
     m_sensors = new Sensors(m_dashBoard, this);
+    m_gpsImuFusion = new GpsImuFusion(m_dashBoard, this);
+    m_gps->setFusion(m_gpsImuFusion);
+    m_sensors->setFusion(m_gpsImuFusion);
     m_datalogger = new datalogger(m_dashBoard, this);
     m_calculations = new calculations(m_dashBoard, this);
+    m_dashBoard->setDerivedChannels(m_calculations->derivedChannels());
     m_arduino = new Arduino(m_dashBoard, this);
     m_wifiscanner = new WifiScanner(m_dashBoard, this);
+    m_channelHistory = new ChannelHistory(this);
+    m_dashBoard->setChannelHistory(m_channelHistory);
+    m_sensors->setChannelHistory(m_channelHistory);
+    m_dynoRun = new DynoRun(m_dashBoard, m_channelHistory, this);
+    m_mathChannels = new MathChannels(m_dashBoard, m_calculations->derivedChannels(), this);
+    connect(m_mathChannels, &MathChannels::channelsChanged, this, [this]() {
+        m_datalogger->setMathChannels(m_mathChannels->outputs(), m_mathChannels->names());
+    });
+    m_mathChannels->load();
    // m_wifiscanner = new WifScanner(this);
     QString mPath = "/";
     // DIRECTORIES
@@ -116,6 +144,13 @@ Connect::Connect(QObject *parent) :
     engine->rootContext()->setContextProperty("Apexi", m_apexi);
     engine->rootContext()->setContextProperty("Arduino", m_arduino);
     engine->rootContext()->setContextProperty("Wifiscanner", m_wifiscanner);
+    engine->rootContext()->setContextProperty("ChannelHistory", m_channelHistory);
+    engine->rootContext()->setContextProperty("Dyno", m_dynoRun);
+    engine->rootContext()->setContextProperty("MathChannels", m_mathChannels);
+    engine->rootContext()->setContextProperty("Tracks", m_trackDatabase);
+    engine->rootContext()->setContextProperty("MapTiles", m_mapTileCache);
+    // the engine owns the provider
+    engine->addImageProvider(QStringLiteral("maptiles"), new MapTileImageProvider(m_mapTileCache));
 
 
 }
@@ -199,6 +234,7 @@ void Connect::readMaindashsetup()
     //QString path = "MainDash.txt";//for Windows
     QString path = "/home/pi/UserDashboards/MainDash.txt";
     QFile inputFile(path);
+    QList<QStringList> dashlines;
     if (inputFile.open(QIODevice::ReadOnly))
     {
         QTextStream in(&inputFile);
@@ -206,10 +242,12 @@ void Connect::readMaindashsetup()
         {
             QString line = in.readLine();
             QStringList list = line.split(QRegExp("\\,"));
+            dashlines.append(list);
             m_dashBoard->setmaindashsetup(list);
         }
         inputFile.close();
     }
+    m_dashBoard->setDashConfig(0, dashlines);
 
 }
 void Connect::readdashsetup3()
@@ -218,6 +256,7 @@ void Connect::readdashsetup3()
     //QString path = dashfilename1;//for Windows
     QString path = "/home/pi/UserDashboards/"+dashfilename3;
     QFile inputFile(path);
+    QList<QStringList> dashlines;
     //QStringList list;
     if (inputFile.open(QIODevice::ReadOnly))
     {
@@ -236,10 +275,12 @@ void Connect::readdashsetup3()
              list = line.split(QRegExp("\\,"));
             }*/
             list.removeAll(QString(""));
+            dashlines.append(list);
             m_dashBoard->setdashsetup3(list);
         }
         inputFile.close();
     }
+    m_dashBoard->setDashConfig(3, dashlines);
 
 }
 void Connect::readdashsetup2()
@@ -248,6 +289,7 @@ void Connect::readdashsetup2()
     //QString path = dashfilename1;//for Windows
     QString path = "/home/pi/UserDashboards/"+dashfilename2;
     QFile inputFile(path);
+    QList<QStringList> dashlines;
     //QStringList list;
     if (inputFile.open(QIODevice::ReadOnly))
     {
@@ -266,10 +308,12 @@ void Connect::readdashsetup2()
              list = line.split(QRegExp("\\,"));
             }*/
             list.removeAll(QString(""));
+            dashlines.append(list);
             m_dashBoard->setdashsetup2(list);
         }
         inputFile.close();
     }
+    m_dashBoard->setDashConfig(2, dashlines);
 
 }
 void Connect::readdashsetup1()
@@ -278,6 +322,7 @@ void Connect::readdashsetup1()
     //QString path = dashfilename1;//for Windows
     QString path = "/home/pi/UserDashboards/"+dashfilename1;
     QFile inputFile(path);
+    QList<QStringList> dashlines;
     //QStringList list;
     if (inputFile.open(QIODevice::ReadOnly))
     {
@@ -296,10 +341,12 @@ void Connect::readdashsetup1()
              list = line.split(QRegExp("\\,"));
             }*/
             list.removeAll(QString(""));
+            dashlines.append(list);
             m_dashBoard->setdashsetup1(list);
         }
         inputFile.close();
     }
+    m_dashBoard->setDashConfig(1, dashlines);
 
 }
 
@@ -372,7 +419,7 @@ void Connect::setWeight(const int &weight)
 
 void Connect::setOdometer(const qreal &Odometer)
 {
-    m_dashBoard->setOdo(Odometer);
+    m_calculations->setOdometer(Odometer);
     m_calculations->start();
 }
 void Connect::qmlTreeviewclicked(const QModelIndex &index)
@@ -1054,6 +1101,8 @@ void Connect::update()
 void Connect::shutdown()
 {
     m_dashBoard->setSerialStat("Shutting Down");
+    m_apexi->saveAutoTuneSession();
+    m_appSettings->sync();
     QProcess *process = new QProcess(this);
     process->start("sudo shutdown -h now");
     process->waitForFinished(100); // 10 minutes time before timeout
@@ -1061,6 +1110,8 @@ void Connect::shutdown()
 void Connect::reboot()
 {
     m_dashBoard->setSerialStat("Rebooting");
+    m_apexi->saveAutoTuneSession();
+    m_appSettings->sync();
     QProcess *process = new QProcess(this);
     process->start("sudo reboot");
     process->waitForFinished(100); // 10 minutes time before timeout
@@ -42,6 +42,12 @@ class GPS;
 class udpreceiver;
 class Arduino;
 class WifiScanner;
+class ChannelHistory;
+class DynoRun;
+class TrackDatabase;
+class GpsImuFusion;
+class MapTileCache;
+class MathChannels;
 
 
 class Connect : public QObject
@@ -112,6 +118,12 @@ private:
     QFileSystemModel *fileModel;
     Arduino *m_arduino;
     WifiScanner *m_wifiscanner;
+    ChannelHistory *m_channelHistory;
+    DynoRun *m_dynoRun;
+    MathChannels *m_mathChannels;
+    TrackDatabase *m_trackDatabase;
+    GpsImuFusion *m_gpsImuFusion;
+    MapTileCache *m_mapTileCache;
 
 
 
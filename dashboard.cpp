@@ -1,12 +1,10 @@
 #include <dashboard.h>
+#include "channelhistory.h"
+#include "derivedchannels.h"
 #include <QStringList>
 #include <QDebug>
-#include <QVector>
+#include <QMetaProperty>
 
-QVector<int>averageSpeed(0);
-QVector<int>averageRPM(0);
-int avgspeed;
-int avgrpm;
 qreal AN00;
 qreal AN05;
 qreal AN10;
@@ -31,6 +29,21 @@ qreal AN100;
 qreal AN105;
 qreal lamdamultiplicator = 1;
 
+// in the order of DashBoard::SmoothedChannel
+const char *const SMOOTHED_CHANNELS[] = {
+    "rpm", "speed", "Intakepress", "Watertemp", "Intaketemp", "BatteryV", "BoostPres",
+    "auxcalc1", "auxcalc2", "auxcalc3", "auxcalc4", "MAP", "FuelPress", "oilpres", "oiltemp",
+    "accely", "Power", "Torque", "fusedSpeed", "lapdelta"
+};
+
+// in the order of DashBoard::SampleChannel
+const char *const SAMPLE_CHANNELS[] = {
+    "rpm", "speed", "Intakepress", "Watertemp", "Intaketemp", "BatteryV", "BoostPres",
+    "auxcalc1", "auxcalc2", "auxcalc3", "auxcalc4", "MAP", "FuelPress", "oilpres", "oiltemp",
+    "accely", "Power", "Torque", "fusedLatitude", "fusedLongitude", "fusedSpeed", "fusedHeading",
+    "lapdelta"
+};
+
 DashBoard::DashBoard(QObject *parent)
     : QObject(parent)
 
@@ -185,6 +198,10 @@ DashBoard::DashBoard(QObject *parent)
     , m_gpsVisibleSatelites (0)
     , m_gpsFIXtype ("no connection")
     , m_gpsbaering (0)
+    , m_fusedLatitude (0)
+    , m_fusedLongitude (0)
+    , m_fusedSpeed (0)
+    , m_fusedHeading (0)
 
 
     //units
@@ -330,6 +347,9 @@ DashBoard::DashBoard(QObject *parent)
     ,  m_laptime("00:00.000")
     ,  m_Lastlaptime("00:00.000")
     ,  m_bestlaptime("00:00.000")
+    ,  m_sectortime("00:00.000")
+    ,  m_currentSector(0)
+    ,  m_lapdelta(0)
     ,  m_draggable(0)
     ,  m_wifi()
     ,  m_Analog0(0)
@@ -361,9 +381,34 @@ DashBoard::DashBoard(QObject *parent)
     ,  m_Userchannel4()
     ,  m_FuelLevel()
     ,  m_SteeringWheelAngle()
-
-{
-
+    ,  m_Mathchannel1()
+    ,  m_Mathchannel2()
+    ,  m_Mathchannel3()
+    ,  m_Mathchannel4()
+    ,  m_Mathchannel5()
+    ,  m_Mathchannel6()
+    ,  m_Mathchannel7()
+    ,  m_Mathchannel8()
+
+{
+    m_channelHistory = Q_NULLPTR;
+    m_derivedChannels = Q_NULLPTR;
+    m_sampleTime = -1;
+    m_ecuSampleTime = -1;
+    for (int i = 0; i < SampleChannelCount; i++)
+    {
+        m_historySlots[i] = -1;
+        m_derivedInputs[i] = -1;
+        m_notifyFiltered[i] = false;
+    }
+    m_notifyFlushTimer = new QTimer(this);
+    connect(m_notifyFlushTimer, &QTimer::timeout, this, &DashBoard::flushNotifications);
+    m_dashConfig.resize(4);
+    for (int i = 0; i < SmoothedChannelCount; i++)
+    {
+        m_smoothingMode[i] = ChannelSmoother::None;
+        m_smoothingWindow[i] = 0;
+    }
 }
 
 
@@ -415,31 +460,26 @@ void DashBoard::setAnalogVal(const qreal &A00,const qreal &A05,const qreal &A10,
 // Advanced Info FD3S
 void DashBoard::setrpm(const qreal &rpm)
 {
-    if (m_rpm == rpm)
-        return;
-    m_rpm = rpm;
-
     //Smoothing
-    if (m_smoothrpm >0)
-    {
-        averageRPM.removeFirst();
-        averageRPM.append(m_rpm);
-        avgrpm = 0;
-        for (int i = 0; i <= m_smoothrpm-1; i++){avgrpm+= averageRPM[i];}
-        m_rpm = avgrpm/m_smoothrpm;
-    }
-    emit rpmChanged(rpm);
+    const qreal value = smoothed(SmoothRpm, rpm);
+    m_ecuSampleTime = sampleTime();
+    recordSample(SampleRpm, value);
+    if (m_rpm == value)
+        return;
+    m_rpm = value;
+    if (shouldNotify(SampleRpm, m_rpm))
+        emit rpmChanged(m_rpm);
 }
 
 void DashBoard::setIntakepress(const qreal &Intakepress)
 {
-    if (m_Intakepress == Intakepress)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Pressure, smoothed(SmoothIntakepress, Intakepress));
+    recordSample(SampleIntakepress, value);
+    if (m_Intakepress == value)
         return;
-    if (m_pressureunits == "metric")
-    {m_Intakepress = Intakepress;}
-    if (m_pressureunits == "imperial")
-    {m_Intakepress = Intakepress * 0.145038;}
-    emit intakepressChanged(Intakepress);    
+    m_Intakepress = value;
+    if (shouldNotify(SampleIntakepress, m_Intakepress))
+        emit intakepressChanged(m_Intakepress);    
     return;
 }
 
@@ -495,10 +535,7 @@ void DashBoard::setFueltemp(const qreal &Fueltemp)
 {
     if (m_Fueltemp == Fueltemp)
         return;
-    if (m_units == "metric")
-    {m_Fueltemp = Fueltemp;}
-    if (m_units == "imperial")
-    {m_Fueltemp = Fueltemp * 1.8 + 32;}
+    m_Fueltemp = m_unitConversion.convert(UnitConversionPlan::Temperature, Fueltemp);
     emit fueltempChanged(Fueltemp);
 }
 
@@ -528,24 +565,22 @@ void DashBoard::setBoostwg(const qreal &Boostwg)
 
 void DashBoard::setWatertemp(const qreal &Watertemp)
 {
-    if (m_Watertemp == Watertemp)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Temperature, smoothed(SmoothWatertemp, Watertemp));
+    recordSample(SampleWatertemp, value);
+    if (m_Watertemp == value)
         return;
-    if (m_units == "metric")
-    {m_Watertemp = Watertemp;}
-    if (m_units == "imperial")
-    {m_Watertemp = Watertemp * 1.8 + 32;}
-
-    emit watertempChanged(Watertemp);
+    m_Watertemp = value;
+    if (shouldNotify(SampleWatertemp, m_Watertemp))
+        emit watertempChanged(m_Watertemp);
 }
 
 void DashBoard::setIntaketemp(const qreal &Intaketemp)
 {
-    if (m_units == "metric")
-    { m_Intaketemp = Intaketemp;}
-    if (m_units == "imperial")
-    {m_Intaketemp = Intaketemp * 1.8 + 32;}
-
-    emit intaketempChanged(Intaketemp);
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Temperature, smoothed(SmoothIntaketemp, Intaketemp));
+    recordSample(SampleIntaketemp, value);
+    m_Intaketemp = value;
+    if (shouldNotify(SampleIntaketemp, m_Intaketemp))
+        emit intaketempChanged(m_Intaketemp);
 }
 
 void DashBoard::setKnock(const qreal &Knock)
@@ -558,32 +593,25 @@ void DashBoard::setKnock(const qreal &Knock)
 
 void DashBoard::setBatteryV(const qreal &BatteryV)
 {
-    if (m_BatteryV == BatteryV)
+    const qreal value = smoothed(SmoothBatteryV, BatteryV);
+    recordSample(SampleBatteryV, value);
+    if (m_BatteryV == value)
         return;
-    m_BatteryV = BatteryV;
-    emit batteryVChanged(BatteryV);
+    m_BatteryV = value;
+    if (shouldNotify(SampleBatteryV, m_BatteryV))
+        emit batteryVChanged(m_BatteryV);
 }
 
 void DashBoard::setSpeed(const qreal &speed)
 {
     //qDebug()<< "SPEED" << m_speed;
-    if (m_speed == speed)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, smoothed(SmoothSpeed, speed));
+    if (m_ExternalSpeed == 0)
+        recordSample(SampleSpeed, value);
+    if (m_speed == qRound(value))
         return;
-    if (m_speedunits == "metric")
-    {m_speed = qRound(speed * m_speedpercent);}
-    if (m_speedunits == "imperial")
-    {m_speed = qRound((speed * 0.621371) * m_speedpercent);}
-    if (m_smoothspeed != 0)
-    {
-        averageSpeed.removeFirst();
-        averageSpeed.append(m_speed);
-        //qDebug() << "Vector Speed " << averageSpeed;
-        avgspeed = 0;
-        for (int i = 0; i <= m_smoothspeed-1; i++){avgspeed+= averageSpeed[i];}
-        m_speed = avgspeed/m_smoothspeed;
-        // qDebug() << "Average Speed " << m_speed;
-    }
-if (m_ExternalSpeed == 0){
+    m_speed = qRound(value);
+if (m_ExternalSpeed == 0 && shouldNotify(SampleSpeed, m_speed)){
     emit speedChanged(m_speed);
 }
 }
@@ -684,24 +712,15 @@ void DashBoard::setDwell(const qreal &Dwell)
 
 void DashBoard::setBoostPres(const qreal &BoostPres)
 {
-    if (m_BoostPres == BoostPres)
+    const qreal smoothedValue = smoothed(SmoothBoostPres, BoostPres);
+    // vacuum and boost are reported in different units
+    const qreal value = m_unitConversion.convert(smoothedValue <= 0 ? UnitConversionPlan::BoostVacuum : UnitConversionPlan::BoostPressure, smoothedValue);
+    recordSample(SampleBoostPres, value);
+    if (m_BoostPres == value)
         return;
-    if (m_pressureunits == "metric")
-    {m_BoostPres = BoostPres;}
-    if (m_pressureunits == "imperial")
-    {
-        if (BoostPres <= 0)
-        {m_BoostPres = BoostPres * 0.039370079197446;}
-        if (BoostPres > 0)
-        {
-        qreal temp;
-        temp = BoostPres * 142.233;
-        m_BoostPres = (temp/10);
-        }
-    }
-    emit boostPresChanged(BoostPres);
-
-
+    m_BoostPres = value;
+    if (shouldNotify(SampleBoostPres, m_BoostPres))
+        emit boostPresChanged(m_BoostPres);
 }
 
 void DashBoard::setBoostDuty(const qreal &BoostDuty)
@@ -759,34 +778,46 @@ void DashBoard::setpim(const qreal &pim)
 
 void DashBoard::setauxcalc1(const qreal &auxcalc1)
 {
-    if (m_auxcalc1 == auxcalc1)
+    const qreal value = smoothed(SmoothAuxcalc1, auxcalc1);
+    recordSample(SampleAuxcalc1, value);
+    if (m_auxcalc1 == value)
         return;
-    m_auxcalc1 = auxcalc1;
-    emit auxcalc1Changed(auxcalc1);
+    m_auxcalc1 = value;
+    if (shouldNotify(SampleAuxcalc1, m_auxcalc1))
+        emit auxcalc1Changed(m_auxcalc1);
 }
 
 void DashBoard::setauxcalc2(const qreal &auxcalc2)
 {
-    if (m_auxcalc2 == auxcalc2)
+    const qreal value = smoothed(SmoothAuxcalc2, auxcalc2);
+    recordSample(SampleAuxcalc2, value);
+    if (m_auxcalc2 == value)
         return;
-    m_auxcalc2 = auxcalc2;
-    emit auxcalc2Changed(auxcalc2);
+    m_auxcalc2 = value;
+    if (shouldNotify(SampleAuxcalc2, m_auxcalc2))
+        emit auxcalc2Changed(m_auxcalc2);
 }
 
 void DashBoard::setauxcalc3(const qreal &auxcalc3)
 {
-    if (m_auxcalc3 == auxcalc3)
+    const qreal value = smoothed(SmoothAuxcalc3, auxcalc3);
+    recordSample(SampleAuxcalc3, value);
+    if (m_auxcalc3 == value)
         return;
-    m_auxcalc3 = auxcalc3;
-    emit auxcalc3Changed(auxcalc3);
+    m_auxcalc3 = value;
+    if (shouldNotify(SampleAuxcalc3, m_auxcalc3))
+        emit auxcalc3Changed(m_auxcalc3);
 }
 
 void DashBoard::setauxcalc4(const qreal &auxcalc4)
 {
-    if (m_auxcalc4 == auxcalc4)
+    const qreal value = smoothed(SmoothAuxcalc4, auxcalc4);
+    recordSample(SampleAuxcalc4, value);
+    if (m_auxcalc4 == value)
         return;
-    m_auxcalc4 = auxcalc4;
-    emit auxcalc4Changed(auxcalc4);
+    m_auxcalc4 = value;
+    if (shouldNotify(SampleAuxcalc4, m_auxcalc4))
+        emit auxcalc4Changed(m_auxcalc4);
 }
 
 
@@ -1346,14 +1377,13 @@ void DashBoard::setgpsLongitude(const double &gpsLongitude)
 
 void DashBoard::setgpsSpeed(const double &gpsSpeed)
 {
+    if (m_ExternalSpeed == 5)
+        recordSample(SampleSpeed, m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, gpsSpeed));
     if (m_gpsSpeed == gpsSpeed)
         return;
     m_gpsSpeed = gpsSpeed;
 
-    if (m_speedunits == "metric")
-    {m_speed = qRound(gpsSpeed * m_speedpercent);}
-    if (m_speedunits == "imperial")
-    {m_speed = qRound((gpsSpeed * 0.621371) * m_speedpercent);}
+    m_speed = qRound(m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, gpsSpeed));
 
     emit gpsSpeedChanged(gpsSpeed);
 
@@ -1384,6 +1414,43 @@ void DashBoard::setgpsbaering(const qreal &gpsbaering)
     m_gpsbaering = gpsbaering;
     emit gpsbaeringChanged(gpsbaering);
 }
+void DashBoard::setfusedLatitude(const double &fusedLatitude)
+{
+    recordSample(SampleFusedLatitude, fusedLatitude);
+    if (m_fusedLatitude == fusedLatitude)
+        return;
+    m_fusedLatitude = fusedLatitude;
+    if (shouldNotify(SampleFusedLatitude, m_fusedLatitude))
+        emit fusedLatitudeChanged(m_fusedLatitude);
+}
+void DashBoard::setfusedLongitude(const double &fusedLongitude)
+{
+    recordSample(SampleFusedLongitude, fusedLongitude);
+    if (m_fusedLongitude == fusedLongitude)
+        return;
+    m_fusedLongitude = fusedLongitude;
+    if (shouldNotify(SampleFusedLongitude, m_fusedLongitude))
+        emit fusedLongitudeChanged(m_fusedLongitude);
+}
+void DashBoard::setfusedSpeed(const qreal &fusedSpeed)
+{
+    const qreal value = smoothed(SmoothFusedSpeed, fusedSpeed);
+    recordSample(SampleFusedSpeed, value);
+    if (m_fusedSpeed == value)
+        return;
+    m_fusedSpeed = value;
+    if (shouldNotify(SampleFusedSpeed, m_fusedSpeed))
+        emit fusedSpeedChanged(m_fusedSpeed);
+}
+void DashBoard::setfusedHeading(const qreal &fusedHeading)
+{
+    recordSample(SampleFusedHeading, fusedHeading);
+    if (m_fusedHeading == fusedHeading)
+        return;
+    m_fusedHeading = fusedHeading;
+    if (shouldNotify(SampleFusedHeading, m_fusedHeading))
+        emit fusedHeadingChanged(m_fusedHeading);
+}
 
 
 // Units
@@ -1392,6 +1459,7 @@ void DashBoard::setunits (const QString &units)
     if (m_units == units)
         return;
     m_units = units;
+    m_unitConversion.setTemperatureUnits(units);
     emit unitsChanged(units);
 }
 void DashBoard::setspeedunits (const QString &speedunits)
@@ -1399,6 +1467,7 @@ void DashBoard::setspeedunits (const QString &speedunits)
     if (m_speedunits == speedunits)
         return;
     m_speedunits = speedunits;
+    m_unitConversion.setSpeedUnits(speedunits);
     emit speedunitsChanged(speedunits);
 }
 
@@ -1407,6 +1476,7 @@ void DashBoard::setpressureunits (const QString &pressureunits)
     if (m_pressureunits == pressureunits)
         return;
     m_pressureunits = pressureunits;
+    m_unitConversion.setPressureUnits(pressureunits);
     emit pressureunitsChanged(pressureunits);
 }
 //Adaptronic extra
@@ -1414,11 +1484,11 @@ void DashBoard::setpressureunits (const QString &pressureunits)
 
 void DashBoard::setMAP(const qreal &MAP)
 {
-    if (m_pressureunits == "metric")
-    { m_MAP = MAP;}
-    if (m_pressureunits == "imperial")
-    {m_MAP = MAP * 0.145038;}
-    emit mAPChanged(MAP);
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Pressure, smoothed(SmoothMAP, MAP));
+    recordSample(SampleMAP, value);
+    m_MAP = value;
+    if (shouldNotify(SampleMAP, m_MAP))
+        emit mAPChanged(m_MAP);
 }
 
 void DashBoard::setAUXT(const qreal &AUXT)
@@ -1457,10 +1527,7 @@ void DashBoard::setMVSS(const qreal &MVSS)
 {
     if (m_MVSS == MVSS)
         return;
-    if (m_speedunits == "metric")
-    { m_MVSS= MVSS;}
-    if (m_speedunits == "imperial")
-    {m_MVSS = qRound(MVSS * 0.621371);}
+    m_MVSS = m_unitConversion.convert(UnitConversionPlan::Speed, MVSS);
 
     emit mVSSChanged(MVSS);
 }
@@ -1469,10 +1536,7 @@ void DashBoard::setSVSS(const qreal &SVSS)
 {
     if (m_SVSS == SVSS)
         return;
-    if (m_speedunits == "metric")
-    { m_SVSS= SVSS;}
-    if (m_speedunits == "imperial")
-    {m_SVSS = qRound(SVSS * 0.621371);}
+    m_SVSS = m_unitConversion.convert(UnitConversionPlan::Speed, SVSS);
     emit sVSSChanged(SVSS);
 }
 
@@ -1566,13 +1630,13 @@ void DashBoard::setLAMBDATarget(const qreal &LAMBDATarget)
 
 void DashBoard::setFuelPress(const qreal &FuelPress)
 {
-    if(m_FuelPress == FuelPress)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Pressure, smoothed(SmoothFuelPress, FuelPress));
+    recordSample(SampleFuelPress, value);
+    if (m_FuelPress == value)
         return;
-    if (m_pressureunits == "metric")
-    { m_FuelPress = FuelPress;}
-    if (m_pressureunits == "imperial")
-    {m_FuelPress = FuelPress * 0.145038;}
-    emit fuelPressChanged(FuelPress);
+    m_FuelPress = value;
+    if (shouldNotify(SampleFuelPress, m_FuelPress))
+        emit fuelPressChanged(m_FuelPress);
 }
 
 
@@ -1586,10 +1650,13 @@ void DashBoard::setaccelx(const qreal &accelx)
 }
 void DashBoard::setaccely(const qreal &accely)
 {
-    if (m_accely == accely)
+    const qreal value = smoothed(SmoothAccely, accely);
+    recordSample(SampleAccely, value);
+    if (m_accely == value)
         return;
-    m_accely = accely;
-    emit accelyChanged(accely);
+    m_accely = value;
+    if (shouldNotify(SampleAccely, m_accely))
+        emit accelyChanged(m_accely);
 }
 void DashBoard::setaccelz(const qreal &accelz)
 {
@@ -1630,20 +1697,14 @@ void DashBoard::setambitemp(const qreal &ambitemp)
 {
     if (m_ambitemp == ambitemp)
         return;
-    if (m_pressureunits == "metric")
-    { m_ambitemp = ambitemp;}
-    if (m_pressureunits == "imperial")
-    {m_ambitemp = ambitemp * 1.8 + 32;}
+    m_ambitemp = m_unitConversion.convert(UnitConversionPlan::Temperature, ambitemp);
     emit ambitempChanged(ambitemp);
 }
 void DashBoard::setambipress(const qreal &ambipress)
 {
     if (m_ambipress == ambipress)
         return;
-    if (m_pressureunits == "metric")
-    { m_ambipress = ambipress;}
-    if (m_pressureunits == "imperial")
-    {m_ambipress = ambipress * 0.145038;}
+    m_ambipress = m_unitConversion.convert(UnitConversionPlan::Pressure, ambipress);
     emit ambipressChanged(ambipress);
 }
 
@@ -1658,17 +1719,23 @@ void DashBoard::setGear(const qreal &Gear)
 }
 void DashBoard::setPower(const qreal &Power)
 {
-    if (m_Power == Power)
+    const qreal value = smoothed(SmoothPower, Power);
+    recordSample(SamplePower, value);
+    if (m_Power == value)
         return;
-    m_Power = Power;
-    emit powerChanged(Power);
+    m_Power = value;
+    if (shouldNotify(SamplePower, m_Power))
+        emit powerChanged(m_Power);
 }
 void DashBoard::setTorque(const qreal &Torque)
 {
-    if (m_Torque == Torque)
+    const qreal value = smoothed(SmoothTorque, Torque);
+    recordSample(SampleTorque, value);
+    if (m_Torque == value)
         return;
-    m_Torque = Torque;
-    emit torqueChanged(Torque);
+    m_Torque = value;
+    if (shouldNotify(SampleTorque, m_Torque))
+        emit torqueChanged(m_Torque);
 }
 void DashBoard::setAccelTimer(const qreal &AccelTimer)
 {
@@ -1755,10 +1822,7 @@ void DashBoard::setairtempensor2(const qreal &airtempensor2)
 {
     if (m_airtempensor2 == airtempensor2)
         return;
-    if (m_units == "metric")
-    {m_airtempensor2 = airtempensor2;}
-    if (m_units == "imperial")
-    {m_airtempensor2 = airtempensor2 * 1.8 + 32;}
+    m_airtempensor2 = m_unitConversion.convert(UnitConversionPlan::Temperature, airtempensor2);
     emit airtempensor2Changed(airtempensor2);
 }
 void DashBoard::setantilaglauchswitch(const qreal &antilaglauchswitch)
@@ -1807,10 +1871,7 @@ void DashBoard::setbrakepress(const qreal &brakepress)
 {
     if (m_brakepress == brakepress)
         return;
-    if (m_pressureunits == "metric")
-    { m_brakepress = brakepress;}
-    if (m_pressureunits == "imperial")
-    {m_brakepress = brakepress * 0.145038;}
+    m_brakepress = m_unitConversion.convert(UnitConversionPlan::Pressure, brakepress);
     emit brakepressChanged(brakepress);
 }
 void DashBoard::setclutchswitchstate(const qreal &clutchswitchstate)
@@ -1824,10 +1885,7 @@ void DashBoard::setcoolantpress(const qreal &coolantpress)
 {
     if (m_coolantpress == coolantpress)
         return;
-    if (m_pressureunits == "metric")
-    { m_coolantpress = coolantpress;}
-    if (m_pressureunits == "imperial")
-    {m_coolantpress = coolantpress * 0.145038;}
+    m_coolantpress = m_unitConversion.convert(UnitConversionPlan::Pressure, coolantpress);
     emit coolantpressChanged(coolantpress);
 }
 void DashBoard::setdecelcut(const qreal &decelcut)
@@ -1841,10 +1899,7 @@ void DashBoard::setdiffoiltemp(const qreal &diffoiltemp)
 {
     if (m_diffoiltemp == diffoiltemp)
         return;
-    if (m_units == "metric")
-    {m_diffoiltemp = diffoiltemp;}
-    if (m_units == "imperial")
-    {m_diffoiltemp = diffoiltemp * 1.8 + 32;}
+    m_diffoiltemp = m_unitConversion.convert(UnitConversionPlan::Temperature, diffoiltemp);
     emit diffoiltempChanged(diffoiltemp);
 }
 void DashBoard::setdistancetoempty(const qreal &distancetoempty)
@@ -1858,120 +1913,84 @@ void DashBoard::setegt1(const qreal &egt1)
 {
     if (m_egt1 == egt1)
         return;
-    if (m_units == "metric")
-    {m_egt1 = egt1;}
-    if (m_units == "imperial")
-    {m_egt1 = qRound(egt1 * 1.8 + 32);}
+    m_egt1 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt1);
     emit egt1Changed(egt1);
 }
 void DashBoard::setegt2(const qreal &egt2)
 {
     if (m_egt2 == egt2)
         return;
-    if (m_units == "metric")
-    {m_egt2 = egt2;}
-    if (m_units == "imperial")
-    {m_egt2 = qRound(egt2 * 1.8 + 32);}
+    m_egt2 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt2);
     emit egt2Changed(egt2);
 }
 void DashBoard::setegt3(const qreal &egt3)
 {
     if (m_egt3 == egt3)
         return;
-    if (m_units == "metric")
-    {m_egt3 = egt3;}
-    if (m_units == "imperial")
-    {m_egt3 = qRound(egt3 * 1.8 + 32);}
+    m_egt3 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt3);
     emit egt3Changed(egt3);
 }
 void DashBoard::setegt4(const qreal &egt4)
 {
     if (m_egt4 == egt4)
         return;
-    if (m_units == "metric")
-    {m_egt4 = egt4;}
-    if (m_units == "imperial")
-    {m_egt4 = qRound(egt4 * 1.8 + 32);}
+    m_egt4 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt4);
     emit egt4Changed(egt4);
 }
 void DashBoard::setegt5(const qreal &egt5)
 {
     if (m_egt5 == egt5)
         return;
-    if (m_units == "metric")
-    {m_egt5 = egt5;}
-    if (m_units == "imperial")
-    {m_egt5 = qRound(egt5 * 1.8 + 32);}
+    m_egt5 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt5);
     emit egt5Changed(egt5);
 }
 void DashBoard::setegt6(const qreal &egt6)
 {
     if (m_egt6 == egt6)
         return;
-    if (m_units == "metric")
-    {m_egt6 = egt6;}
-    if (m_units == "imperial")
-    {m_egt6 = qRound(egt6 * 1.8 + 32);}
+    m_egt6 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt6);
     emit egt6Changed(egt6);
 }
 void DashBoard::setegt7(const qreal &egt7)
 {
     if (m_egt7 == egt7)
         return;
-    if (m_units == "metric")
-    {m_egt7 = egt7;}
-    if (m_units == "imperial")
-    {m_egt7 = qRound(egt7 * 1.8 + 32);}
+    m_egt7 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt7);
     emit egt7Changed(egt7);
 }
 void DashBoard::setegt8(const qreal &egt8)
 {
     if (m_egt8 == egt8)
         return;
-    if (m_units == "metric")
-    {m_egt8 = egt8;}
-    if (m_units == "imperial")
-    {m_egt8 = qRound(egt8 * 1.8 + 32);}
+    m_egt8 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt8);
     emit egt8Changed(egt8);
 }
 void DashBoard::setegt9(const qreal &egt9)
 {
     if (m_egt9 == egt9)
         return;
-    if (m_units == "metric")
-    {m_egt9 = egt9;}
-    if (m_units == "imperial")
-    {m_egt9 = qRound(egt9 * 1.8 + 32);}
+    m_egt9 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt9);
     emit egt9Changed(egt9);
 }
 void DashBoard::setegt10(const qreal &egt10)
 {
     if (m_egt10 == egt10)
         return;
-    if (m_units == "metric")
-    {m_egt10 = egt10;}
-    if (m_units == "imperial")
-    {m_egt10 = qRound(egt10 * 1.8 + 32);}
+    m_egt10 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt10);
     emit egt10Changed(egt10);
 }
 void DashBoard::setegt11(const qreal &egt11)
 {
     if (m_egt11 == egt11)
         return;
-    if (m_units == "metric")
-    {m_egt11 = egt11;}
-    if (m_units == "imperial")
-    {m_egt11 = qRound(egt11 * 1.8 + 32);}
+    m_egt11 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt11);
     emit egt11Changed(egt11);
 }
 void DashBoard::setegt12(const qreal &egt12)
 {
     if (m_egt12 == egt12)
         return;
-    if (m_units == "metric")
-    {m_egt12 = egt12;}
-    if (m_units == "imperial")
-    {m_egt12 = qRound(egt12 * 1.8 + 32);}
+    m_egt12 = m_unitConversion.convert(UnitConversionPlan::Temperature, egt12);
     emit egt12Changed(egt12);
 }
 void DashBoard::setexcamangle1(const qreal &excamangle1)
@@ -2231,10 +2250,7 @@ void DashBoard::setnospress(const qreal &nospress)
 {
     if (m_nospress == nospress)
         return;
-    if (m_pressureunits == "metric")
-    { m_nospress = nospress;}
-    if (m_pressureunits == "imperial")
-    {m_nospress = nospress * 0.145038;}
+    m_nospress = m_unitConversion.convert(UnitConversionPlan::Pressure, nospress);
     emit nospressChanged(nospress);
 }
 void DashBoard::setnosswitch(const qreal &nosswitch)
@@ -2246,23 +2262,23 @@ void DashBoard::setnosswitch(const qreal &nosswitch)
 }
 void DashBoard::setoilpres(const qreal &oilpres)
 {
-    if (m_oilpres == oilpres)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Pressure, smoothed(SmoothOilpres, oilpres));
+    recordSample(SampleOilpres, value);
+    if (m_oilpres == value)
         return;
-    if (m_pressureunits == "metric")
-    { m_oilpres = oilpres;}
-    if (m_pressureunits == "imperial")
-    {m_oilpres = oilpres * 0.145038;}
-    emit oilpresChanged(oilpres);
+    m_oilpres = value;
+    if (shouldNotify(SampleOilpres, m_oilpres))
+        emit oilpresChanged(m_oilpres);
 }
 void DashBoard::setoiltemp(const qreal &oiltemp)
 {
-    if (m_oiltemp == oiltemp)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::Temperature, smoothed(SmoothOiltemp, oiltemp));
+    recordSample(SampleOiltemp, value);
+    if (m_oiltemp == value)
         return;
-    if (m_units == "metric")
-    {m_oiltemp = oiltemp;}
-    if (m_units == "imperial")
-    {m_oiltemp = oiltemp * 1.8 + 32;}
-    emit oiltempChanged(oiltemp);
+    m_oiltemp = value;
+    if (shouldNotify(SampleOiltemp, m_oiltemp))
+        emit oiltempChanged(m_oiltemp);
 }
 void DashBoard::setrallyantilagswitch(const qreal &rallyantilagswitch)
 {
@@ -2331,10 +2347,7 @@ void DashBoard::settransoiltemp(const qreal &transoiltemp)
 {
     if (m_transoiltemp == transoiltemp)
         return;
-    if (m_units == "metric")
-    {m_transoiltemp = transoiltemp;}
-    if (m_units == "imperial")
-    {m_transoiltemp = transoiltemp * 1.8 + 32;}
+    m_transoiltemp = m_unitConversion.convert(UnitConversionPlan::Temperature, transoiltemp);
     emit transoiltempChanged(transoiltemp);
 }
 void DashBoard::settriggerccounter(const qreal &triggerccounter)
@@ -2362,41 +2375,31 @@ void DashBoard::setwastegatepress(const qreal &wastegatepress)
 {
     if (m_wastegatepress == wastegatepress)
         return;
-    if (m_units == "metric")
-    { m_wastegatepress = wastegatepress;}
-    if (m_units == "imperial")
-    {m_wastegatepress = wastegatepress * 0.145038;}
+    m_wastegatepress = m_unitConversion.convert(UnitConversionPlan::Pressure, wastegatepress);
     emit wastegatepressChanged(wastegatepress);
 }
 void DashBoard::setwheeldiff(const qreal &wheeldiff)
 {
     if (m_wheeldiff == wheeldiff)
         return;
-    if (m_speedunits == "metric")
-    {m_wheeldiff = wheeldiff * m_speedpercent;}
-    if (m_speedunits == "imperial")
-    {m_wheeldiff = qRound((wheeldiff * 0.621371) * m_speedpercent);}
+    m_wheeldiff = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, wheeldiff);
     emit wheeldiffChanged(wheeldiff);
 }
 void DashBoard::setwheelslip(const qreal &wheelslip)
 {
     if (m_wheelslip == wheelslip)
         return;
-    if (m_speedunits == "metric")
-    {m_wheelslip = wheelslip * m_speedpercent;}
-    if (m_speedunits == "imperial")
-    {m_wheelslip = qRound((wheelslip * 0.621371) * m_speedpercent);}
+    m_wheelslip = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, wheelslip);
     emit wheelslipChanged(m_wheelslip);
 }
 void DashBoard::setwheelspdftleft(const qreal &wheelspdftleft)
 {
-    if (m_wheelspdftleft == wheelspdftleft)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, wheelspdftleft);
+    if (m_ExternalSpeed == 1)
+        recordSample(SampleSpeed, value);
+    if (m_wheelspdftleft == value)
         return;
-    m_wheelspdftleft = wheelspdftleft * m_speedpercent;
-    if (m_speedunits == "metric")
-    {m_wheelspdftleft = wheelspdftleft * m_speedpercent;}
-    if (m_speedunits == "imperial")
-    {m_wheelspdftleft = qRound((wheelspdftleft * 0.621371) * m_speedpercent);}
+    m_wheelspdftleft = value;
     emit wheelspdftleftChanged(m_wheelspdftleft);
     if (m_ExternalSpeed == 1){
     m_speed = m_wheelspdftleft;
@@ -2406,13 +2409,12 @@ void DashBoard::setwheelspdftleft(const qreal &wheelspdftleft)
 }
 void DashBoard::setwheelspdftright(const qreal &wheelspdftright)
 {
-    if (m_wheelspdftright == wheelspdftright)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, wheelspdftright);
+    if (m_ExternalSpeed == 2)
+        recordSample(SampleSpeed, value);
+    if (m_wheelspdftright == value)
         return;
-    m_wheelspdftright = wheelspdftright * m_speedpercent;
-    if (m_speedunits == "metric")
-    {m_wheelspdftright = wheelspdftright * m_speedpercent;}
-    if (m_speedunits == "imperial")
-    {m_wheelspdftright = qRound((wheelspdftright * 0.621371) * m_speedpercent);}
+    m_wheelspdftright = value;
     emit wheelspdftrightChanged(m_wheelspdftright);
     if (m_ExternalSpeed == 2){
         m_speed = m_wheelspdftright;
@@ -2422,13 +2424,12 @@ void DashBoard::setwheelspdftright(const qreal &wheelspdftright)
 
 void DashBoard::setwheelspdrearleft(const qreal &wheelspdrearleft)
 {
-    if (m_wheelspdrearleft == wheelspdrearleft)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, wheelspdrearleft);
+    if (m_ExternalSpeed == 3)
+        recordSample(SampleSpeed, value);
+    if (m_wheelspdrearleft == value)
         return;
-    m_wheelspdrearleft = wheelspdrearleft * m_speedpercent;
-    if (m_speedunits == "metric")
-    {m_wheelspdrearleft = wheelspdrearleft * m_speedpercent;}
-    if (m_speedunits == "imperial")
-    {m_wheelspdrearleft = qRound((wheelspdrearleft * 0.621371) * m_speedpercent);}
+    m_wheelspdrearleft = value;
     emit wheelspdrearleftChanged(wheelspdrearleft);
     if (m_ExternalSpeed == 3){
         m_speed = m_wheelspdrearleft;
@@ -2437,13 +2438,12 @@ void DashBoard::setwheelspdrearleft(const qreal &wheelspdrearleft)
 }
 void DashBoard::setwheelspdrearright(const qreal &wheelspdrearright)
 {
-    if (m_wheelspdrearright == wheelspdrearright)
+    const qreal value = m_unitConversion.convert(UnitConversionPlan::CorrectedSpeed, wheelspdrearright);
+    if (m_ExternalSpeed == 4)
+        recordSample(SampleSpeed, value);
+    if (m_wheelspdrearright == value)
         return;
-    m_wheelspdrearright = wheelspdrearright* m_speedpercent;
-    if (m_speedunits == "metric")
-    {m_wheelspdrearright = wheelspdrearright * m_speedpercent;}
-    if (m_speedunits == "imperial")
-    {m_wheelspdrearright = qRound((wheelspdrearright * 0.621371) * m_speedpercent);}
+    m_wheelspdrearright = value;
     emit wheelspdrearrightChanged(m_wheelspdrearright);
     if (m_ExternalSpeed == 4){
         m_speed = m_wheelspdrearright;
@@ -2469,6 +2469,7 @@ void DashBoard::setspeedpercent(const qreal &speedpercent)
     if (m_speedpercent == speedpercent)
         return;
     m_speedpercent = speedpercent;
+    m_unitConversion.setSpeedCorrection(speedpercent);
     emit speedpercentChanged(speedpercent);
 }
 
@@ -2548,7 +2549,7 @@ void DashBoard::setsmoothrpm(const int &smoothrpm)
     {m_smoothrpm = smoothrpm+1;}
     else {m_smoothrpm = smoothrpm;}
     //qDebug()<<"SmoothRPM" << m_smoothrpm;
-    averageRPM.resize(m_smoothrpm);
+    setSmoothing(QStringLiteral("rpm"), QStringLiteral("average"), m_smoothrpm);
     emit smoothrpmChanged(smoothrpm);
 }
 void DashBoard::setsmoothspeed(const int &smoothspeed)
@@ -2558,11 +2559,209 @@ void DashBoard::setsmoothspeed(const int &smoothspeed)
     if (smoothspeed != 0)
     {m_smoothspeed = smoothspeed+1;}
     else {m_smoothspeed = smoothspeed;}
-    averageSpeed.resize(m_smoothspeed);
+    setSmoothing(QStringLiteral("speed"), QStringLiteral("average"), m_smoothspeed);
     //qDebug()<<"SmoothSpeed" << m_smoothrpm;
     emit smoothspeedChanged(smoothspeed);
 }
 
+// Attaches a smoother to a channel (the property name, ex. "oilpres", one of SMOOTHED_CHANNELS)
+// mode: "average", "ema", "median" or "none" to remove it
+void DashBoard::setSmoothing(const QString &channel, const QString &mode, const int &window)
+{
+    const int index = smoothedChannel(channel);
+    if (index < 0)
+    {
+        qWarning() << "Channel" << channel << "can not be smoothed";
+        return;
+    }
+    m_smoothingMode[index] = ChannelSmoother::modeFromString(mode);
+    m_smoothingWindow[index] = window;
+    configureSmoother(index, m_smoothingMode[index], window);
+}
+
+int DashBoard::smoothedChannel(const QString &channel)
+{
+    for (int i = 0; i < SmoothedChannelCount; i++)
+    {
+        if (channel == QLatin1String(SMOOTHED_CHANNELS[i]))
+        {return i;}
+    }
+    return -1;
+}
+
+// Keeps the values of the smoother when its configuration did not change
+void DashBoard::configureSmoother(int channel, ChannelSmoother::Mode mode, int window)
+{
+    if (mode == ChannelSmoother::None || window < 2)
+    {
+        mode = ChannelSmoother::None;
+        window = 0;
+    }
+    ChannelSmoother &smoother = m_smoothers[channel];
+    if (smoother.mode() != mode || smoother.window() != window)
+    {smoother.configure(mode, window);}
+}
+
+int DashBoard::sampleChannel(const QString &channel)
+{
+    for (int i = 0; i < SampleChannelCount; i++)
+    {
+        if (channel == QLatin1String(SAMPLE_CHANNELS[i]))
+        {return i;}
+    }
+    return -1;
+}
+
+// Change notifications of a channel (one of SAMPLE_CHANNELS) are only sent when the change is visible
+// deadband: minimum change, decimals: displayed decimals (-1 for none), maxRate: notifications per second (0 for unlimited)
+void DashBoard::setNotifyFilter(const QString &channel, const qreal &deadband, const int &decimals, const qreal &maxRate)
+{
+    const int index = sampleChannel(channel);
+    if (index < 0)
+    {
+        qWarning() << "Channel" << channel << "can not be filtered";
+        return;
+    }
+    m_notifyFilters[index] = ChannelNotifyFilter();
+    m_notifyFiltered[index] = deadband > 0 || decimals >= 0 || maxRate > 0;
+    m_notifyFilters[index].setDeadband(deadband);
+    m_notifyFilters[index].setDecimals(decimals);
+    m_notifyFilters[index].setMaxRate(maxRate);
+}
+
+void DashBoard::clearNotifyFilters()
+{
+    for (int i = 0; i < SampleChannelCount; i++)
+    {
+        m_notifyFilters[i] = ChannelNotifyFilter();
+        m_notifyFiltered[i] = false;
+    }
+    m_notifyFlushTimer->stop();
+}
+
+// The filters and the smoothing are rebuilt from the lines of every loaded dash, so the channels of
+// a dash that was reloaded or switched do not keep its old configuration
+void DashBoard::setDashConfig(const int &dash, const QList<QStringList> &dashlines)
+{
+    if (dash < 0 || dash >= m_dashConfig.size())
+        return;
+    m_dashConfig[dash] = dashlines;
+    clearNotifyFilters();
+    // Smoothing,<channel>,<mode>,<window>: overrides setSmoothing while the dash is loaded
+    QVector<ChannelSmoother::Mode> modes(SmoothedChannelCount);
+    QVector<int> windows(SmoothedChannelCount);
+    for (int i = 0; i < SmoothedChannelCount; i++)
+    {
+        modes[i] = m_smoothingMode[i];
+        windows[i] = m_smoothingWindow[i];
+    }
+    foreach (const QList<QStringList> &lines, m_dashConfig)
+    {
+        foreach (const QStringList &dashline, lines)
+        {
+            if (dashline.size() >= 4 && dashline.at(0) == "Smoothing")
+            {
+                const int index = smoothedChannel(dashline.at(1).trimmed());
+                if (index < 0)
+                {
+                    qWarning() << "Channel" << dashline.at(1) << "can not be smoothed";
+                    continue;
+                }
+                modes[index] = ChannelSmoother::modeFromString(dashline.at(2).trimmed());
+                windows[index] = dashline.at(3).toInt();
+                continue;
+            }
+            setNotifyFilterFromDash(dashline);
+        }
+    }
+    for (int i = 0; i < SmoothedChannelCount; i++)
+    {configureSmoother(i, modes[i], windows[i]);}
+}
+
+// Configures the notify filters from a line of a dash definition
+// Notify filter,<channel>,<deadband>,<decimals>,<maxRate>
+// The filter gates the NOTIFY signal of the channel for every binding, so it is only set when a line
+// asks for it and not derived from the decimals a gauge shows
+void DashBoard::setNotifyFilterFromDash(const QStringList &dashline)
+{
+    if (dashline.size() >= 5 && dashline.at(0) == "Notify filter")
+        setNotifyFilter(dashline.at(1).trimmed(), dashline.at(2).toDouble(), dashline.at(3).toInt(), dashline.at(4).toDouble());
+}
+
+// Samples of the channels recorded for the charts are stored at the full rate with the time they were received, before any filtering
+void DashBoard::setChannelHistory(ChannelHistory *channelHistory)
+{
+    m_channelHistory = channelHistory;
+    for (int i = 0; i < SampleChannelCount; i++)
+        m_historySlots[i] = m_channelHistory ? m_channelHistory->addChannel(QLatin1String(SAMPLE_CHANNELS[i])) : -1;
+}
+
+// Called by the setters with the converted value, before the value is compared to the last one,
+// so the history holds every sample even when the value did not change or is not notified
+void DashBoard::recordSample(SampleChannel channel, const qreal &value)
+{
+    if (m_historySlots[channel] >= 0)
+        m_channelHistory->record(m_historySlots[channel], sampleTime(), value);
+}
+
+// The channels computed from the filtered channels are fed before the filter, so they follow every change
+void DashBoard::setDerivedChannels(DerivedChannels *derivedChannels)
+{
+    m_derivedChannels = derivedChannels;
+    for (int i = 0; i < SampleChannelCount; i++)
+        m_derivedInputs[i] = m_derivedChannels ? m_derivedChannels->inputSlot(QLatin1String(SAMPLE_CHANNELS[i])) : -1;
+}
+
+bool DashBoard::shouldNotify(SampleChannel channel, const qreal &value)
+{
+    if (m_derivedInputs[channel] >= 0)
+        m_derivedChannels->inputChanged(m_derivedInputs[channel]);
+    if (!m_notifyFiltered[channel])
+        return true;
+    ChannelNotifyFilter *filter = &m_notifyFilters[channel];
+    switch (filter->check(value, SampleClock::now()))
+    {
+    case ChannelNotifyFilter::Notify:
+        return true;
+    case ChannelNotifyFilter::Defer:
+        if (!m_notifyFlushTimer->isActive())
+        {m_notifyFlushTimer->start(qMax<qint64>(10, filter->minIntervalMs() / 2));}
+        return false;
+    default:
+        return false;
+    }
+}
+
+// Sends the rate limited notifications that are due, with the latest value of the channel
+void DashBoard::flushNotifications()
+{
+    const qint64 now = SampleClock::now();
+    bool pending = false;
+    for (int i = 0; i < SampleChannelCount; i++)
+    {
+        if (!m_notifyFiltered[i])
+            continue;
+        ChannelNotifyFilter *filter = &m_notifyFilters[i];
+        if (!filter->isDue(now))
+        {
+            pending = pending || filter->isPending();
+            continue;
+        }
+        const int index = metaObject()->indexOfProperty(SAMPLE_CHANNELS[i]);
+        if (index < 0)
+        {
+            filter->notified(0, now);
+            continue;
+        }
+        const QMetaProperty property = metaObject()->property(index);
+        const qreal value = property.read(this).toReal();
+        filter->notified(value, now);
+        property.notifySignal().invoke(this, Qt::DirectConnection, Q_ARG(qreal, value));
+    }
+    if (!pending)
+    {m_notifyFlushTimer->stop();}
+}
+
 void DashBoard::setgearcalc1(const int &gearcalc1)
 {
     if (m_gearcalc1 == gearcalc1)
@@ -2655,6 +2854,9 @@ void DashBoard::setExternalSpeed(const int &ExternalSpeed)
     if (m_ExternalSpeed == ExternalSpeed)
         return;
     m_ExternalSpeed = ExternalSpeed;
+    // the speed history holds the samples of one source
+    if (m_channelHistory)
+        m_channelHistory->clear(QStringLiteral("speed"));
     emit ExternalSpeedChanged(ExternalSpeed);
 }
 
@@ -2688,6 +2890,33 @@ void DashBoard::setbestlaptime(const QString &bestlaptime)
     emit bestlaptimeChanged(bestlaptime);
 }
 
+void DashBoard::setsectortime(const QString &sectortime)
+{
+    if (m_sectortime == sectortime)
+        return;
+    m_sectortime = sectortime;
+    emit sectortimeChanged(sectortime);
+}
+
+void DashBoard::setcurrentSector(const int &currentSector)
+{
+    if (m_currentSector == currentSector)
+        return;
+    m_currentSector = currentSector;
+    emit currentSectorChanged(currentSector);
+}
+
+void DashBoard::setlapdelta(const qreal &lapdelta)
+{
+    const qreal value = smoothed(SmoothLapdelta, lapdelta);
+    recordSample(SampleLapdelta, value);
+    if (m_lapdelta == value)
+        return;
+    m_lapdelta = value;
+    if (shouldNotify(SampleLapdelta, m_lapdelta))
+        emit lapdeltaChanged(m_lapdelta);
+}
+
 void DashBoard::setdraggable(const int &draggable)
 {
     if (m_draggable == draggable)
@@ -2919,6 +3148,62 @@ void DashBoard::setSteeringWheelAngle(const qreal &SteeringWheelAngle)
     m_SteeringWheelAngle = SteeringWheelAngle;
     emit SteeringWheelAngleChanged(SteeringWheelAngle);
 }
+void DashBoard::setMathchannel1(const qreal &Mathchannel1)
+{
+    if (m_Mathchannel1 == Mathchannel1)
+        return;
+    m_Mathchannel1 = Mathchannel1;
+    emit Mathchannel1Changed(Mathchannel1);
+}
+void DashBoard::setMathchannel2(const qreal &Mathchannel2)
+{
+    if (m_Mathchannel2 == Mathchannel2)
+        return;
+    m_Mathchannel2 = Mathchannel2;
+    emit Mathchannel2Changed(Mathchannel2);
+}
+void DashBoard::setMathchannel3(const qreal &Mathchannel3)
+{
+    if (m_Mathchannel3 == Mathchannel3)
+        return;
+    m_Mathchannel3 = Mathchannel3;
+    emit Mathchannel3Changed(Mathchannel3);
+}
+void DashBoard::setMathchannel4(const qreal &Mathchannel4)
+{
+    if (m_Mathchannel4 == Mathchannel4)
+        return;
+    m_Mathchannel4 = Mathchannel4;
+    emit Mathchannel4Changed(Mathchannel4);
+}
+void DashBoard::setMathchannel5(const qreal &Mathchannel5)
+{
+    if (m_Mathchannel5 == Mathchannel5)
+        return;
+    m_Mathchannel5 = Mathchannel5;
+    emit Mathchannel5Changed(Mathchannel5);
+}
+void DashBoard::setMathchannel6(const qreal &Mathchannel6)
+{
+    if (m_Mathchannel6 == Mathchannel6)
+        return;
+    m_Mathchannel6 = Mathchannel6;
+    emit Mathchannel6Changed(Mathchannel6);
+}
+void DashBoard::setMathchannel7(const qreal &Mathchannel7)
+{
+    if (m_Mathchannel7 == Mathchannel7)
+        return;
+    m_Mathchannel7 = Mathchannel7;
+    emit Mathchannel7Changed(Mathchannel7);
+}
+void DashBoard::setMathchannel8(const qreal &Mathchannel8)
+{
+    if (m_Mathchannel8 == Mathchannel8)
+        return;
+    m_Mathchannel8 = Mathchannel8;
+    emit Mathchannel8Changed(Mathchannel8);
+}
 
 
 // Odometer
@@ -3063,6 +3348,10 @@ double DashBoard::gpsSpeed() const { return m_gpsSpeed; }
 int DashBoard::gpsVisibleSatelites () const { return m_gpsVisibleSatelites; }
 QString DashBoard::gpsFIXtype () const { return m_gpsFIXtype; }
 qreal DashBoard::gpsbaering() const { return m_gpsbaering; }
+double DashBoard::fusedLatitude() const { return m_fusedLatitude; }
+double DashBoard::fusedLongitude() const { return m_fusedLongitude; }
+qreal DashBoard::fusedSpeed() const { return m_fusedSpeed; }
+qreal DashBoard::fusedHeading() const { return m_fusedHeading; }
 
 
 
@@ -3248,6 +3537,9 @@ int DashBoard::currentLap() const {return m_currentLap; }
 QString DashBoard::laptime() const {return m_laptime; }
 QString DashBoard::Lastlaptime() const {return m_Lastlaptime; }
 QString DashBoard::bestlaptime() const {return m_bestlaptime; }
+QString DashBoard::sectortime() const {return m_sectortime; }
+int DashBoard::currentSector() const {return m_currentSector; }
+qreal DashBoard::lapdelta() const {return m_lapdelta; }
 int DashBoard::draggable() const { return m_draggable; }
 
 QStringList DashBoard::wifi() const {return m_wifi; }
@@ -3283,6 +3575,14 @@ qreal DashBoard::Userchannel3() const {return m_Userchannel3;}
 qreal DashBoard::Userchannel4() const {return m_Userchannel4;}
 qreal DashBoard::FuelLevel() const {return m_FuelLevel;}
 qreal DashBoard::SteeringWheelAngle() const {return m_SteeringWheelAngle;}
+qreal DashBoard::Mathchannel1() const {return m_Mathchannel1;}
+qreal DashBoard::Mathchannel2() const {return m_Mathchannel2;}
+qreal DashBoard::Mathchannel3() const {return m_Mathchannel3;}
+qreal DashBoard::Mathchannel4() const {return m_Mathchannel4;}
+qreal DashBoard::Mathchannel5() const {return m_Mathchannel5;}
+qreal DashBoard::Mathchannel6() const {return m_Mathchannel6;}
+qreal DashBoard::Mathchannel7() const {return m_Mathchannel7;}
+qreal DashBoard::Mathchannel8() const {return m_Mathchannel8;}
 
 
 // Sensor Strings
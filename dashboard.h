@@ -3,6 +3,17 @@
 
 #include <QStringList>
 #include <QObject>
+#include <QHash>
+#include <QVector>
+#include "channelsmoother.h"
+#include "unitconversion.h"
+#include "channelnotifyfilter.h"
+#include "sampleclock.h"
+#include <QTimer>
+
+class ChannelHistory;
+class DerivedChannels;
+class SampleTimeScope;
 
 class DashBoard : public QObject
 {
@@ -172,6 +183,10 @@ class DashBoard : public QObject
     Q_PROPERTY(int gpsVisibleSatelites READ gpsVisibleSatelites WRITE setgpsVisibleSatelites NOTIFY gpsVisibleSatelitesChanged)
     Q_PROPERTY(QString gpsFIXtype READ gpsFIXtype  WRITE setgpsFIXtype  NOTIFY gpsFIXtypeChanged)
     Q_PROPERTY(qreal gpsbaering READ gpsbaering WRITE setgpsbaering NOTIFY gpsbaeringChanged)
+    Q_PROPERTY(double fusedLatitude READ fusedLatitude WRITE setfusedLatitude NOTIFY fusedLatitudeChanged)
+    Q_PROPERTY(double fusedLongitude READ fusedLongitude WRITE setfusedLongitude NOTIFY fusedLongitudeChanged)
+    Q_PROPERTY(qreal fusedSpeed READ fusedSpeed WRITE setfusedSpeed NOTIFY fusedSpeedChanged)
+    Q_PROPERTY(qreal fusedHeading READ fusedHeading WRITE setfusedHeading NOTIFY fusedHeadingChanged)
 
     //Units ( metric /imperial select
     Q_PROPERTY(QString units READ units WRITE setunits NOTIFY unitsChanged)
@@ -339,6 +354,9 @@ class DashBoard : public QObject
     Q_PROPERTY(QString Lastlaptime READ Lastlaptime WRITE setLastlaptime NOTIFY LastlaptimeChanged)
     Q_PROPERTY(QString bestlaptime READ bestlaptime WRITE setbestlaptime NOTIFY bestlaptimeChanged)
     Q_PROPERTY(int currentLap READ currentLap WRITE setcurrentLap NOTIFY currentLapChanged)
+    Q_PROPERTY(QString sectortime READ sectortime WRITE setsectortime NOTIFY sectortimeChanged)
+    Q_PROPERTY(int currentSector READ currentSector WRITE setcurrentSector NOTIFY currentSectorChanged)
+    Q_PROPERTY(qreal lapdelta READ lapdelta WRITE setlapdelta NOTIFY lapdeltaChanged)
 
     Q_PROPERTY(int draggable READ draggable WRITE setdraggable NOTIFY draggableChanged)
     Q_PROPERTY(QStringList wifi READ wifi WRITE setwifi NOTIFY wifiChanged)
@@ -374,6 +392,14 @@ class DashBoard : public QObject
     Q_PROPERTY(qreal Userchannel4 READ Userchannel4 WRITE setUserchannel4 NOTIFY Userchannel4Changed)
     Q_PROPERTY(qreal FuelLevel READ FuelLevel WRITE setFuelLevel NOTIFY FuelLevelChanged)
     Q_PROPERTY(qreal SteeringWheelAngle READ SteeringWheelAngle WRITE setSteeringWheelAngle NOTIFY SteeringWheelAngleChanged)
+    Q_PROPERTY(qreal Mathchannel1 READ Mathchannel1 WRITE setMathchannel1 NOTIFY Mathchannel1Changed)
+    Q_PROPERTY(qreal Mathchannel2 READ Mathchannel2 WRITE setMathchannel2 NOTIFY Mathchannel2Changed)
+    Q_PROPERTY(qreal Mathchannel3 READ Mathchannel3 WRITE setMathchannel3 NOTIFY Mathchannel3Changed)
+    Q_PROPERTY(qreal Mathchannel4 READ Mathchannel4 WRITE setMathchannel4 NOTIFY Mathchannel4Changed)
+    Q_PROPERTY(qreal Mathchannel5 READ Mathchannel5 WRITE setMathchannel5 NOTIFY Mathchannel5Changed)
+    Q_PROPERTY(qreal Mathchannel6 READ Mathchannel6 WRITE setMathchannel6 NOTIFY Mathchannel6Changed)
+    Q_PROPERTY(qreal Mathchannel7 READ Mathchannel7 WRITE setMathchannel7 NOTIFY Mathchannel7Changed)
+    Q_PROPERTY(qreal Mathchannel8 READ Mathchannel8 WRITE setMathchannel8 NOTIFY Mathchannel8Changed)
 
     //Q_PROPERTY(qreal supportedReg READ supportedReg WRITE setsupportedReg NOTIFY supportedRegChanged)
     public:
@@ -527,6 +553,10 @@ class DashBoard : public QObject
     void setgpsVisibleSatelites(const int &gpsVisibleSatelites);
     void setgpsFIXtype(const QString &gpsFIXtype);
     void setgpsbaering(const qreal &gpsbaering);
+    void setfusedLatitude(const double &fusedLatitude);
+    void setfusedLongitude(const double &fusedLongitude);
+    void setfusedSpeed(const qreal &fusedSpeed);
+    void setfusedHeading(const qreal &fusedHeading);
 
     // Units
     void setunits(const QString &units);
@@ -704,6 +734,18 @@ class DashBoard : public QObject
     Q_INVOKABLE void setboostwarn(const qreal &boostwarn);
     Q_INVOKABLE void setsmoothrpm(const int &smoothrpm);
     Q_INVOKABLE void setsmoothspeed(const int &smoothspeed);
+    Q_INVOKABLE void setSmoothing(const QString &channel, const QString &mode, const int &window);
+    Q_INVOKABLE void setNotifyFilter(const QString &channel, const qreal &deadband, const int &decimals, const qreal &maxRate);
+    Q_INVOKABLE void clearNotifyFilters();
+    // Replaces the configuration of a loaded dash (0 main dash, 1-3 user dashes) with its lines
+    void setDashConfig(const int &dash, const QList<QStringList> &dashlines);
+    void setChannelHistory(ChannelHistory *channelHistory);
+    void setDerivedChannels(DerivedChannels *derivedChannels);
+    // When the samples being set were received (SampleClock); the time they are set, unless a
+    // SampleTimeScope is open
+    qint64 sampleTime() const { return m_sampleTime >= 0 ? m_sampleTime : SampleClock::now(); }
+    // Sample time of the last ECU frame: of the rpm, which every ECU sends in each frame; -1 before
+    qint64 ecuSampleTime() const { return m_ecuSampleTime; }
 
     Q_INVOKABLE void setgearcalc1(const int &gearcalc1);
     Q_INVOKABLE void setgearcalc2(const int &gearcalc2);
@@ -719,6 +761,9 @@ class DashBoard : public QObject
     void setlaptime(const QString &laptime);
     void setLastlaptime(const QString &Lastlaptime);
     void setbestlaptime(const QString &bestlaptime);
+    void setsectortime(const QString &sectortime);
+    void setcurrentSector(const int &currentSector);
+    void setlapdelta(const qreal &lapdelta);
 
     Q_INVOKABLE void setdraggable(const int &draggable);
     void setwifi(const QStringList&wifi);
@@ -753,6 +798,14 @@ class DashBoard : public QObject
     void setUserchannel4(const qreal &Userchannel4);
     void setFuelLevel(const qreal &FuelLevel);
     void setSteeringWheelAngle(const qreal &SteeringWheelAngle);
+    void setMathchannel1(const qreal &Mathchannel1);
+    void setMathchannel2(const qreal &Mathchannel2);
+    void setMathchannel3(const qreal &Mathchannel3);
+    void setMathchannel4(const qreal &Mathchannel4);
+    void setMathchannel5(const qreal &Mathchannel5);
+    void setMathchannel6(const qreal &Mathchannel6);
+    void setMathchannel7(const qreal &Mathchannel7);
+    void setMathchannel8(const qreal &Mathchannel8);
 
 
 
@@ -905,6 +958,10 @@ class DashBoard : public QObject
     int gpsVisibleSatelites() const;
     QString gpsFIXtype() const;
     qreal gpsbaering() const;
+    double fusedLatitude() const;
+    double fusedLongitude() const;
+    qreal fusedSpeed() const;
+    qreal fusedHeading() const;
 
     //units
     QString units() const;
@@ -1093,6 +1150,9 @@ class DashBoard : public QObject
     QString laptime() const;
     QString Lastlaptime() const;
     QString bestlaptime() const;
+    QString sectortime() const;
+    int currentSector() const;
+    qreal lapdelta() const;
 
     int draggable() const;
     QStringList wifi() const;
@@ -1127,6 +1187,14 @@ class DashBoard : public QObject
     qreal Userchannel4()const;
     qreal FuelLevel()const;
     qreal SteeringWheelAngle()const;
+    qreal Mathchannel1()const;
+    qreal Mathchannel2()const;
+    qreal Mathchannel3()const;
+    qreal Mathchannel4()const;
+    qreal Mathchannel5()const;
+    qreal Mathchannel6()const;
+    qreal Mathchannel7()const;
+    qreal Mathchannel8()const;
 
 signals:
 
@@ -1272,6 +1340,10 @@ signals:
     void gpsVisibleSatelitesChanged(int gpsVisibleSatelites);
     void gpsFIXtypeChanged(QString gpsFIXtype);
     void gpsbaeringChanged(qreal gpsbaering);
+    void fusedLatitudeChanged(double fusedLatitude);
+    void fusedLongitudeChanged(double fusedLongitude);
+    void fusedSpeedChanged(qreal fusedSpeed);
+    void fusedHeadingChanged(qreal fusedHeading);
 
     // units
 
@@ -1451,6 +1523,9 @@ signals:
     void laptimeChanged(QString laptime);
     void LastlaptimeChanged(QString Lastlaptime);
     void bestlaptimeChanged(QString bestlaptime);
+    void sectortimeChanged(QString sectortime);
+    void currentSectorChanged(int currentSector);
+    void lapdeltaChanged(qreal lapdelta);
     void draggableChanged(int draggable);
     void wifiChanged(QStringList wifi);
 
@@ -1484,6 +1559,14 @@ signals:
     void Userchannel4Changed(qreal Userchannel4);
     void FuelLevelChanged(qreal FuelLevel);
     void SteeringWheelAngleChanged(qreal SteeringWheelAngle);
+    void Mathchannel1Changed(qreal Mathchannel1);
+    void Mathchannel2Changed(qreal Mathchannel2);
+    void Mathchannel3Changed(qreal Mathchannel3);
+    void Mathchannel4Changed(qreal Mathchannel4);
+    void Mathchannel5Changed(qreal Mathchannel5);
+    void Mathchannel6Changed(qreal Mathchannel6);
+    void Mathchannel7Changed(qreal Mathchannel7);
+    void Mathchannel8Changed(qreal Mathchannel8);
 
 
 
@@ -1667,12 +1750,17 @@ private:
     int m_gpsVisibleSatelites;
     QString m_gpsFIXtype;
     qreal m_gpsbaering;
+    double m_fusedLatitude;
+    double m_fusedLongitude;
+    qreal m_fusedSpeed;
+    qreal m_fusedHeading;
 
     //Units
 
     QString m_units;
     QString m_speedunits;
     QString m_pressureunits;
+    UnitConversionPlan m_unitConversion;
 
     //qsensors
 
@@ -1808,6 +1896,81 @@ private:
     qreal m_boostwarn;
     int m_smoothrpm;
     int m_smoothspeed;
+    // Channels whose setters smooth the values they are set to; SMOOTHED_CHANNELS holds their names
+    enum SmoothedChannel {
+        SmoothRpm,
+        SmoothSpeed,
+        SmoothIntakepress,
+        SmoothWatertemp,
+        SmoothIntaketemp,
+        SmoothBatteryV,
+        SmoothBoostPres,
+        SmoothAuxcalc1,
+        SmoothAuxcalc2,
+        SmoothAuxcalc3,
+        SmoothAuxcalc4,
+        SmoothMAP,
+        SmoothFuelPress,
+        SmoothOilpres,
+        SmoothOiltemp,
+        SmoothAccely,
+        SmoothPower,
+        SmoothTorque,
+        SmoothFusedSpeed,
+        SmoothLapdelta,
+        SmoothedChannelCount
+    };
+    ChannelSmoother m_smoothers[SmoothedChannelCount];
+    // as set with setSmoothing; a loaded dash can override it
+    ChannelSmoother::Mode m_smoothingMode[SmoothedChannelCount];
+    int m_smoothingWindow[SmoothedChannelCount];
+    qreal smoothed(SmoothedChannel channel, const qreal &value) { return m_smoothers[channel].add(value); }
+    static int smoothedChannel(const QString &channel);
+    void configureSmoother(int channel, ChannelSmoother::Mode mode, int window);
+    // Channels whose setters record their samples, feed the derived channels and filter their
+    // notifications, indexed so a sample costs no lookup of the name; SAMPLE_CHANNELS holds their names
+    enum SampleChannel {
+        SampleRpm,
+        SampleSpeed,
+        SampleIntakepress,
+        SampleWatertemp,
+        SampleIntaketemp,
+        SampleBatteryV,
+        SampleBoostPres,
+        SampleAuxcalc1,
+        SampleAuxcalc2,
+        SampleAuxcalc3,
+        SampleAuxcalc4,
+        SampleMAP,
+        SampleFuelPress,
+        SampleOilpres,
+        SampleOiltemp,
+        SampleAccely,
+        SamplePower,
+        SampleTorque,
+        SampleFusedLatitude,
+        SampleFusedLongitude,
+        SampleFusedSpeed,
+        SampleFusedHeading,
+        SampleLapdelta,
+        SampleChannelCount
+    };
+    static int sampleChannel(const QString &channel);
+    int m_historySlots[SampleChannelCount]; // -1 without ChannelHistory
+    int m_derivedInputs[SampleChannelCount]; // -1 without DerivedChannels
+    ChannelNotifyFilter m_notifyFilters[SampleChannelCount];
+    bool m_notifyFiltered[SampleChannelCount];
+    QTimer *m_notifyFlushTimer;
+    QVector<QList<QStringList> > m_dashConfig;
+    void setNotifyFilterFromDash(const QStringList &dashline);
+    ChannelHistory *m_channelHistory;
+    DerivedChannels *m_derivedChannels;
+    qint64 m_sampleTime;
+    qint64 m_ecuSampleTime;
+    friend class SampleTimeScope;
+    void recordSample(SampleChannel channel, const qreal &value);
+    bool shouldNotify(SampleChannel channel, const qreal &value);
+    void flushNotifications();
     int m_gearcalc1;
     int m_gearcalc2;
     int m_gearcalc3;
@@ -1829,6 +1992,9 @@ private:
     QString m_laptime;
     QString m_Lastlaptime;
     QString m_bestlaptime;
+    QString m_sectortime;
+    int m_currentSector;
+    qreal m_lapdelta;
 
     int m_draggable;
     QStringList m_wifi;
@@ -1863,8 +2029,38 @@ private:
     qreal m_Userchannel4;
     qreal m_FuelLevel;
     qreal m_SteeringWheelAngle;
+    qreal m_Mathchannel1;
+    qreal m_Mathchannel2;
+    qreal m_Mathchannel3;
+    qreal m_Mathchannel4;
+    qreal m_Mathchannel5;
+    qreal m_Mathchannel6;
+    qreal m_Mathchannel7;
+    qreal m_Mathchannel8;
 
 
 };
 
+// Stamps the samples set on the DashBoard while it exists, ex. with the time a frame was received
+class SampleTimeScope
+{
+public:
+    SampleTimeScope(DashBoard *dashboard, qint64 timeMs)
+        : m_dashboard(dashboard)
+        , m_previous(dashboard ? dashboard->m_sampleTime : -1)
+    {
+        if (m_dashboard)
+            m_dashboard->m_sampleTime = timeMs;
+    }
+    ~SampleTimeScope()
+    {
+        if (m_dashboard)
+            m_dashboard->m_sampleTime = m_previous;
+    }
+
+private:
+    DashBoard *m_dashboard;
+    qint64 m_previous;
+};
+
 #endif // DASHBOARD_H
@@ -1,13 +1,18 @@
 #include "datalogger.h"
 #include "dashboard.h"
+#include "sampleclock.h"
 #include <QFile>
 #include <QTextStream>
+#include <QMetaProperty>
 #include <QThread>
 #include <QDebug>
 
 // Run this as a thread and update every 50 ms
 // still need to find a way to make this configurable
-QTime loggerStartT;
+// SampleClock time of the start of the log, so the time column shares the clock of every sample
+qint64 loggerStartT = 0;
+// ECU sample time of the last line written, -1 = none
+qint64 lastLoggedSampleTime = -1;
 QFile logFile;
 bool isLogging = false;
 // The minimum RPM that the engine is considered started.
@@ -26,7 +31,7 @@ datalogger::datalogger(DashBoard *dashboard, QObject *parent)
 
 void datalogger::startLog() {
     connect(&m_updatetimer, &QTimer::timeout, this, &datalogger::updateLog);
-    loggerStartT = QTime::currentTime();
+    loggerStartT = SampleClock::now();
     m_updatetimer.start(100);
 }
 
@@ -36,6 +41,19 @@ void datalogger::stopLog() {
     m_updatetimer.stop();
 }
 
+void datalogger::setMathChannels(const QStringList &outputs, const QStringList &names) {
+    m_mathChannelOutputs = outputs;
+    m_mathChannelNames = names;
+}
+
+QString datalogger::mathChannelValues() const {
+    QString values;
+    foreach (int index, m_loggedMathChannels) {
+        values += QString::number(m_dashboard->metaObject()->property(index).read(m_dashboard).toReal()) + ",";
+    }
+    return values;
+}
+
 void datalogger::updateLog() {
     if (isLogging) {
         // Stop logging when engine is shut down
@@ -52,16 +70,26 @@ void datalogger::updateLog() {
             logFile.setFileName(logFileName);
             if (logFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
                 isLogging = true;
+                lastLoggedSampleTime = -1;
                 datalogger::createHeader();
             }
         }
     }
 
-    if (isLogging) {
+    // The line is stamped with the time the ECU frame of its values was received, not the
+    // time it is written; without a new frame since the last line nothing is written, so every
+    // line is a sample of its own
+    const qint64 sampleTime = m_dashboard->ecuSampleTime();
+    if (isLogging && sampleTime != lastLoggedSampleTime) {
+        lastLoggedSampleTime = sampleTime;
         QTextStream textStream(&logFile);
+        const qint64 logTime = sampleTime - loggerStartT;
+        // UTC time of day of the GPS, to align the log with other recordings; empty without a fix
+        const int gpsTimeOfDay = SampleClock::gpsTimeOfDay(sampleTime);
+        const QString gpsTime = gpsTimeOfDay < 0 ? QString() : QString::number(gpsTimeOfDay);
         switch (m_dashboard->ecu()) {
             case 1: ////Apexi ECU
-                textStream << (loggerStartT.msecsTo(QTime::currentTime()) / 1000.0) << ","
+                textStream << QString::number(logTime / 1000.0, 'f', 3) << ","
                     << m_dashboard->rpm() << ","
                     << m_dashboard->InjDuty() << ","
                     << m_dashboard->Leadingign() << ","
@@ -81,10 +109,10 @@ void datalogger::updateLog() {
                     << m_dashboard->Dwell() << "," // Not working
                     << m_dashboard->Gear() << ","
                     << m_dashboard->closedLoop() << ","
-                    << endl;
+                    << mathChannelValues() << gpsTime << endl;
                 break;
             case 0: ////Link ECU Generic CAN
-                textStream << (loggerStartT.msecsTo(QTime::currentTime())) << ","
+                textStream << logTime << ","
                     << m_dashboard->rpm() << ","
                     << m_dashboard->MAP() << ","
                     << "MGP" << ","
@@ -125,10 +153,10 @@ void datalogger::updateLog() {
                     << "Knock Level 8" << ","
                     << m_dashboard->currentLap() << ","
                     << m_dashboard->laptime() << ","
-                    << endl;
+                    << mathChannelValues() << gpsTime << endl;
                 break;
             case 2: ////Toyota86 BRZ FRS
-                textStream << (loggerStartT.msecsTo(QTime::currentTime())) << ","
+                textStream << logTime << ","
                     << m_dashboard->rpm() << ","
                     << m_dashboard->Watertemp() << ","
                     << m_dashboard->oiltemp() << ","
@@ -145,10 +173,10 @@ void datalogger::updateLog() {
                     << m_dashboard->gpsSpeed() << ","
                     << m_dashboard->currentLap() << ","
                     << m_dashboard->laptime() << ","
-                    << endl;
+                    << mathChannelValues() << gpsTime << endl;
                 break;
             case 5: ////ECU MASTERS EMU CAN
-                textStream << (loggerStartT.msecsTo(QTime::currentTime())) << ","
+                textStream << logTime << ","
                     << m_dashboard->rpm() << ","
                     << m_dashboard->TPS() << ","
                     << m_dashboard->injms() << ","
@@ -180,7 +208,7 @@ void datalogger::updateLog() {
                     << m_dashboard->gpsSpeed() << ","
                     << m_dashboard->currentLap() << ","
                     << m_dashboard->laptime() << ","
-                    << endl;
+                    << mathChannelValues() << gpsTime << endl;
                 break;
         }
     }
@@ -191,6 +219,13 @@ void datalogger::updateLog() {
 
 void datalogger::createHeader() {
     QTextStream textStream(&logFile);
+    // the math channels stay the same for the whole log
+    QString header;
+    m_loggedMathChannels.clear();
+    for (int i = 0; i < m_mathChannelOutputs.size(); i++) {
+        m_loggedMathChannels.append(m_dashboard->metaObject()->indexOfProperty(m_mathChannelOutputs[i].toLatin1().constData()));
+        header += m_mathChannelNames.value(i) + ",";
+    }
     switch(m_dashboard->ecu()) {
         case 1: //Apexi
             textStream << "Time(S)" << ","
@@ -213,7 +248,7 @@ void datalogger::createHeader() {
                 << "Dwell" << ","
                 << "Gear" << ","
                 << "ClosedLoop" << ","
-                << endl;
+                << header << "GPS Time(ms)" << endl;
             break;
         case 0: ////Link ECU Generic CAN
             textStream << "Time ms" << ","
@@ -257,7 +292,7 @@ void datalogger::createHeader() {
                 << "Knock Level 8"  << ","
                 << "Current LAP"    << ","
                 << "LAP TIME"       << ","
-                << endl;
+                << header << "GPS Time(ms)" << endl;
             break;
         case 2: ////Toyota86 BRZ FRS
             textStream << "Time ms" << ","
@@ -277,7 +312,7 @@ void datalogger::createHeader() {
                 << "GPS Speed"  << ","
                 << "Current LAP"    << ","
                 << "LAP TIME"  << ","
-                << endl;
+                << header << "GPS Time(ms)" << endl;
             break;
         case 5: ////EMU CAN
             textStream << "Time ms" << ","
@@ -314,7 +349,7 @@ void datalogger::createHeader() {
                 << "GPS Speed"  << ","
                 << "Current LAP"    << ","
                 << "LAP TIME"  << ","
-                << endl;
+                << header << "GPS Time(ms)" << endl;
             break;
     }
 }
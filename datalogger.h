@@ -4,6 +4,8 @@
 #include <QObject>
 #include <QTime>
 #include <QTimer>
+#include <QStringList>
+#include <QVector>
 
     class datalogger;
     class DashBoard;
@@ -20,6 +22,8 @@
         explicit datalogger(DashBoard *dashboard, QObject *parent = 0);
         Q_INVOKABLE void startLog();
         Q_INVOKABLE void stopLog();
+        // Math channels added at the end of each log line, from the next log on
+        void setMathChannels(const QStringList &outputs, const QStringList &names);
 
 
     public slots:
@@ -28,8 +32,13 @@
     void createHeader();
 
     private:
+        QString mathChannelValues() const;
+
         DashBoard *m_dashboard;
         QTimer      m_updatetimer;
+        QStringList m_mathChannelOutputs;
+        QStringList m_mathChannelNames;
+        QVector<int> m_loggedMathChannels; // DashBoard property indices of the current log
 };
 
 #endif // DATALOGGER_H
@@ -0,0 +1,202 @@
+#include "derivedchannels.h"
+#include "dashboard.h"
+#include <QMetaProperty>
+#include <QDebug>
+
+const char *DerivedChannels::TICK_INPUT = "tick";
+
+DerivedChannels::DerivedChannels(QObject *parent)
+    : DerivedChannels(Q_NULLPTR, parent)
+{
+}
+
+DerivedChannels::DerivedChannels(DashBoard *dashboard, QObject *parent)
+    : QObject(parent)
+    , m_dashboard(dashboard)
+    , m_nextId(0)
+    , m_inputTime(-1)
+    , m_running(false)
+    , m_evaluating(false)
+{
+    m_evaluateTimer.setSingleShot(true);
+    connect(&m_evaluateTimer, &QTimer::timeout, this, &DerivedChannels::evaluate);
+    m_tickSlot = inputSlot(TICK_INPUT);
+    connect(&m_tickTimer, &QTimer::timeout, this, [this]() { inputChanged(m_tickSlot); });
+}
+
+int DerivedChannels::addChannel(const QStringList &outputs, const QStringList &inputs, const Compute &compute)
+{
+    Channel channel;
+    channel.id = m_nextId;
+    channel.outputs = outputs;
+    channel.inputs = inputs;
+    channel.compute = compute;
+    channel.dirty = true;
+    QVector<Channel> channels = m_channels;
+    channels.append(channel);
+    if (!sortChannels(channels)) {
+        qDebug() << "Derived channel" << outputs << "depends on itself";
+        return -1;
+    }
+    m_channels = channels;
+    m_nextId++;
+    rebuildIndex();
+    foreach (const QString &input, inputs)
+        subscribe(input);
+    schedule();
+    return channel.id;
+}
+
+void DerivedChannels::removeChannel(int id)
+{
+    for (int i = 0; i < m_channels.size(); i++) {
+        if (m_channels[i].id == id) {
+            m_channels.remove(i);
+            rebuildIndex();
+            return;
+        }
+    }
+}
+
+// Orders the channels so each comes after the channels producing its inputs, keeping the order they were added in otherwise
+bool DerivedChannels::sortChannels(QVector<Channel> &channels) const
+{
+    const int count = channels.size();
+    QVector<QVector<int> > dependents(count);
+    QVector<int> pending(count);
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < count; j++) {
+            if (i == j)
+                continue;
+            foreach (const QString &output, channels[j].outputs) {
+                if (channels[i].inputs.contains(output)) {
+                    dependents[j].append(i);
+                    pending[i]++;
+                    break;
+                }
+            }
+        }
+    }
+    QVector<Channel> sorted;
+    QVector<bool> done(count);
+    while (sorted.size() < count) {
+        int next = -1;
+        for (int i = 0; i < count && next < 0; i++) {
+            if (!done[i] && pending[i] == 0)
+                next = i;
+        }
+        if (next < 0)
+            return false;
+        done[next] = true;
+        sorted.append(channels[next]);
+        foreach (int dependent, dependents[next])
+            pending[dependent]--;
+    }
+    channels = sorted;
+    return true;
+}
+
+int DerivedChannels::inputSlot(const QString &input)
+{
+    QHash<QString, int>::const_iterator slot = m_inputSlots.constFind(input);
+    if (slot != m_inputSlots.constEnd())
+        return slot.value();
+    m_dependents.append(QVector<int>());
+    m_inputSlots.insert(input, m_dependents.size() - 1);
+    return m_dependents.size() - 1;
+}
+
+void DerivedChannels::rebuildIndex()
+{
+    for (int slot = 0; slot < m_dependents.size(); slot++)
+        m_dependents[slot].clear();
+    for (int i = 0; i < m_channels.size(); i++) {
+        foreach (const QString &input, m_channels[i].inputs) {
+            // a channel that reads its own output is not computed again because of it
+            if (!m_channels[i].outputs.contains(input)) {
+                const int slot = inputSlot(input);
+                m_dependents[slot].append(i);
+            }
+        }
+    }
+}
+
+void DerivedChannels::subscribe(const QString &input)
+{
+    if (!m_dashboard)
+        return;
+    const QMetaObject *metaObject = m_dashboard->metaObject();
+    const int index = metaObject->indexOfProperty(input.toLatin1().constData());
+    if (index < 0 || !metaObject->property(index).hasNotifySignal())
+        return;
+    const int signalIndex = metaObject->property(index).notifySignalIndex();
+    if (m_signalInputs.contains(signalIndex))
+        return;
+    m_signalInputs.insert(signalIndex, inputSlot(input));
+    QMetaObject::connect(m_dashboard, signalIndex, this, this->metaObject()->indexOfSlot("dashboardSignal()"));
+}
+
+void DerivedChannels::dashboardSignal()
+{
+    inputChanged(m_signalInputs.value(senderSignalIndex(), -1));
+}
+
+void DerivedChannels::inputChanged(const QString &input)
+{
+    inputChanged(m_inputSlots.value(input, -1));
+}
+
+void DerivedChannels::inputChanged(int slot)
+{
+    if (slot < 0 || m_dependents[slot].isEmpty())
+        return;
+    const QVector<int> &dependents = m_dependents[slot];
+    for (int i = 0; i < dependents.size(); i++)
+        m_channels[dependents[i]].dirty = true;
+    if (m_dashboard)
+        m_inputTime = qMax(m_inputTime, m_dashboard->sampleTime());
+    // while evaluating, the dependents come later in the order and are computed in the same pass
+    if (!m_evaluating)
+        schedule();
+}
+
+void DerivedChannels::invalidateAll()
+{
+    for (int i = 0; i < m_channels.size(); i++)
+        m_channels[i].dirty = true;
+    schedule();
+}
+
+void DerivedChannels::schedule()
+{
+    if (m_running && !m_evaluateTimer.isActive())
+        m_evaluateTimer.start(0);
+}
+
+void DerivedChannels::evaluate()
+{
+    SampleTimeScope inputTime(m_dashboard, m_inputTime >= 0 ? m_inputTime : SampleClock::now());
+    m_inputTime = -1;
+    m_evaluating = true;
+    for (int i = 0; i < m_channels.size(); i++) {
+        if (!m_channels[i].dirty)
+            continue;
+        m_channels[i].dirty = false;
+        m_channels[i].compute();
+    }
+    m_evaluating = false;
+}
+
+void DerivedChannels::start()
+{
+    m_running = true;
+    m_tickTimer.start(TICK_INTERVAL_MS);
+    invalidateAll();
+}
+
+void DerivedChannels::stop()
+{
+    m_running = false;
+    m_tickTimer.stop();
+    m_evaluateTimer.stop();
+}
@@ -0,0 +1,85 @@
+#ifndef DERIVEDCHANNELS_H
+#define DERIVEDCHANNELS_H
+
+#include <QObject>
+#include <QHash>
+#include <QVector>
+#include <QStringList>
+#include <QTimer>
+#include <functional>
+
+class DashBoard;
+
+/*
+ * Channels computed from other channels (gear, odometer, power, math channels).
+ *
+ * Each channel declares its inputs and outputs; it is computed only when one of its inputs
+ * changed, after the channels it depends on. Inputs that are DashBoard properties are followed
+ * through their notify signals; the DashBoard also feeds the channels it rate limits with
+ * inputChanged() before their filter. Other inputs (ex. TICK_INPUT) are fed with inputChanged().
+ * A source feeding an input at the sample rate resolves its slot once with inputSlot().
+ * Changes are collected and evaluated once control returns to the event loop, so a frame
+ * that updates rpm and speed computes the gear once. The outputs are stamped with the time
+ * the newest of the changed inputs was received.
+ */
+class DerivedChannels : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef std::function<void()> Compute;
+
+    // input changed every TICK_INTERVAL_MS, for channels that integrate over time
+    static const char *TICK_INPUT;
+    static const int TICK_INTERVAL_MS = 250;
+
+    explicit DerivedChannels(QObject *parent = 0);
+    explicit DerivedChannels(DashBoard *dashboard, QObject *parent = 0);
+
+    // Returns the id of the channel, -1 if it would create a cycle
+    int addChannel(const QStringList &outputs, const QStringList &inputs, const Compute &compute);
+    void removeChannel(int id);
+
+    // Slot of an input, also before a channel reads it; stays the same while the channels change
+    int inputSlot(const QString &input);
+    void inputChanged(int slot);
+    void inputChanged(const QString &input);
+    // Computes every channel, ex. after start
+    void invalidateAll();
+
+    void start();
+    void stop();
+
+private slots:
+    void dashboardSignal();
+    void evaluate();
+
+private:
+    struct Channel {
+        int id;
+        QStringList outputs;
+        QStringList inputs;
+        Compute compute;
+        bool dirty;
+    };
+
+    bool sortChannels(QVector<Channel> &channels) const;
+    void rebuildIndex();
+    void subscribe(const QString &input);
+    void schedule();
+
+    DashBoard *m_dashboard;
+    QVector<Channel> m_channels; // in evaluation order
+    QHash<QString, int> m_inputSlots;
+    QVector<QVector<int> > m_dependents; // input slot -> positions in m_channels
+    QHash<int, int> m_signalInputs; // notify signal index -> input slot
+    int m_tickSlot;
+    QTimer m_evaluateTimer;
+    QTimer m_tickTimer;
+    int m_nextId;
+    qint64 m_inputTime; // -1 = no input changed
+    bool m_running;
+    bool m_evaluating;
+};
+
+#endif // DERIVEDCHANNELS_H
@@ -0,0 +1,301 @@
+#include "dynorun.h"
+#include "dashboard.h"
+#include "channelhistory.h"
+#include <QtCharts/QXYSeries>
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <QtMath>
+#include <QDebug>
+
+const qreal DynoRun::FILTER_CUTOFF_HZ = 2.0;
+const qreal DynoRun::PULL_START_ACCEL = 0.05;
+
+namespace {
+const int POLL_INTERVAL_MS = 50;
+const char *DYNO_RUN_DIR = "/home/pi/DynoRuns/";
+
+// Same as the live Power / Torque of calculations
+// Weight (kg) * LongAcc (g) * Speed (km/h) * 0.0031107 = kW, kW * 9549 / rpm = Nm
+const qreal METRIC_POWER_FACTOR = 0.0031107;
+const qreal METRIC_TORQUE_FACTOR = 9549;
+// Weight (lbs) * LongAcc (g) * Speed (mph) * 0.003054 = hp, hp * 5252 / rpm = ft-lb
+const qreal IMPERIAL_POWER_FACTOR = 0.003054;
+const qreal IMPERIAL_TORQUE_FACTOR = 5252;
+}
+
+void DynoCurve::clear()
+{
+    rpm.clear();
+    power.clear();
+    torque.clear();
+    updatePeaks();
+}
+
+void DynoCurve::updatePeaks()
+{
+    peakPower = peakPowerRpm = peakTorque = peakTorqueRpm = 0;
+    for (int i = 0; i < rpm.size(); i++) {
+        if (power[i] > peakPower) {
+            peakPower = power[i];
+            peakPowerRpm = rpm[i];
+        }
+        if (torque[i] > peakTorque) {
+            peakTorque = torque[i];
+            peakTorqueRpm = rpm[i];
+        }
+    }
+}
+
+DynoRun::DynoRun(QObject *parent)
+    : DynoRun(Q_NULLPTR, Q_NULLPTR, parent)
+{
+}
+
+DynoRun::DynoRun(DashBoard *dashboard, ChannelHistory *channelHistory, QObject *parent)
+    : QObject(parent)
+    , m_dashboard(dashboard)
+    , m_channelHistory(channelHistory)
+    , m_state(Idle)
+    , m_lowRpm(0)
+    , m_lowRpmMs(0)
+    , m_highRpm(0)
+    , m_highRpmMs(0)
+{
+    connect(&m_pollTimer, &QTimer::timeout, this, &DynoRun::poll);
+}
+
+void DynoRun::arm()
+{
+    if (!m_dashboard || !m_channelHistory)
+        return;
+    m_channelHistory->track(QStringLiteral("rpm"));
+    m_channelHistory->track(QStringLiteral("speed"));
+    m_channelHistory->track(QStringLiteral("accely"));
+    m_lowRpm = m_dashboard->rpm();
+    m_lowRpmMs = m_channelHistory->now();
+    setState(Armed);
+    m_pollTimer.start(POLL_INTERVAL_MS);
+}
+
+void DynoRun::cancel()
+{
+    m_pollTimer.stop();
+    setState(Idle);
+}
+
+void DynoRun::poll()
+{
+    const qreal rpm = m_dashboard->rpm();
+    const qint64 nowMs = m_channelHistory->now();
+    if (m_state == Armed) {
+        if (rpm < m_lowRpm) {
+            m_lowRpm = rpm;
+            m_lowRpmMs = nowMs;
+        }
+        if (m_dashboard->accely() >= PULL_START_ACCEL && rpm >= m_lowRpm + PULL_START_RPM_RISE) {
+            m_highRpm = rpm;
+            m_highRpmMs = nowMs;
+            setState(Pulling);
+        }
+    } else if (m_state == Pulling) {
+        if (rpm > m_highRpm) {
+            m_highRpm = rpm;
+            m_highRpmMs = nowMs;
+        }
+        if (rpm > m_highRpm - PULL_END_RPM_DROP)
+            return;
+        if (m_highRpm - m_lowRpm >= PULL_MIN_RPM_SPAN) {
+            finishPull();
+        } else {
+            m_lowRpm = rpm;
+            m_lowRpmMs = nowMs;
+            setState(Armed);
+        }
+    }
+}
+
+void DynoRun::finishPull()
+{
+    DynoCurve curve;
+    if (!buildCurve(m_lowRpmMs, m_highRpmMs, curve)) {
+        qDebug() << "Dyno pull without enough samples";
+        m_lowRpm = m_dashboard->rpm();
+        m_lowRpmMs = m_channelHistory->now();
+        setState(Armed);
+        return;
+    }
+    m_pollTimer.stop();
+    m_curve = curve;
+    setState(Finished);
+    emit runFinished();
+}
+
+bool DynoRun::buildCurve(qint64 fromMs, qint64 toMs, DynoCurve &curve) const
+{
+    const ChannelRing *rpmRing = m_channelHistory->ring(QStringLiteral("rpm"));
+    const ChannelRing *speedRing = m_channelHistory->ring(QStringLiteral("speed"));
+    const ChannelRing *accelRing = m_channelHistory->ring(QStringLiteral("accely"));
+    if (!rpmRing || !speedRing || !accelRing || !rpmRing->size() || !speedRing->size() || !accelRing->size())
+        return false;
+    const int count = int((toMs - fromMs) / SAMPLE_INTERVAL_MS) + 1;
+    if (count < 2)
+        return false;
+
+    // resample on a fixed interval so the filter has a fixed cut off
+    QVector<qreal> rpm(count);
+    QVector<qreal> speed(count);
+    QVector<qreal> accel(count);
+    for (int i = 0; i < count; i++) {
+        const qint64 timeMs = fromMs + qint64(i) * SAMPLE_INTERVAL_MS;
+        if (!rpmRing->valueAt(timeMs, rpm[i]))
+            rpm[i] = rpmRing->valueAt(0);
+        if (!speedRing->valueAt(timeMs, speed[i]))
+            speed[i] = speedRing->valueAt(0);
+        if (!accelRing->valueAt(timeMs, accel[i]))
+            accel[i] = accelRing->valueAt(0);
+    }
+    const qreal dt = SAMPLE_INTERVAL_MS / 1000.0;
+    const qreal rc = 1 / (2 * M_PI * FILTER_CUTOFF_HZ);
+    const qreal alpha = dt / (rc + dt);
+    filtfilt(accel, alpha);
+    filtfilt(speed, alpha);
+
+    const bool imperial = m_dashboard->units() == "imperial";
+    const qreal powerFactor = imperial ? IMPERIAL_POWER_FACTOR : METRIC_POWER_FACTOR;
+    const qreal torqueFactor = imperial ? IMPERIAL_TORQUE_FACTOR : METRIC_TORQUE_FACTOR;
+    const qreal weight = m_dashboard->Weight();
+
+    // average into rpm bins
+    QVector<qreal> powerSum;
+    QVector<qreal> torqueSum;
+    QVector<int> samples;
+    for (int i = 0; i < count; i++) {
+        if (rpm[i] <= 0)
+            continue;
+        const int bin = int(rpm[i] / RPM_BIN_SIZE);
+        if (bin >= samples.size()) {
+            powerSum.resize(bin + 1);
+            torqueSum.resize(bin + 1);
+            samples.resize(bin + 1);
+        }
+        const qreal power = weight * accel[i] * speed[i] * powerFactor;
+        powerSum[bin] += power;
+        torqueSum[bin] += power * torqueFactor / rpm[i];
+        samples[bin]++;
+    }
+    curve.clear();
+    for (int bin = 0; bin < samples.size(); bin++) {
+        if (!samples[bin])
+            continue;
+        curve.rpm.append(bin * RPM_BIN_SIZE + RPM_BIN_SIZE / 2);
+        curve.power.append(powerSum[bin] / samples[bin]);
+        curve.torque.append(torqueSum[bin] / samples[bin]);
+    }
+    curve.updatePeaks();
+    return curve.rpm.size() >= 2;
+}
+
+// First order low pass forward and then backward; the phase lags cancel
+void DynoRun::filtfilt(QVector<qreal> &values, qreal alpha)
+{
+    for (int i = 1; i < values.size(); i++)
+        values[i] = values[i - 1] + alpha * (values[i] - values[i - 1]);
+    for (int i = values.size() - 2; i >= 0; i--)
+        values[i] = values[i + 1] + alpha * (values[i] - values[i + 1]);
+}
+
+void DynoRun::updateSeries(QAbstractSeries *series, const QString &curve)
+{
+    QXYSeries *xySeries = qobject_cast<QXYSeries *>(series);
+    if (!xySeries)
+        return;
+    const bool compare = curve.startsWith(QLatin1String("Compare"));
+    const DynoCurve &dynoCurve = compare ? m_compareCurve : m_curve;
+    const QVector<qreal> &values = curve.endsWith(QLatin1String("Torque")) ? dynoCurve.torque : dynoCurve.power;
+    m_points.clear();
+    for (int i = 0; i < dynoCurve.rpm.size(); i++)
+        m_points.append(QPointF(dynoCurve.rpm[i], values[i]));
+    xySeries->replace(m_points);
+}
+
+bool DynoRun::saveRun(const QString &name)
+{
+    if (m_curve.rpm.isEmpty() || name.isEmpty())
+        return false;
+    QDir().mkpath(DYNO_RUN_DIR);
+    QFile file(DYNO_RUN_DIR + name + ".csv");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+        qDebug() << "Could not save dyno run" << file.fileName();
+        return false;
+    }
+    QTextStream stream(&file);
+    stream << "RPM,Power,Torque" << endl;
+    for (int i = 0; i < m_curve.rpm.size(); i++)
+        stream << m_curve.rpm[i] << "," << m_curve.power[i] << "," << m_curve.torque[i] << endl;
+    file.close();
+    readSavedRuns();
+    return true;
+}
+
+bool DynoRun::loadCompareRun(const QString &name)
+{
+    QFile file(DYNO_RUN_DIR + name + ".csv");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qDebug() << "Could not load dyno run" << file.fileName();
+        return false;
+    }
+    QTextStream stream(&file);
+    stream.readLine(); // header
+    m_compareCurve.clear();
+    while (!stream.atEnd()) {
+        const QStringList fields = stream.readLine().split(',');
+        if (fields.size() < 3)
+            continue;
+        m_compareCurve.rpm.append(fields[0].toDouble());
+        m_compareCurve.power.append(fields[1].toDouble());
+        m_compareCurve.torque.append(fields[2].toDouble());
+    }
+    m_compareCurve.updatePeaks();
+    emit compareChanged();
+    return true;
+}
+
+void DynoRun::clearCompareRun()
+{
+    m_compareCurve.clear();
+    emit compareChanged();
+}
+
+void DynoRun::readSavedRuns()
+{
+    QStringList runs;
+    foreach (const QString &file, QDir(DYNO_RUN_DIR).entryList(QStringList() << "*.csv", QDir::Files))
+        runs.append(file.left(file.size() - 4));
+    if (m_savedRuns == runs)
+        return;
+    m_savedRuns = runs;
+    emit savedRunsChanged(m_savedRuns);
+}
+
+QString DynoRun::state() const
+{
+    switch (m_state) {
+    case Armed:
+        return QStringLiteral("armed");
+    case Pulling:
+        return QStringLiteral("pulling");
+    case Finished:
+        return QStringLiteral("finished");
+    default:
+        return QStringLiteral("idle");
+    }
+}
+
+void DynoRun::setState(State state)
+{
+    if (m_state == state)
+        return;
+    m_state = state;
+    emit stateChanged(this->state());
+}
@@ -0,0 +1,128 @@
+#ifndef DYNORUN_H
+#define DYNORUN_H
+
+#include <QObject>
+#include <QVector>
+#include <QPointF>
+#include <QTimer>
+#include <QStringList>
+#include <QtCharts/QAbstractSeries>
+
+QT_CHARTS_USE_NAMESPACE
+
+class DashBoard;
+class ChannelHistory;
+
+/*
+ * The power and torque curves of a dyno run, binned by rpm.
+ */
+struct DynoCurve
+{
+    QVector<qreal> rpm;
+    QVector<qreal> power;
+    QVector<qreal> torque;
+    qreal peakPower;
+    qreal peakPowerRpm;
+    qreal peakTorque;
+    qreal peakTorqueRpm;
+
+    DynoCurve() : peakPower(0), peakPowerRpm(0), peakTorque(0), peakTorqueRpm(0) {}
+    void clear();
+    void updatePeaks();
+};
+
+/*
+ * Virtual dyno; captures a full throttle pull and turns it into power and torque curves.
+ *
+ * Once armed the start and the end of the pull are detected from rpm and longitudinal
+ * acceleration. The pull itself is taken from the channel history, so it has every sample
+ * that was received and not just the ones seen by the poll timer. The acceleration and speed
+ * are filtered forward and backward (no phase lag, so the curves are not shifted in rpm)
+ * and the result is averaged into fixed rpm bins.
+ */
+class DynoRun : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QString state READ state NOTIFY stateChanged)
+    Q_PROPERTY(qreal peakPower READ peakPower NOTIFY runFinished)
+    Q_PROPERTY(qreal peakPowerRpm READ peakPowerRpm NOTIFY runFinished)
+    Q_PROPERTY(qreal peakTorque READ peakTorque NOTIFY runFinished)
+    Q_PROPERTY(qreal peakTorqueRpm READ peakTorqueRpm NOTIFY runFinished)
+    Q_PROPERTY(qreal comparePeakPower READ comparePeakPower NOTIFY compareChanged)
+    Q_PROPERTY(qreal comparePeakTorque READ comparePeakTorque NOTIFY compareChanged)
+    Q_PROPERTY(QStringList savedRuns READ savedRuns NOTIFY savedRunsChanged)
+
+public:
+    enum State {
+        Idle,
+        Armed,
+        Pulling,
+        Finished
+    };
+
+    // rpm width of the bins of the curves
+    static const int RPM_BIN_SIZE = 100;
+    // the pull is resampled to this interval before it is filtered
+    static const int SAMPLE_INTERVAL_MS = 10;
+    // cut off of the forward backward low pass filter of acceleration and speed
+    static const qreal FILTER_CUTOFF_HZ;
+    // a pull starts once the car accelerates and the rpm rose this much from the lowest armed rpm
+    static const qreal PULL_START_ACCEL;
+    static const int PULL_START_RPM_RISE = 150;
+    // a pull ends once rpm dropped this much from the highest rpm (shift or lift)
+    static const int PULL_END_RPM_DROP = 200;
+    // shorter pulls are dropped and the dyno stays armed
+    static const int PULL_MIN_RPM_SPAN = 1000;
+
+    explicit DynoRun(QObject *parent = 0);
+    explicit DynoRun(DashBoard *dashboard, ChannelHistory *channelHistory, QObject *parent = 0);
+
+    Q_INVOKABLE void arm();
+    Q_INVOKABLE void cancel();
+    // Replaces the points of a line series with a finished curve;
+    // "Power", "Torque", "ComparePower" or "CompareTorque"
+    Q_INVOKABLE void updateSeries(QAbstractSeries *series, const QString &curve);
+    Q_INVOKABLE bool saveRun(const QString &name);
+    Q_INVOKABLE bool loadCompareRun(const QString &name);
+    Q_INVOKABLE void clearCompareRun();
+    Q_INVOKABLE void readSavedRuns();
+
+    QString state() const;
+    qreal peakPower() const { return m_curve.peakPower; }
+    qreal peakPowerRpm() const { return m_curve.peakPowerRpm; }
+    qreal peakTorque() const { return m_curve.peakTorque; }
+    qreal peakTorqueRpm() const { return m_curve.peakTorqueRpm; }
+    qreal comparePeakPower() const { return m_compareCurve.peakPower; }
+    qreal comparePeakTorque() const { return m_compareCurve.peakTorque; }
+    QStringList savedRuns() const { return m_savedRuns; }
+
+signals:
+    void stateChanged(QString state);
+    void runFinished();
+    void compareChanged();
+    void savedRunsChanged(QStringList savedRuns);
+
+private slots:
+    void poll();
+
+private:
+    void setState(State state);
+    void finishPull();
+    bool buildCurve(qint64 fromMs, qint64 toMs, DynoCurve &curve) const;
+    static void filtfilt(QVector<qreal> &values, qreal alpha);
+
+    DashBoard *m_dashboard;
+    ChannelHistory *m_channelHistory;
+    QTimer m_pollTimer;
+    State m_state;
+    qreal m_lowRpm;
+    qint64 m_lowRpmMs;
+    qreal m_highRpm;
+    qint64 m_highRpmMs;
+    DynoCurve m_curve;
+    DynoCurve m_compareCurve;
+    QStringList m_savedRuns;
+    QVector<QPointF> m_points;
+};
+
+#endif // DYNORUN_H
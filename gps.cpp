@@ -1,53 +1,94 @@
 #include "gps.h"
 #include "dashboard.h"
 #include "connect.h"
+#include "gpsimufusion.h"
 #include <QDebug>
 #include <QByteArrayMatcher>
 #include <QTime>
 #include <QTimer>
 
-int initialized = 0;
-int rateset = 0 ;
-int raterequ = 0;
-int baudrate;
-QString GPSPort;
+// Tried in this order until valid NMEA or UBX data arrives; 9600 is the u-blox default
+static const int BAUD_RATES[] = { 9600, 115200, 38400, 57600, 19200, 230400 };
+static const int BAUD_RATE_COUNT = sizeof(BAUD_RATES) / sizeof(BAUD_RATES[0]);
+static const int CONFIGURED_BAUD_RATE = 115200;
+static const int MSECS_PER_DAY = 86400000;
+// A line is only checked between fixes at most this far apart; after a dropout the segment from the
+// last fix could cross the finish line anywhere
+static const int MAX_FIX_INTERVAL_MS = 1000;
+// NMEA has no position accuracy; a typical value for a single frequency receiver with a good sky view
+static const qreal NMEA_POSITION_ACCURACY_M = 2.5;
+
 QTime fastestlap(0, 0);
-QByteArray ACK10HZ = QByteArray::fromHex("b562050102000608");
-QByteArray NACK10HZ = QByteArray::fromHex("050002");
-QByteArray line;
 int Laps = 0;
-double startlineX1 ; //Longitude
-double startlineX2 ; //Longitude
-double startlineY1 ; //Latitude
-double startlineY2 ; //Latitude
-double m;
-double b;
-double interrim;
-double intercept;
-double currentintercept;
-double previousintercept;
-int linedirection; // Direction of the finish line 0 = Latitude 1 = Longitude
 
 GPS::GPS(QObject *parent)
     : QObject(parent)
     , m_dashboard(Q_NULLPTR)
+    , m_tracks(Q_NULLPTR)
+    , m_fusion(Q_NULLPTR)
+    , m_serialport(Q_NULLPTR)
+    , m_gpsTimeSecond(-1)
+    , m_ubxMode(false)
+    , m_rate(10)
+    , m_state(Closed)
+    , m_baudIndex(0)
+    , m_commandCount(0)
+    , m_retries(0)
+    , m_previousLatitude(0)
+    , m_previousLongitude(0)
+    , m_previousFixTime(-1)
+    , m_lapStartTime(-1)
+    , m_finishDirection(0)
+    , m_nextSector(0)
+    , m_sectorStartTime(-1)
+    , m_trackSelected(false)
 {
+    m_finishLine.latitude1 = 0;
+    m_finishLine.longitude1 = 0;
+    m_finishLine.latitude2 = 0;
+    m_finishLine.longitude2 = 0;
 
 }
 
-GPS::GPS(DashBoard *dashboard, QObject *parent)
+GPS::GPS(DashBoard *dashboard, TrackDatabase *tracks, QObject *parent)
     : QObject(parent)
     , m_dashboard(dashboard)
+    , m_tracks(tracks)
+    , m_fusion(Q_NULLPTR)
+    , m_serialport(Q_NULLPTR)
+    , m_gpsTimeSecond(-1)
+    , m_ubxMode(false)
+    , m_rate(10)
+    , m_state(Closed)
+    , m_baudIndex(0)
+    , m_commandCount(0)
+    , m_retries(0)
+    , m_previousLatitude(0)
+    , m_previousLongitude(0)
+    , m_previousFixTime(-1)
+    , m_lapStartTime(-1)
+    , m_finishDirection(0)
+    , m_nextSector(0)
+    , m_sectorStartTime(-1)
+    , m_trackSelected(false)
 {
+    m_finishLine.latitude1 = 0;
+    m_finishLine.longitude1 = 0;
+    m_finishLine.latitude2 = 0;
+    m_finishLine.longitude2 = 0;
 }
 
 void GPS::initSerialPort()
 {
-    m_serialport = new SerialPort(this);
+    if (!m_serialport)
+        m_serialport = new SerialPort(this);
     connect(this->m_serialport,SIGNAL(readyRead()),this,SLOT(readyToRead()));
     connect(m_serialport, static_cast<void (QSerialPort::*)(QSerialPort::SerialPortError)>(&QSerialPort::error),
             this, &GPS::handleError);
+    m_timeouttimer.setSingleShot(true);
+    m_commandtimer.setSingleShot(true);
     connect(&m_timeouttimer, &QTimer::timeout, this, &GPS::handleTimeout);
+    connect(&m_commandtimer, &QTimer::timeout, this, &GPS::handleCommandTimeout);
 }
 
 //function for flushing all serial buffers
@@ -55,31 +96,23 @@ void GPS::clear()
 {
     m_serialport->clear();
 }
-//function to open serial port
+//function to open serial port; Baud is the first baud rate tried
 void GPS::openConnection(const QString &portName,const QString &Baud)
-{   
-    GPSPort = portName;
-    //qDebug()<< "GPS Port Name : " + GPSPort;
+{
+    if (m_state != Closed)
+        closeConnection();
+    //qDebug()<< "GPS Port Name : " + portName;
     initSerialPort();
-    m_timeouttimer.start(5000);
     m_dashboard->setgpsFIXtype("open Serial " + portName);
-    baudrate = Baud.toInt();
     m_serialport->setPortName(portName);
 
-    m_dashboard->setgpsFIXtype("open with " + Baud );
-    switch (baudrate)
+    m_baudIndex = 0;
+    for (int i = 0; i < BAUD_RATE_COUNT; i++)
     {
-    case 9600:
-        m_serialport->setBaudRate(QSerialPort::Baud9600);
-        break;
-    case 115200:
-        m_serialport->setBaudRate(QSerialPort::Baud115200);
-        break;
-    default:
-        m_serialport->setBaudRate(QSerialPort::Baud9600);
-        break;
+        if (BAUD_RATES[i] == Baud.toInt())
+            m_baudIndex = i;
     }
-
+    m_serialport->setBaudRate(BAUD_RATES[m_baudIndex]);
     m_serialport->setParity(QSerialPort::NoParity);
     m_serialport->setDataBits(QSerialPort::Data8);
     m_serialport->setStopBits(QSerialPort::OneStop);
@@ -89,72 +122,171 @@ void GPS::openConnection(const QString &portName,const QString &Baud)
     if(m_serialport->open(QIODevice::ReadWrite) == false)
     {
         GPS::closeConnection();
+        return;
     }
+    startDetection();
+}
 
-
+void GPS::startDetection()
+{
+    m_commands.clear();
+    m_commandtimer.stop();
+    m_state = Detecting;
+    m_dashboard->setgpsFIXtype("Detect " + QString::number(BAUD_RATES[m_baudIndex]));
+    m_timeouttimer.start(DETECT_TIMEOUT_MS);
 }
 
-void GPS::removeNMEAmsg()
+// Any valid sentence or frame: the baud rate is right and the receiver is alive
+void GPS::dataReceived()
 {
-    //disables all the NMEA mesages that we don't need ( we only need RMC and  GGA)
-    setGPSOnly();
-    m_dashboard->setgpsFIXtype("Disable messages");
-    m_serialport->write(QByteArray::fromHex("B56206010800F0050000000000000446")); //VTG OFF
-    m_serialport->waitForBytesWritten(4000);
-    m_serialport->write(QByteArray::fromHex("B56206010800F0020000000000000131")); //GSA_Off
-    m_serialport->waitForBytesWritten(4000);
-    m_serialport->write(QByteArray::fromHex("B56206010800F0030000000000000238")); //GSV_Off
-    m_serialport->waitForBytesWritten(4000);
-    m_serialport->write(QByteArray::fromHex("B56206010800F001000000000000002A")); //GLL_Off
-    m_serialport->waitForBytesWritten(4000);
-    m_serialport->write(QByteArray::fromHex("B56206010800F008000000000000075B")); //ZDA_Off
-    m_serialport->waitForBytesWritten(4000);
+    switch (m_state)
+    {
+    case Detecting:
+        m_timeouttimer.stop();
+        configure();
+        break;
+    case Running:
+        m_timeouttimer.start(DATA_TIMEOUT_MS);
+        break;
+    default:
+        break;
+    }
+}
 
+void GPS::configure()
+{
+    m_state = Configuring;
+    // Use only GPS, so the receiver can run the higher update rates
+    queueCommand(0x3E, QByteArray::fromHex("00002005000810000100010101010300000001010308100000000101050003000000010106080E0000000101"), "GPS only");
+    // Update rate, one navigation solution per measurement, aligned to GPS time
+    const int measRate = 1000 / m_rate;
+    QByteArray rate;
+    rate.append(char(measRate & 0xFF));
+    rate.append(char(measRate >> 8));
+    rate.append(QByteArray::fromHex("01000100"));
+    queueCommand(0x08, rate, QString::number(m_rate) + "Hz");
+    if (m_ubxMode)
+    {
+        //Send NAV-PVT with every navigation solution
+        queueCommand(0x01, QByteArray::fromHex("010701"), "NAV-PVT on");
+    }
+    else
+    {
+        //disables all the NMEA mesages that we don't need ( we only need RMC and  GGA)
+        queueCommand(0x01, QByteArray::fromHex("F005000000000000"), "VTG off");
+        queueCommand(0x01, QByteArray::fromHex("F002000000000000"), "GSA off");
+        queueCommand(0x01, QByteArray::fromHex("F003000000000000"), "GSV off");
+        queueCommand(0x01, QByteArray::fromHex("F001000000000000"), "GLL off");
+        queueCommand(0x01, QByteArray::fromHex("F008000000000000"), "ZDA off");
+    }
+    //Set Ublox GPS to use baudrate of 115200, sending either NMEA or UBX only
+    queueCommand(0x00, QByteArray::fromHex(m_ubxMode ? "01000000D008000000C201000700010000000000"
+                                                     : "01000000D008000000C201000700020000000000"), "115k");
+    m_commandCount = m_commands.size();
+    sendCommand();
 }
-void GPS::setGPSBAUD115()
+
+void GPS::queueCommand(unsigned char messageId, const QByteArray &payload, const QString &description)
 {
-    //Set Ublox GPS to use baudrate of 115200
-    m_dashboard->setgpsFIXtype("GPS set 115k");
-    m_serialport->write(QByteArray::fromHex("B5620600140001000000D008000000C201000700020000000000BF78"));
-    m_serialport->waitForBytesWritten(4000);
-    closeConnection1();
+    UbxCommand command;
+    command.messageId = messageId;
+    command.description = description;
+    command.frame.append(char(UbxParser::SYNC1));
+    command.frame.append(char(UbxParser::SYNC2));
+    command.frame.append(char(UbxParser::CLASS_CFG));
+    command.frame.append(char(messageId));
+    command.frame.append(char(payload.size() & 0xFF));
+    command.frame.append(char(payload.size() >> 8));
+    command.frame.append(payload);
+    unsigned char ckA;
+    unsigned char ckB;
+    UbxParser::checksum(reinterpret_cast<const unsigned char *>(command.frame.constData()) + 2, command.frame.size() - 2, ckA, ckB);
+    command.frame.append(char(ckA));
+    command.frame.append(char(ckB));
+    m_commands.enqueue(command);
 }
-void GPS::setGPS10HZ()
+
+// Writes the command at the head of the queue; the queue moves on with its ACK/NAK or timeout
+void GPS::sendCommand()
 {
-    //Set Ublox GPS Update Rate to 10Hz
-    m_dashboard->setgpsFIXtype("GPS set 10HZ");
-    m_serialport->write(QByteArray::fromHex("b562060806006400010001007a12"));
-    m_serialport->waitForBytesWritten(4000);
+    if (m_commands.isEmpty())
+    {
+        m_state = Running;
+        m_dashboard->setgpsFIXtype("GPS ready");
+        m_timeouttimer.start(DATA_TIMEOUT_MS);
+        return;
+    }
+    const UbxCommand &command = m_commands.head();
+    m_dashboard->setgpsFIXtype(QString("Config %1/%2 %3").arg(m_commandCount - m_commands.size() + 1)
+                               .arg(m_commandCount).arg(command.description));
+    m_serialport->write(command.frame);
+    // the port configuration is answered at the new baud rate, if at all
+    m_commandtimer.start(command.messageId == 0x00 ? BAUD_SWITCH_DELAY_MS : ACK_TIMEOUT_MS);
+}
 
+void GPS::nextCommand()
+{
+    m_commandtimer.stop();
+    m_retries = 0;
+    m_commands.dequeue();
+    sendCommand();
 }
-void GPS::setGPSOnly()
+
+void GPS::handleCommandTimeout()
 {
-    // Switch on GPS only
-    m_serialport->write(QByteArray::fromHex("B562063E2C0000201005000810000100010101010300000001010308100000000101050003000000010106080E00000001010CD1")); //GPS Only
-    m_serialport->waitForBytesWritten(4000);
+    if (m_state != Configuring || m_commands.isEmpty())
+        return;
+    const UbxCommand &command = m_commands.head();
+    if (command.messageId == 0x00)
+    {
+        if (m_serialport->bytesToWrite() > 0)
+        {
+            m_commandtimer.start(BAUD_SWITCH_DELAY_MS);
+            return;
+        }
+        m_serialport->setBaudRate(CONFIGURED_BAUD_RATE);
+        for (int i = 0; i < BAUD_RATE_COUNT; i++)
+        {
+            if (BAUD_RATES[i] == CONFIGURED_BAUD_RATE)
+                m_baudIndex = i;
+        }
+        nextCommand();
+        return;
+    }
+    if (++m_retries < MAX_RETRIES)
+    {
+        m_serialport->write(command.frame);
+        m_commandtimer.start(ACK_TIMEOUT_MS);
+        return;
+    }
+    qDebug() << "GPS no ACK" << command.description;
+    nextCommand();
+}
 
+void GPS::setFusion(GpsImuFusion *fusion)
+{
+    m_fusion = fusion;
 }
-void GPS::closeConnection()
+void GPS::setMode(const int &mode)
 {
-    disconnect(this->m_serialport,SIGNAL(readyRead()),this,SLOT(readyToRead()));
-    disconnect(m_serialport, static_cast<void (QSerialPort::*)(QSerialPort::SerialPortError)>(&QSerialPort::error),
-               this, &GPS::handleError);
-    disconnect(&m_timeouttimer, &QTimer::timeout, this, &GPS::handleTimeout);
-    m_serialport->close();
-    m_dashboard->setgpsFIXtype("close serial");
+    m_ubxMode = mode != 0;
+    m_rate = mode == 2 ? 25 : 10;
 }
-void GPS::closeConnection1()
+void GPS::closeConnection()
 {
-    m_dashboard->setgpsFIXtype("close connection");
+    m_timeouttimer.stop();
+    m_commandtimer.stop();
+    m_commands.clear();
+    m_state = Closed;
+    if (!m_serialport)
+        return;
     disconnect(this->m_serialport,SIGNAL(readyRead()),this,SLOT(readyToRead()));
     disconnect(m_serialport, static_cast<void (QSerialPort::*)(QSerialPort::SerialPortError)>(&QSerialPort::error),
                this, &GPS::handleError);
     disconnect(&m_timeouttimer, &QTimer::timeout, this, &GPS::handleTimeout);
+    disconnect(&m_commandtimer, &QTimer::timeout, this, &GPS::handleCommandTimeout);
     m_serialport->close();
-    initialized =1;
     m_dashboard->setgpsFIXtype("close serial");
-    openConnection(GPSPort,"115200");
-
 }
 
 void GPS::handleError(QSerialPort::SerialPortError serialPortError)
@@ -166,133 +298,173 @@ void GPS::handleError(QSerialPort::SerialPortError serialPortError)
 }
 
 void GPS::readyToRead()
-{    
-
-    QByteArray rawData = m_serialport->readAll();          // read data from serial port
+{
+    SampleTimeScope received(m_dashboard, SampleClock::now());
+    const QByteArray rawData = m_serialport->readAll();          // read data from serial port
     //qDebug()<< "chunk " << rawData;
-    line.append(rawData);
-    if (line.contains("\r\n"))
-    {
-        //int end = line.indexOf("\r\n") + 2;
-        int end = line.lastIndexOf("\r\n") + 2;
-        QByteArray message = line;
-        //qDebug()<< "line raw" << line;
-        message.remove(end, line.length());
-        //qDebug()<< "Processed Message" << message;
-        line.remove(0,end);
-        //qDebug()<< "line new" << line;
-        ProcessMessage(message);
-    }
-
-
-/*
-    for (int i=0; i < rawData.size(); i++)
-    {
-       //line << rawData[i];
-       line.append(rawData);
-       if (line.size() >= 2 && line[line.size()-2] == '\r' && line[line.size()-1] == '\n')
-       {
-          qDebug()<< "line " << line;
-          //emit(line);
-          line.clear();
-       }
-    }
-*/
-    /*
-    if(this->m_serialport->canReadLine()){
-        QByteArray line = m_serialport->readLine();
-        if(line.startsWith("$GPRMC"))
-            processGPRMC(line);
-        m_timeouttimer.stop();
 
+    // every sentence of the chunk, also when a chunk holds several or ends in the middle of one
+    const char *data = rawData.constData();
+    int remaining = rawData.size();
+    while (remaining > 0)
+    {
+        const int used = m_nmea.feed(data, remaining);
+        data += used;
+        remaining -= used;
+        if (m_nmea.hasSentence())
+            processSentence();
+    }
 
-        */
+    // UBX frames: the configuration acknowledges and, in UBX mode, the navigation solution
+    data = rawData.constData();
+    remaining = rawData.size();
+    while (remaining > 0)
+    {
+        const int used = m_ubx.feed(data, remaining);
+        data += used;
+        remaining -= used;
+        if (m_ubx.hasFrame())
+            processFrame();
     }
-void GPS::ProcessMessage(QByteArray messageline)
+}
+
+void GPS::processSentence()
 {
-    m_timeouttimer.stop();
-    if(messageline.contains("$GNGGA"))
-        if (rateset == 0)
+    dataReceived();
+    if (m_state != Running)
+        return;
+    if (m_nmea.isType("GGA"))
+    {
+        processGGA();
+    }
+    else if (m_nmea.isType("RMC"))
+    {
+        processRMC();
+    }
+}
+
+void GPS::processFrame()
+{
+    dataReceived();
+    bool acknowledged;
+    unsigned char messageClass;
+    unsigned char messageId;
+    if (m_ubx.acknowledge(acknowledged, messageClass, messageId))
+    {
+        if (m_state == Configuring && !m_commands.isEmpty() && messageClass == UbxParser::CLASS_CFG
+                && messageId == m_commands.head().messageId)
         {
-            //Use only GPS
-            setGPS10HZ();
-            rateset = 1;
+            if (!acknowledged)
+                qDebug() << "GPS NAK" << m_commands.head().description;
+            nextCommand();
         }
-    if(messageline.startsWith("$GPGGA"))
+        return;
+    }
+    UbxNavPvt pvt;
+    if (m_state == Running && m_ubx.navPvt(pvt))
     {
-        processGPGGA(messageline);
+        processNavPvt(pvt);
+    }
+}
 
+void GPS::processNavPvt(const UbxNavPvt &pvt)
+{
+    const bool fixOk = pvt.flags & 0x01;
+    switch (fixOk ? pvt.fixType : 0) {
+    case 2:
+        m_dashboard->setgpsFIXtype("2D fix");
+        break;
+    case 3:
+        m_dashboard->setgpsFIXtype((pvt.flags & 0x02) ? "DGPS" : "3D fix");
+        break;
+    case 4:
+        m_dashboard->setgpsFIXtype("GNSS + DR");
+        break;
+    default:
+        m_dashboard->setgpsFIXtype("No fix yet");
+        break;
     }
-    if(messageline.startsWith("$GPRMC"))
+    if (pvt.valid & 0x02)
     {
-        //qDebug()<< "GPRMC";
-        processGPRMC(messageline);
+        const int second = (pvt.hour * 60 + pvt.min) * 60 + pvt.sec;
+        if (second != m_gpsTimeSecond)
+        {
+            m_gpsTimeSecond = second;
+            m_dashboard->setgpsTime(QTime(pvt.hour, pvt.min, pvt.sec).toString("hh:mm:ss"));
+        }
+        SampleClock::setGpsReference(m_dashboard->sampleTime(), ((pvt.hour * 60 + pvt.min) * 60 + pvt.sec) * 1000 + pvt.nano / 1000000);
     }
-        /*
-    if(messageline.startsWith("$GPVTG"))
+    m_dashboard->setgpsVisibleSatelites(pvt.numSV);
+    if (!fixOk || pvt.fixType < 2 || pvt.fixType > 4)
     {
-        processGPVTG(messageline);
-
+        m_dashboard->setgpsSpeed(0);
+        m_previousFixTime = -1;
+        return;
     }
-    */
-    if (messageline.contains(ACK10HZ))
+    m_dashboard->setgpsLatitude(pvt.lat * 1e-7);
+    m_dashboard->setgpsLongitude(pvt.lon * 1e-7);
+    m_dashboard->setgpsAltitude(pvt.hMSL / 1000.0);
+    m_dashboard->setgpsbaering(pvt.headMot * 1e-5);
+    m_dashboard->setgpsSpeed(qRound(pvt.gSpeed * 0.0036));// mm/s to km/h, rounded to the nearest integer
+    if (m_fusion)
+        m_fusion->addFix(pvt.lat * 1e-7, pvt.lon * 1e-7, pvt.gSpeed * 0.0036, pvt.headMot * 1e-5, pvt.hAcc / 1000.0);
+
+    // GPS time of day; only differences are used, so the leap seconds to UTC do not matter
+    checknewLap(pvt.iTOW % MSECS_PER_DAY);
+}
+
+void GPS::handleTimeout()
+{
+    if (m_state == Detecting)
     {
-        //qDebug() << "ACK 10Hz" <<messageline.toHex();
-        m_dashboard->setgpsFIXtype("10Hz ACK");
-        rateset = 1;
-        removeNMEAmsg();
-        setGPSBAUD115();
+        // nothing valid at this baud rate, try the next one
+        m_baudIndex = (m_baudIndex + 1) % BAUD_RATE_COUNT;
+        m_serialport->setBaudRate(BAUD_RATES[m_baudIndex]);
+        m_serialport->clear();
     }
-
-
+    // else the data stopped; detect again, starting at the current baud rate
+    startDetection();
 }
 
-void GPS::handleTimeout()
+void GPS::processRMC()
 {
-    //Timeout will occur if the GPS was already initialized and still opened at 9600 Baud
-    m_dashboard->setgpsFIXtype("Timeout");
-    setGPSBAUD115();
-    // closeConnection();
-    // openConnection("ttyAMA0","115200");
-}
-
-void GPS::processGPRMC(const QString & line){
-    //qDebug()<< "GPRMC Processing";
-    QStringList fields = line.split(',');
-    QString time = fields[1];
-    time.insert(2,":");
-    time.insert(5,":");
-    QString latitude = fields[3];
-    QString latDirection = fields[4];
-    QString longitude = fields[5];
-    QString lonDirection = fields[6];
-    QString groundspeedknots = fields[7];
-    QString bearing = fields[8];
-    if (bearing != "")
+    //qDebug()<< "RMC Processing";
+    int time;
+    // the time is shown to the second; it is only formatted when the second changes
+    if (m_nmea.fieldTime(1, time) && time / 1000 != m_gpsTimeSecond)
+    {
+        m_gpsTimeSecond = time / 1000;
+        m_dashboard->setgpsTime(QTime(0, 0).addMSecs(time).toString("hh:mm:ss"));
+    }
+    double bearing = m_dashboard->gpsbaering();
+    if (m_nmea.fieldDouble(8, bearing))
     {
         //We update bearing only if we have a valid baering
-        m_dashboard->setgpsbaering(bearing.toDouble());
+        m_dashboard->setgpsbaering(bearing);
     }
-
-    double speed = groundspeedknots.toDouble() * 1.852;
+    double speed = 0;
+    m_nmea.fieldDouble(7, speed);
+    speed *= 1.852; // knots
     /*   if (speed < 2)
     {
         speed = 0; // this is to ensure we show 0 if we standing as GPS sometimes sends a value greater 0 when standing still
     }*/
-    QString decLat = convertToDecimal(latitude, latDirection);
-    QString decLon = convertToDecimal(longitude, lonDirection);
-
-
-    m_dashboard->setgpsLatitude(decLat.toDouble());
-    m_dashboard->setgpsLongitude(decLon.toDouble());
+    double latitude;
+    double longitude;
+    if (m_nmea.fieldCoordinate(3, latitude) && m_nmea.fieldCoordinate(5, longitude))
+    {
+        m_dashboard->setgpsLatitude(latitude);
+        m_dashboard->setgpsLongitude(longitude);
+        if (m_fusion && m_nmea.fieldChar(2) == 'A')
+            m_fusion->addFix(latitude, longitude, speed, bearing, NMEA_POSITION_ACCURACY_M);
+    }
     m_dashboard->setgpsSpeed(qRound(speed));// round speed to the nearest integer
-    m_dashboard->setgpsTime(time);
 }
 
-void GPS::processGPGGA(const QString & line)
+void GPS::processGGA()
 {
-    QStringList fields = line.split(',');
-    int fixquality = fields[6].toInt();
+    int fixquality = 0;
+    m_nmea.fieldInt(6, fixquality);
 
     switch (fixquality) {
     case 0:
@@ -308,140 +480,249 @@ void GPS::processGPGGA(const QString & line)
         m_dashboard->setgpsFIXtype("No fix yet");
         break;
     }
-    QString latitude = fields[2];
-    QString latDirection = fields[3];
-    QString longitude = fields[4];
-    QString lonDirection = fields[5];
-    QString decLat = convertToDecimal(latitude, latDirection);
-    QString decLon = convertToDecimal(longitude, lonDirection);
+    double latitude;
+    double longitude;
+    if (m_nmea.fieldCoordinate(2, latitude) && m_nmea.fieldCoordinate(4, longitude))
+    {
+        m_dashboard->setgpsLatitude(latitude);
+        m_dashboard->setgpsLongitude(longitude);
+    }
+    int satelitesinview = 0;
+    double altitude = 0;
+    m_nmea.fieldInt(7, satelitesinview);
+    m_nmea.fieldDouble(9, altitude);
+    m_dashboard->setgpsVisibleSatelites(satelitesinview);
+    m_dashboard->setgpsAltitude(altitude);
+
+    int time;
+    if (m_nmea.fieldTime(1, time))
+    {
+        SampleClock::setGpsReference(m_dashboard->sampleTime(), time);
+        // laps are only timed on valid fixes
+        if (fixquality > 0)
+            checknewLap(time);
+        else
+            m_previousFixTime = -1;
+    }
+}
 
-    QString satelitesinview = fields[7];
-    QString altitude = fields[9];
-    m_dashboard->setgpsLatitude(decLat.toDouble());
-    m_dashboard->setgpsLongitude(decLon.toDouble());
-    m_dashboard->setgpsVisibleSatelites(satelitesinview.toInt());
-    m_dashboard->setgpsAltitude(altitude.toDouble());
 
-    checknewLap();
-}
+//Laptimer
 
-void GPS::processGPVTG(const QString & line)
+static QString lapTimeString(int msecs)
 {
-    QStringList fields = line.split(',');
-    QString speed = fields[7];
-   // m_dashboard->setgpsSpeed(speed.toInt());
+    return QTime(0, 0).addMSecs(msecs).toString("mm:ss.zzz");
+}
 
+void GPS::defineFinishLine(const double & Y1,const double & X1,const double & Y2,const double & X2,const int & linedir)
+{
+    // linedir named the axis the crossing was checked on; the crossing is found on the line segment
+    // itself, and the direction it is crossed in is taken from the first crossing
+    Q_UNUSED(linedir);
+    m_trackSelected = true;
+    m_finishLine.latitude1 = Y1;
+    m_finishLine.longitude1 = X1;
+    m_finishLine.latitude2 = Y2;
+    m_finishLine.longitude2 = X2;
+    m_finishDirection = 0;
+    m_lapTrace.setOrigin((Y1 + Y2) / 2, (X1 + X2) / 2);
 }
-QString GPS::convertToDecimal(const QString & coord, const QString & dir)
+void GPS::addSectorLine(const double & Y1,const double & X1,const double & Y2,const double & X2)
 {
-    int decIndex = coord.indexOf('.');
-    QString minutes = coord.mid(decIndex- 2);
-    QString seconds = coord.mid(decIndex+1,2);
-    double dec = minutes.toDouble() * 60 / 3600;
-    double degrees = coord.mid(0, decIndex -2).toDouble();
-    double decCoord = dec + degrees;
-    if(dir == "W" || dir == "S")
-        decCoord *= -1.0;
-    return QString::number(decCoord,'f',6);
+    TimingLine line;
+    line.latitude1 = Y1;
+    line.longitude1 = X1;
+    line.latitude2 = Y2;
+    line.longitude2 = X2;
+    m_sectorLines.append(line);
+    m_sectorDirections.append(0);
 }
-
-
-//Laptimer
-
-void GPS::defineFinishLine(const double & Y1,const double & X1,const double & Y2,const double & X2,const int & linedir)
+void GPS::clearSectorLines()
+{
+    m_sectorLines.clear();
+    m_sectorDirections.clear();
+    m_nextSector = 0;
+}
+bool GPS::selectTrack(const QString &name)
 {
-    linedirection = linedir;
-    startlineX1 = X1; //Longitude
-    startlineX2 = X2; //Longitude
-    startlineY1 = Y1; //Latitude
-    startlineY2 = Y2; //Latitude
-    m = (startlineY1-startlineY2) / (startlineX1-startlineX2);
-    b = startlineY1 - (m*startlineX1);
-    qDebug()<<"Linedir"<< Y1<<X1<<Y2<<X2;
+    const int index = m_tracks ? m_tracks->indexOf(name) : -1;
+    if (index < 0)
+        return false;
+    selectTrack(index);
+    return true;
+}
+void GPS::selectTrack(int index)
+{
+    const Track &track = m_tracks->track(index);
+    m_trackSelected = true;
+    m_sectorLines = track.sectorLines;
+    m_sectorDirections.fill(0, m_sectorLines.size());
+    // the lap in progress, the best lap and the reference lap were timed on the previous track
+    resetLaptimer();
+    if (track.hasFinishLine)
+    {
+        m_finishLine = track.finishLine;
+        m_lapTrace.setOrigin((m_finishLine.latitude1 + m_finishLine.latitude2) / 2,
+                             (m_finishLine.longitude1 + m_finishLine.longitude2) / 2);
+    }
+    else
+    {
+        // a line of no length is never crossed; defineFinishLine sets one
+        m_finishLine.latitude1 = 0;
+        m_finishLine.longitude1 = 0;
+        m_finishLine.latitude2 = 0;
+        m_finishLine.longitude2 = 0;
+    }
+    emit trackSelected(track.name, track.latitude, track.longitude, track.zoomLevel, track.bearing);
 }
 void GPS::resetLaptimer()
 {
     Laps = 0;
-    m_timer.invalidate();
+    m_lapStartTime = -1;
+    m_sectorStartTime = -1;
+    m_nextSector = 0;
+    m_finishDirection = 0;
+    m_sectorDirections.fill(0);
+    m_lapTrace.clear();
     m_dashboard->setbestlaptime("00:00.000");
+    m_dashboard->setcurrentSector(0);
+    m_dashboard->setlapdelta(0);
 }
-void GPS::checknewLap()
+
+// Where the segment driven from the previous fix crosses the line, as a fraction of the segment,
+// and the side of the line it is crossed towards (the sign of the drive against the line normal).
+// Fractions are unchanged by scaling the axes, so latitude and longitude are used as they are.
+bool GPS::crossesLine(const TimingLine &line, double latitude, double longitude, double &fraction, int &direction) const
+{
+    const double driveX = longitude - m_previousLongitude;
+    const double driveY = latitude - m_previousLatitude;
+    const double lineX = line.longitude2 - line.longitude1;
+    const double lineY = line.latitude2 - line.latitude1;
+    const double denominator = driveX * lineY - driveY * lineX;
+    if (denominator == 0)
+        return false; // standing still or driving along the line
+    const double offsetX = line.longitude1 - m_previousLongitude;
+    const double offsetY = line.latitude1 - m_previousLatitude;
+    const double drive = (offsetX * lineY - offsetY * lineX) / denominator;
+    const double along = (offsetX * driveY - offsetY * driveX) / denominator;
+    // a fix exactly on the line belongs to the segment that ends there, so it is counted once
+    fraction = drive;
+    direction = denominator > 0 ? 1 : -1;
+    return drive > 0 && drive <= 1 && along >= 0 && along <= 1;
+}
+
+// A line crossed the other way (a spin, reversing over it) is not counted, nor is crossing it again
+// the right way after that. expected is the direction, doubled while the car is back behind the line.
+bool GPS::isForward(int &expected, int direction)
 {
-    currentintercept = m_dashboard->gpsLatitude() -( (m * m_dashboard->gpsLongitude()) + b);
-    if ((previousintercept <= 0 && currentintercept >= 0) || (previousintercept >= 0 && currentintercept <= 0) || (currentintercept == 0))
+    if (expected == 0)
+        expected = direction;
+    if (direction * expected < 0)
     {
-        switch (linedirection)
-        {
-        case 1:
+        expected = -2 * direction;
+        return false;
+    }
+    const bool behind = qAbs(expected) == 2;
+    expected = direction;
+    return !behind;
+}
 
-        //Finish Line East to West
-        if (m_dashboard->gpsLongitude() <= startlineX2 && m_dashboard->gpsLongitude() >= startlineX1 )
+// The car moved at a constant speed between the previous fix and this one
+int GPS::crossingTime(double fraction, int fixTime) const
+{
+    int interval = fixTime - m_previousFixTime;
+    if (interval < 0)
+        interval += MSECS_PER_DAY;
+    return (m_previousFixTime + qRound(fraction * interval)) % MSECS_PER_DAY;
+}
+
+// fixTime: time of the fix in ms since midnight
+void GPS::checknewLap(int fixTime)
+{
+    const double latitude = m_dashboard->gpsLatitude();
+    const double longitude = m_dashboard->gpsLongitude();
+    if (!m_trackSelected && m_tracks)
+    {
+        const int track = m_tracks->trackAt(latitude, longitude);
+        if (track >= 0)
+            selectTrack(track);
+    }
+    int interval = fixTime - m_previousFixTime;
+    if (interval < 0)
+        interval += MSECS_PER_DAY;
+    double fraction;
+    int direction;
+    if (m_previousFixTime >= 0 && interval > 0 && interval <= MAX_FIX_INTERVAL_MS)
+    {
+        // only the next sector line can be crossed
+        if (m_nextSector < m_sectorLines.size() && m_lapStartTime >= 0
+                && crossesLine(m_sectorLines.at(m_nextSector), latitude, longitude, fraction, direction)
+                && isForward(m_sectorDirections[m_nextSector], direction))
         {
-            qDebug() << "1";
-            if (m_timer.isValid() == true)
-            {
-                QTime y(0, 0);
-                                y = y.addMSecs(m_timer.elapsed());
-                                if (Laps == 1)
-                                {
-                                    fastestlap = y;
-                                    m_dashboard->setbestlaptime(fastestlap.toString("mm:ss.zzz"));
-                                }
-                                if (y < fastestlap)
-                                {
-                                   // qDebug() << "y is smaller";
-                                fastestlap = y;
-                                m_dashboard->setbestlaptime(y.toString("mm:ss.zzz"));
-                                }
-                                Laps++;
-                                m_dashboard->setlaptime(y.toString("mm:ss.zzz"));
-                                m_dashboard->setcurrentLap(Laps);
-                                m_timer.restart();
-            }
-            else{
-                m_timer.start();
-                Laps++;
-                m_dashboard->setcurrentLap(Laps);
-            }
+            sectorCompleted(crossingTime(fraction, fixTime));
         }
-            break;
-        case 2:
-
-        //Finish Line North to South
-        if (m_dashboard->gpsLatitude() <= startlineY2 && m_dashboard->gpsLatitude() >= startlineY1 )
+        if (crossesLine(m_finishLine, latitude, longitude, fraction, direction) && isForward(m_finishDirection, direction))
         {
-            //qDebug() << "2";
-            if (m_timer.isValid() == true)
-            {
-                QTime y(0, 0);
-                                y = y.addMSecs(m_timer.elapsed());
-                                if (Laps == 1)
-                                {
-                                    fastestlap = y;
-                                    m_dashboard->setbestlaptime(fastestlap.toString("mm:ss.zzz"));
-                                }
-                                if (y < fastestlap)
-                                {
-                                   // qDebug() << "y is smaller";
-                                fastestlap = y;
-                                m_dashboard->setbestlaptime(y.toString("mm:ss.zzz"));
-                                }
-                                Laps++;
-                                m_dashboard->setlaptime(y.toString("mm:ss.zzz"));
-                                m_dashboard->setcurrentLap(Laps);
-                                m_timer.restart();
-            }
-            else{
-                m_timer.start();
-                Laps++;
-                m_dashboard->setcurrentLap(Laps);
-            }
+            lapCompleted(crossingTime(fraction, fixTime));
         }
-        break;
+    }
+    m_previousLatitude = latitude;
+    m_previousLongitude = longitude;
+    m_previousFixTime = fixTime;
 
-    default:
-        break;
+    if (m_lapStartTime >= 0)
+    {
+        int laptime = fixTime - m_lapStartTime;
+        if (laptime < 0)
+            laptime += MSECS_PER_DAY;
+        m_lapTrace.addFix(latitude, longitude, laptime);
+        qreal delta;
+        if (m_lapTrace.delta(latitude, longitude, laptime, delta))
+            m_dashboard->setlapdelta(delta);
+    }
+}
+
+void GPS::sectorCompleted(int crossingTime)
+{
+    int sectortime = crossingTime - m_sectorStartTime;
+    if (sectortime < 0)
+        sectortime += MSECS_PER_DAY;
+    m_dashboard->setsectortime(lapTimeString(sectortime));
+    m_sectorStartTime = crossingTime;
+    m_nextSector++;
+    m_dashboard->setcurrentSector(m_nextSector + 1);
+}
+
+void GPS::lapCompleted(int crossingTime)
+{
+    if (m_lapStartTime >= 0)
+    {
+        if (!m_sectorLines.isEmpty())
+            sectorCompleted(crossingTime);
+        int laptime = crossingTime - m_lapStartTime;
+        if (laptime < 0)
+            laptime += MSECS_PER_DAY;
+        QTime y(0, 0);
+        y = y.addMSecs(laptime);
+        if (Laps == 1 || y < fastestlap)
+        {
+            // qDebug() << "y is smaller";
+            fastestlap = y;
+            m_dashboard->setbestlaptime(y.toString("mm:ss.zzz"));
+            m_lapTrace.keepAsReference();
+        }
+        Laps++;
+        m_dashboard->setlaptime(y.toString("mm:ss.zzz"));
+        m_dashboard->setcurrentLap(Laps);
     }
+    else
+    {
+        Laps++;
+        m_dashboard->setcurrentLap(Laps);
     }
-    previousintercept = currentintercept;
+    m_lapStartTime = crossingTime;
+    m_sectorStartTime = crossingTime;
+    m_nextSector = 0;
+    m_dashboard->setcurrentSector(1);
+    m_lapTrace.startLap();
 }
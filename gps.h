@@ -1,58 +1,137 @@
 #ifndef GPS_H
 #define GPS_H
 #include "serialport.h"
-#include <QElapsedTimer>
+#include "nmeaparser.h"
+#include "ubxparser.h"
+#include "laptrace.h"
+#include "trackdatabase.h"
 #include <QTimer>
+#include <QQueue>
 
 class DashBoard;
+class GpsImuFusion;
 class Serialport;
 
+/*
+ * u-blox GPS receiver.
+ *
+ * Bring-up never blocks: after openConnection the baud rate is detected (valid NMEA or UBX data),
+ * then the configuration is sent as a queue of UBX commands, each waiting for its ACK/NAK
+ * without blocking the event loop, and finally the port runs at 115200 baud. The progress is
+ * shown in gpsFIXtype. When the data stops the detection starts over.
+ */
 class GPS : public QObject
 {
     Q_OBJECT
 
 public:
+    static const int DETECT_TIMEOUT_MS = 1500;
+    static const int DATA_TIMEOUT_MS = 5000;
+    static const int ACK_TIMEOUT_MS = 1000;
+    static const int MAX_RETRIES = 3;
+    // time for the port configuration to leave the UART before the baud rate changes
+    static const int BAUD_SWITCH_DELAY_MS = 100;
+
     explicit GPS(QObject *parent = 0);
-    explicit GPS(DashBoard *dashboard, QObject *parent = 0);
+    explicit GPS(DashBoard *dashboard, TrackDatabase *tracks, QObject *parent = 0);
     Q_INVOKABLE void defineFinishLine(const double & Y1,const double & X1,const double & Y2,const double & X2,const int & linedir);
     Q_INVOKABLE void resetLaptimer();
+    // Sector lines in the order they are driven, after the finish line
+    Q_INVOKABLE void addSectorLine(const double & Y1,const double & X1,const double & Y2,const double & X2);
+    Q_INVOKABLE void clearSectorLines();
+    // Finish and sector lines of a track of the database; without a selection the track is
+    // selected by the first fix on it
+    Q_INVOKABLE bool selectTrack(const QString &name);
+    // 0 = NMEA 10 Hz, 1 = UBX NAV-PVT 10 Hz, 2 = UBX NAV-PVT 25 Hz; takes effect on the next openConnection
+    Q_INVOKABLE void setMode(const int &mode);
+    // Fixes are passed on to the GPS/IMU fusion
+    void setFusion(GpsImuFusion *fusion);
 
 private:
+    enum State {
+        Closed,
+        Detecting,
+        Configuring,
+        Running
+    };
+
+    struct UbxCommand
+    {
+        QByteArray frame;
+        unsigned char messageId; // of class CFG
+        QString description;
+    };
+
     DashBoard *m_dashboard;
+    TrackDatabase *m_tracks;
+    GpsImuFusion *m_fusion;
     SerialPort *m_serialport;
     QByteArray  m_readData;
     QByteArray  m_buffer;
-    QElapsedTimer m_timer;
     QTimer m_timeouttimer;
-    QString convertToDecimal(const QString & coord, const QString & dir);
-    void processGPRMC(const QString &line);
+    QTimer m_commandtimer;
+    NmeaParser m_nmea;
+    int m_gpsTimeSecond; // of the gpsTime shown, -1 = none
+    UbxParser m_ubx;
+    bool m_ubxMode;
+    int m_rate;
+    State m_state;
+    int m_baudIndex;
+    QQueue<UbxCommand> m_commands;
+    int m_commandCount;
+    int m_retries;
+    double m_previousLatitude;
+    double m_previousLongitude;
+    int m_previousFixTime;
+    int m_lapStartTime;
+    TimingLine m_finishLine;
+    QVector<TimingLine> m_sectorLines;
+    // the side each line is crossed towards on a lap (1 or -1), taken from its first crossing; 0 before,
+    // doubled while the car is back behind the line (see isForward)
+    int m_finishDirection;
+    QVector<int> m_sectorDirections;
+    int m_nextSector;
+    int m_sectorStartTime;
+    bool m_trackSelected;
+    LapTrace m_lapTrace;
+    void startDetection();
+    void dataReceived();
+    void configure();
+    void queueCommand(unsigned char messageId, const QByteArray &payload, const QString &description);
+    void sendCommand();
+    void nextCommand();
+    void processSentence();
+    void processFrame();
+    void processNavPvt(const UbxNavPvt &pvt);
+    void processRMC();
     void checklinecrossed();
     void linecrossed();
-    void processGPGGA(const QString &line);
-    void processGPVTG(const QString & line);
-    void checknewLap();
+    void processGGA();
+    void checknewLap(int fixTime);
+    void selectTrack(int index);
+    void lapCompleted(int crossingTime);
+    void sectorCompleted(int crossingTime);
+    bool crossesLine(const TimingLine &line, double latitude, double longitude, double &fraction, int &direction) const;
+    static bool isForward(int &expected, int direction);
+    int crossingTime(double fraction, int fixTime) const;
 
 
 
 public slots:
     //void delaytimer();
     void openConnection(const QString &portName,const QString &Baud);
-    void ProcessMessage(QByteArray messageline);
-    void removeNMEAmsg();
-    void setGPSBAUD115();
-    void setGPS10HZ();
-    void setGPSOnly();
     void closeConnection();
-    void closeConnection1();
     void clear();
 
 private slots:
     void readyToRead();
     void handleTimeout();
+    void handleCommandTimeout();
     void handleError(QSerialPort::SerialPortError error);
     void initSerialPort();
 signals:
     void sig_linecrossed();
+    void trackSelected(const QString &name, double latitude, double longitude, qreal zoomLevel, qreal bearing);
 
 };
 
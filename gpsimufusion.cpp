@@ -0,0 +1,248 @@
+#include "gpsimufusion.h"
+#include "dashboard.h"
+#include <QtMath>
+
+static const double METRES_PER_DEGREE_LATITUDE = 111319.49;
+// process noise as continuous white noise, so the variance grows with dt: IMU noise and bias
+// random walk, per square root of a second
+static const double ACCELERATION_NOISE = 0.1;      // m/s^2
+static const double YAW_RATE_NOISE = 0.005;        // rad/s
+static const double ACCELERATION_BIAS_WALK = 0.01; // m/s^2
+static const double YAW_RATE_BIAS_WALK = 0.001;    // rad/s
+// without IMU samples the model only knows the car accelerates and turns within these, so the
+// speed is uncertain by about 5 m/s after a second
+static const double UNMEASURED_ACCELERATION = 5;   // m/s^2
+static const double UNMEASURED_YAW_RATE = 0.5;     // rad/s
+// measurement noise of the fixes
+static const double SPEED_NOISE = 0.3;             // m/s
+static const double COURSE_NOISE = 0.035;          // rad
+// below this the course of the fixes is noise
+static const double MIN_COURSE_SPEED = 3;          // m/s
+// a fix this far from the origin moves it, so the flat earth approximation stays good
+static const double MAX_ORIGIN_DISTANCE = 10000;   // m
+
+static double wrapAngle(double angle)
+{
+    while (angle > M_PI)
+        angle -= 2 * M_PI;
+    while (angle < -M_PI)
+        angle += 2 * M_PI;
+    return angle;
+}
+
+GpsImuFusion::GpsImuFusion(QObject *parent)
+    : GpsImuFusion(Q_NULLPTR, parent)
+{
+}
+
+GpsImuFusion::GpsImuFusion(DashBoard *dashboard, QObject *parent)
+    : QObject(parent)
+    , m_dashboard(dashboard)
+    , m_simulatedTime(-1)
+    , m_lastStep(0)
+    , m_lastFix(0)
+    , m_initialized(false)
+    , m_originLatitude(0)
+    , m_originLongitude(0)
+    , m_metresPerDegreeLongitude(METRES_PER_DEGREE_LATITUDE)
+    , m_accelerationSum(0)
+    , m_accelerationSamples(0)
+    , m_yawRateSum(0)
+    , m_yawRateSamples(0)
+{
+    m_timer.setInterval(OUTPUT_INTERVAL_MS);
+    m_timer.setTimerType(Qt::PreciseTimer);
+    connect(&m_timer, &QTimer::timeout, this, &GpsImuFusion::step);
+    m_clock.start();
+}
+
+void GpsImuFusion::addAcceleration(qreal forward)
+{
+    m_accelerationSum += forward;
+    m_accelerationSamples++;
+}
+
+void GpsImuFusion::addYawRate(qreal rate)
+{
+    m_yawRateSum += qDegreesToRadians(rate);
+    m_yawRateSamples++;
+}
+
+void GpsImuFusion::addFix(double latitude, double longitude, qreal speed, qreal heading, qreal accuracy)
+{
+    const double metresPerSecond = speed / 3.6;
+    const double course = qDegreesToRadians(heading);
+    const double east = (longitude - m_originLongitude) * m_metresPerDegreeLongitude;
+    const double north = (latitude - m_originLatitude) * METRES_PER_DEGREE_LATITUDE;
+    if (!m_initialized || elapsedNs() / 1000000 - m_lastFix > FIX_TIMEOUT_MS
+            || qAbs(east) > MAX_ORIGIN_DISTANCE || qAbs(north) > MAX_ORIGIN_DISTANCE) {
+        initialize(latitude, longitude, metresPerSecond, course, accuracy);
+        return;
+    }
+    // bring the state to the time of the fix first
+    advance();
+    m_lastFix = elapsedNs() / 1000000;
+    const double positionVariance = accuracy * accuracy;
+    update(East, east, positionVariance);
+    update(North, north, positionVariance);
+    update(Speed, metresPerSecond, SPEED_NOISE * SPEED_NOISE);
+    if (metresPerSecond > MIN_COURSE_SPEED)
+        update(Course, m_state[Course] + wrapAngle(course - m_state[Course]), COURSE_NOISE * COURSE_NOISE);
+    m_state[Course] = wrapAngle(m_state[Course]);
+    publish();
+}
+
+void GpsImuFusion::initialize(double latitude, double longitude, qreal speed, qreal course, qreal accuracy)
+{
+    m_originLatitude = latitude;
+    m_originLongitude = longitude;
+    m_metresPerDegreeLongitude = METRES_PER_DEGREE_LATITUDE * qCos(qDegreesToRadians(latitude));
+    for (int i = 0; i < StateCount; i++) {
+        for (int j = 0; j < StateCount; j++)
+            m_covariance[i][j] = 0;
+    }
+    m_state[East] = 0;
+    m_state[North] = 0;
+    m_state[Speed] = speed;
+    m_state[Course] = wrapAngle(course);
+    m_state[AccelerationBias] = 0;
+    m_state[YawRateBias] = 0;
+    m_covariance[East][East] = accuracy * accuracy;
+    m_covariance[North][North] = accuracy * accuracy;
+    m_covariance[Speed][Speed] = SPEED_NOISE * SPEED_NOISE;
+    m_covariance[Course][Course] = speed > MIN_COURSE_SPEED ? COURSE_NOISE * COURSE_NOISE : M_PI * M_PI;
+    m_covariance[AccelerationBias][AccelerationBias] = 0.5 * 0.5;
+    m_covariance[YawRateBias][YawRateBias] = 0.05 * 0.05;
+    m_accelerationSum = 0;
+    m_accelerationSamples = 0;
+    m_yawRateSum = 0;
+    m_yawRateSamples = 0;
+    m_lastStep = elapsedNs();
+    m_lastFix = m_lastStep / 1000000;
+    if (!m_initialized) {
+        m_initialized = true;
+        m_timer.start();
+    }
+    publish();
+}
+
+void GpsImuFusion::step()
+{
+    if (elapsedNs() / 1000000 - m_lastFix > FIX_TIMEOUT_MS) {
+        m_initialized = false;
+        m_timer.stop();
+        return;
+    }
+    advance();
+    publish();
+}
+
+void GpsImuFusion::advance()
+{
+    const qint64 now = elapsedNs();
+    const double dt = (now - m_lastStep) / 1e9;
+    m_lastStep = now;
+    if (dt > 0)
+        predict(dt);
+}
+
+void GpsImuFusion::predict(double dt)
+{
+    const double acceleration = m_accelerationSamples ? m_accelerationSum / m_accelerationSamples : m_state[AccelerationBias];
+    const double yawRate = m_yawRateSamples ? m_yawRateSum / m_yawRateSamples : m_state[YawRateBias];
+    const double accelerationNoise = m_accelerationSamples ? ACCELERATION_NOISE : UNMEASURED_ACCELERATION;
+    const double yawRateNoise = m_yawRateSamples ? YAW_RATE_NOISE : UNMEASURED_YAW_RATE;
+    m_accelerationSum = 0;
+    m_accelerationSamples = 0;
+    m_yawRateSum = 0;
+    m_yawRateSamples = 0;
+
+    const double speed = m_state[Speed];
+    const double sinCourse = qSin(m_state[Course]);
+    const double cosCourse = qCos(m_state[Course]);
+    m_state[East] += speed * sinCourse * dt;
+    m_state[North] += speed * cosCourse * dt;
+    m_state[Speed] = qMax(0.0, speed + (acceleration - m_state[AccelerationBias]) * dt);
+    // the course is clockwise, the yaw rate counterclockwise
+    m_state[Course] = wrapAngle(m_state[Course] - (yawRate - m_state[YawRateBias]) * dt);
+
+    // P = F P F' + Q, with F the identity plus these entries
+    const double eastSpeed = sinCourse * dt;
+    const double eastCourse = speed * cosCourse * dt;
+    const double northSpeed = cosCourse * dt;
+    const double northCourse = -speed * sinCourse * dt;
+    const double speedBias = -dt;
+    const double courseBias = dt;
+    double fp[StateCount][StateCount];
+    for (int j = 0; j < StateCount; j++) {
+        const double (&p)[StateCount][StateCount] = m_covariance;
+        fp[East][j] = p[East][j] + eastSpeed * p[Speed][j] + eastCourse * p[Course][j];
+        fp[North][j] = p[North][j] + northSpeed * p[Speed][j] + northCourse * p[Course][j];
+        fp[Speed][j] = p[Speed][j] + speedBias * p[AccelerationBias][j];
+        fp[Course][j] = p[Course][j] + courseBias * p[YawRateBias][j];
+        fp[AccelerationBias][j] = p[AccelerationBias][j];
+        fp[YawRateBias][j] = p[YawRateBias][j];
+    }
+    for (int i = 0; i < StateCount; i++) {
+        m_covariance[i][East] = fp[i][East] + fp[i][Speed] * eastSpeed + fp[i][Course] * eastCourse;
+        m_covariance[i][North] = fp[i][North] + fp[i][Speed] * northSpeed + fp[i][Course] * northCourse;
+        m_covariance[i][Speed] = fp[i][Speed] + fp[i][AccelerationBias] * speedBias;
+        m_covariance[i][Course] = fp[i][Course] + fp[i][YawRateBias] * courseBias;
+        m_covariance[i][AccelerationBias] = fp[i][AccelerationBias];
+        m_covariance[i][YawRateBias] = fp[i][YawRateBias];
+    }
+    m_covariance[Speed][Speed] += accelerationNoise * accelerationNoise * dt;
+    m_covariance[Course][Course] += yawRateNoise * yawRateNoise * dt;
+    m_covariance[AccelerationBias][AccelerationBias] += ACCELERATION_BIAS_WALK * ACCELERATION_BIAS_WALK * dt;
+    m_covariance[YawRateBias][YawRateBias] += YAW_RATE_BIAS_WALK * YAW_RATE_BIAS_WALK * dt;
+}
+
+// Measurement of a single state; no matrix inversion needed
+void GpsImuFusion::update(int index, double measurement, double variance)
+{
+    const double innovationVariance = m_covariance[index][index] + variance;
+    if (innovationVariance <= 0)
+        return;
+    double gain[StateCount];
+    for (int i = 0; i < StateCount; i++)
+        gain[i] = m_covariance[i][index] / innovationVariance;
+    const double innovation = measurement - m_state[index];
+    double row[StateCount];
+    for (int j = 0; j < StateCount; j++)
+        row[j] = m_covariance[index][j];
+    for (int i = 0; i < StateCount; i++) {
+        m_state[i] += gain[i] * innovation;
+        for (int j = 0; j < StateCount; j++)
+            m_covariance[i][j] -= gain[i] * row[j];
+    }
+}
+
+qint64 GpsImuFusion::elapsedNs() const
+{
+    return m_simulatedTime >= 0 ? m_simulatedTime : m_clock.nsecsElapsed();
+}
+
+void GpsImuFusion::estimate(double &latitude, double &longitude, qreal &speed, qreal &heading) const
+{
+    latitude = m_originLatitude + m_state[North] / METRES_PER_DEGREE_LATITUDE;
+    longitude = m_originLongitude + m_state[East] / m_metresPerDegreeLongitude;
+    speed = m_state[Speed] * 3.6;
+    heading = qRadiansToDegrees(m_state[Course]);
+    if (heading < 0)
+        heading += 360;
+}
+
+void GpsImuFusion::publish()
+{
+    if (!m_dashboard)
+        return;
+    double latitude;
+    double longitude;
+    qreal speed;
+    qreal heading;
+    estimate(latitude, longitude, speed, heading);
+    m_dashboard->setfusedLatitude(latitude);
+    m_dashboard->setfusedLongitude(longitude);
+    m_dashboard->setfusedSpeed(speed);
+    m_dashboard->setfusedHeading(heading);
+}
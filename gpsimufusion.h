@@ -0,0 +1,88 @@
+#ifndef GPSIMUFUSION_H
+#define GPSIMUFUSION_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+
+class DashBoard;
+
+/*
+ * Fuses the GNSS fixes with the accelerometer and gyroscope into position, speed and heading
+ * at OUTPUT_INTERVAL_MS (fusedLatitude, fusedLongitude, fusedSpeed, fusedHeading).
+ *
+ * An extended Kalman filter with a planar vehicle model: position (east, north in metres around
+ * the first fix), speed, course and the biases of the longitudinal accelerometer and of the yaw
+ * rate gyro. Every step predicts with the mean of the IMU samples since the previous step, every
+ * fix corrects position, speed and, when moving, course. Without IMU samples it still smooths
+ * and upsamples the fixes at constant speed and course. A step costs the same however many
+ * samples arrived, so the filter has a fixed budget.
+ *
+ * The IMU is assumed mounted level with y forward and z up (as used for accely by the dyno).
+ */
+class GpsImuFusion : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int OUTPUT_INTERVAL_MS = 10;
+    // without fixes for this long the output stops
+    static const int FIX_TIMEOUT_MS = 2000;
+
+    explicit GpsImuFusion(QObject *parent = 0);
+    explicit GpsImuFusion(DashBoard *dashboard, QObject *parent = 0);
+
+    // m/s^2 along the driving direction
+    void addAcceleration(qreal forward);
+    // deg/s around the vertical axis, counterclockwise positive
+    void addYawRate(qreal rate);
+    // speed in km/h, heading in degrees from north, accuracy of the position in metres
+    void addFix(double latitude, double longitude, qreal speed, qreal heading, qreal accuracy);
+
+    bool isValid() const { return m_initialized; }
+    // The estimate as published when isValid(): speed in km/h, heading in degrees from north
+    void estimate(double &latitude, double &longitude, qreal &speed, qreal &heading) const;
+    // For offline runs: from now on the filter takes this time, in ns, instead of its clock
+    void setSimulatedTime(qint64 nsecs) { m_simulatedTime = nsecs; }
+
+public slots:
+    // Brings the estimate to the current time and publishes it, every OUTPUT_INTERVAL_MS
+    void step();
+
+private:
+    enum StateIndex {
+        East,
+        North,
+        Speed,
+        Course,
+        AccelerationBias,
+        YawRateBias,
+        StateCount
+    };
+
+    void initialize(double latitude, double longitude, qreal speed, qreal course, qreal accuracy);
+    void advance();
+    void predict(double dt);
+    void update(int index, double measurement, double variance);
+    void publish();
+    qint64 elapsedNs() const;
+
+    DashBoard *m_dashboard;
+    QTimer m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_simulatedTime; // -1 = the clock
+    qint64 m_lastStep;
+    qint64 m_lastFix;
+    bool m_initialized;
+    double m_state[StateCount];
+    double m_covariance[StateCount][StateCount];
+    double m_originLatitude;
+    double m_originLongitude;
+    double m_metresPerDegreeLongitude;
+    double m_accelerationSum;
+    int m_accelerationSamples;
+    double m_yawRateSum;
+    int m_yawRateSamples;
+};
+
+#endif // GPSIMUFUSION_H
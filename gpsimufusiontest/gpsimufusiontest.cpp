@@ -0,0 +1,120 @@
+/**
+ * Test of the GPS/IMU fusion.
+ *
+ * A car drives 60 s around a 100 m radius circle at 20 m/s. Fixes come at 10 Hz with 1.5 m of
+ * position noise, 0.2 m/s of speed noise and 1 degree of heading noise; the filter steps every
+ * OUTPUT_INTERVAL_MS on a simulated clock. The run is done from the GPS alone and with 100 Hz
+ * accelerometer and gyroscope samples that have noise and a bias. After the first 10 s the
+ * position error of every step must be below MAX_POSITION_RMS_M RMS, well below the error of
+ * holding the last fix.
+ *
+ * Usage:
+ *   gpsimufusiontest
+ * Returns 0 when both runs are within the limits.
+ */
+#include "gpsimufusion.h"
+#include "dashboard.h"
+#include <QCoreApplication>
+#include <iostream>
+#include <cmath>
+#include <random>
+
+using namespace std;
+
+const double ORIGIN_LATITUDE = -26.07;
+const double ORIGIN_LONGITUDE = 28.75;
+const double METRES_PER_DEGREE_LATITUDE = 111319.49;
+const double RADIUS = 100;
+const double SPEED = 20;
+const int STEPS = 6000;
+const int SETTLE_STEPS = 1000;
+const double MAX_POSITION_RMS_M = 0.4;
+const double MAX_SPEED_RMS = 0.25;
+
+struct Errors {
+    double position; // RMS, m
+    double lastFix;  // RMS of holding the last fix, m
+    double speed;    // RMS, m/s
+    double heading;  // RMS, degrees
+};
+
+// The fusion runs without a dashboard here; these are only for the linker
+void DashBoard::setfusedLatitude(const double &) {}
+void DashBoard::setfusedLongitude(const double &) {}
+void DashBoard::setfusedSpeed(const qreal &) {}
+void DashBoard::setfusedHeading(const qreal &) {}
+
+Errors run(bool imu)
+{
+    GpsImuFusion fusion;
+    mt19937 random(1);
+    normal_distribution<double> noise(0, 1);
+    const double metresPerDegreeLongitude = METRES_PER_DEGREE_LATITUDE * cos(ORIGIN_LATITUDE * M_PI / 180);
+    const double rate = SPEED / RADIUS;
+    double positionSum = 0;
+    double lastFixSum = 0;
+    double speedSum = 0;
+    double headingSum = 0;
+    double fixEast = 0;
+    double fixNorth = 0;
+    for (int i = 0; i < STEPS; i++) {
+        fusion.setSimulatedTime(qint64(i) * GpsImuFusion::OUTPUT_INTERVAL_MS * 1000000);
+        const double time = i * GpsImuFusion::OUTPUT_INTERVAL_MS / 1000.0;
+        // clockwise, starting north
+        const double course = rate * time;
+        const double east = RADIUS * (1 - cos(course));
+        const double north = RADIUS * sin(course);
+        if (imu) {
+            fusion.addAcceleration(0.3 + 0.2 * noise(random));
+            fusion.addYawRate((-rate + 0.01) * 180 / M_PI + 0.3 * noise(random));
+        }
+        if (i % 10 == 0) {
+            fixEast = east + 1.5 * noise(random);
+            fixNorth = north + 1.5 * noise(random);
+            fusion.addFix(ORIGIN_LATITUDE + fixNorth / METRES_PER_DEGREE_LATITUDE,
+                          ORIGIN_LONGITUDE + fixEast / metresPerDegreeLongitude,
+                          (SPEED + 0.2 * noise(random)) * 3.6,
+                          fmod(course * 180 / M_PI + noise(random) + 360, 360), 1.5);
+        } else {
+            fusion.step();
+        }
+        if (i < SETTLE_STEPS)
+            continue;
+        double latitude;
+        double longitude;
+        qreal speed;
+        qreal heading;
+        fusion.estimate(latitude, longitude, speed, heading);
+        const double eastError = (longitude - ORIGIN_LONGITUDE) * metresPerDegreeLongitude - east;
+        const double northError = (latitude - ORIGIN_LATITUDE) * METRES_PER_DEGREE_LATITUDE - north;
+        positionSum += eastError * eastError + northError * northError;
+        lastFixSum += (fixEast - east) * (fixEast - east) + (fixNorth - north) * (fixNorth - north);
+        speedSum += (speed / 3.6 - SPEED) * (speed / 3.6 - SPEED);
+        double headingError = fmod(heading - course * 180 / M_PI, 360);
+        if (headingError > 180)
+            headingError -= 360;
+        if (headingError < -180)
+            headingError += 360;
+        headingSum += headingError * headingError;
+    }
+    const int count = STEPS - SETTLE_STEPS;
+    const Errors errors = {sqrt(positionSum / count), sqrt(lastFixSum / count), sqrt(speedSum / count),
+                           sqrt(headingSum / count)};
+    return errors;
+}
+
+bool check(const char *name, const Errors &errors)
+{
+    cout << name << ": position " << errors.position << " m RMS (last fix " << errors.lastFix << " m), speed "
+         << errors.speed << " m/s, heading " << errors.heading << " degrees" << endl;
+    return errors.position < MAX_POSITION_RMS_M && errors.speed < MAX_SPEED_RMS;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    bool passed = check("GPS", run(false));
+    passed = check("GPS and IMU", run(true)) && passed;
+    cout << (passed ? "Passed" : "Failed") << endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+# Test of the GPS/IMU fusion; drives a simulated lap with 10 Hz fixes (see gpsimufusiontest.cpp).
+TEMPLATE = app
+TARGET = gpsimufusiontest
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ..
+
+SOURCES += gpsimufusiontest.cpp \
+    ../gpsimufusion.cpp
+
+HEADERS += ../gpsimufusion.h
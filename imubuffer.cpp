@@ -0,0 +1,90 @@
+#include "imubuffer.h"
+#include <QtMath>
+
+namespace {
+// gaps longer than this restart the low pass from the next sample
+const qreal MAX_SAMPLE_GAP_S = 0.5;
+}
+
+ImuFilter::ImuFilter(qreal referenceZ)
+    : m_referenceZ(referenceZ)
+    , m_timeConstant(0)
+    , m_calibrationLeft(0)
+    , m_calibrationCount(0)
+    , m_lastTimestamp(0)
+    , m_hasState(false)
+{
+    for (int axis = 0; axis < 3; axis++)
+        m_bias[axis] = m_sum[axis] = m_state[axis] = 0;
+}
+
+void ImuFilter::setCutoff(qreal cutoffHz)
+{
+    m_timeConstant = cutoffHz > 0 ? 1 / (2 * M_PI * cutoffHz) : 0;
+}
+
+void ImuFilter::calibrate(int samples)
+{
+    for (int axis = 0; axis < 3; axis++)
+        m_sum[axis] = 0;
+    m_calibrationCount = m_calibrationLeft = qMax(1, samples);
+}
+
+void ImuFilter::reset()
+{
+    m_hasState = false;
+}
+
+void ImuFilter::apply(quint64 timestampUs, ImuSample &sample)
+{
+    qreal *values[3] = { &sample.x, &sample.y, &sample.z };
+    if (m_calibrationLeft > 0) {
+        for (int axis = 0; axis < 3; axis++)
+            m_sum[axis] += *values[axis];
+        if (--m_calibrationLeft == 0) {
+            m_bias[0] = m_sum[0] / m_calibrationCount;
+            m_bias[1] = m_sum[1] / m_calibrationCount;
+            m_bias[2] = m_sum[2] / m_calibrationCount - m_referenceZ;
+            m_hasState = false;
+        }
+    }
+
+    qreal alpha = 1;
+    if (m_hasState && m_timeConstant > 0) {
+        const qreal dt = (timestampUs - m_lastTimestamp) / 1000000.0;
+        if (timestampUs > m_lastTimestamp && dt < MAX_SAMPLE_GAP_S)
+            alpha = dt / (m_timeConstant + dt);
+    }
+    m_lastTimestamp = timestampUs;
+    m_hasState = true;
+    for (int axis = 0; axis < 3; axis++) {
+        m_state[axis] += alpha * (*values[axis] - m_bias[axis] - m_state[axis]);
+        *values[axis] = m_state[axis];
+    }
+}
+
+ImuBuffer::ImuBuffer(int capacity)
+    : m_samples(qMax(1, capacity))
+    , m_head(0)
+    , m_count(0)
+    , m_overruns(0)
+{
+}
+
+void ImuBuffer::append(const ImuSample &sample)
+{
+    if (m_count == m_samples.size()) {
+        m_samples[m_head] = sample;
+        m_head = (m_head + 1) % m_samples.size();
+        m_overruns++;
+        return;
+    }
+    m_samples[(m_head + m_count) % m_samples.size()] = sample;
+    m_count++;
+}
+
+void ImuBuffer::clear()
+{
+    m_head = 0;
+    m_count = 0;
+}
@@ -0,0 +1,66 @@
+#ifndef IMUBUFFER_H
+#define IMUBUFFER_H
+
+#include <QVector>
+
+struct ImuSample
+{
+    qint64 timeMs; // received, of SampleClock
+    qreal x;
+    qreal y;
+    qreal z;
+};
+
+/*
+ * Conditions the readings of a three axis sensor: removes the bias found by calibrate and
+ * smooths each axis with a first order low pass. The filter uses the time stamps of the
+ * readings, so the cut off stays the same when the sensor does not keep its data rate.
+ */
+class ImuFilter
+{
+public:
+    // referenceZ is the reading of z at rest, ex. the gravity for an accelerometer mounted level
+    explicit ImuFilter(qreal referenceZ = 0);
+
+    void setCutoff(qreal cutoffHz);
+    // The next samples are averaged into the bias; the sensor has to be at rest meanwhile
+    void calibrate(int samples);
+    bool isCalibrating() const { return m_calibrationLeft > 0; }
+    void reset();
+    void apply(quint64 timestampUs, ImuSample &sample);
+
+private:
+    qreal m_referenceZ;
+    qreal m_timeConstant; // s, 0 = not filtered
+    qreal m_bias[3];
+    qreal m_sum[3];
+    int m_calibrationLeft;
+    int m_calibrationCount;
+    qreal m_state[3];
+    quint64 m_lastTimestamp;
+    bool m_hasState;
+};
+
+/*
+ * Samples collected between two batches. Fixed capacity ring; when the batches are late the
+ * oldest samples are overwritten and counted in overruns.
+ */
+class ImuBuffer
+{
+public:
+    explicit ImuBuffer(int capacity);
+
+    void append(const ImuSample &sample);
+    void clear();
+    int size() const { return m_count; }
+    const ImuSample &at(int idx) const { return m_samples[(m_head + idx) % m_samples.size()]; }
+    int overruns() const { return m_overruns; }
+
+private:
+    QVector<ImuSample> m_samples;
+    int m_head;
+    int m_count;
+    int m_overruns;
+};
+
+#endif // IMUBUFFER_H
@@ -0,0 +1,112 @@
+#include "laptrace.h"
+#include <QtMath>
+
+static const double METRES_PER_DEGREE_LATITUDE = 111319.49;
+
+const qreal LapTrace::MAX_OFFSET_M = 30;
+
+LapTrace::LapTrace()
+    : m_match(0)
+    , m_originLatitude(0)
+    , m_originLongitude(0)
+    , m_metresPerDegreeLongitude(METRES_PER_DEGREE_LATITUDE)
+{
+}
+
+void LapTrace::setOrigin(double latitude, double longitude)
+{
+    m_originLatitude = latitude;
+    m_originLongitude = longitude;
+    m_metresPerDegreeLongitude = METRES_PER_DEGREE_LATITUDE * qCos(qDegreesToRadians(latitude));
+    clear();
+}
+
+void LapTrace::startLap()
+{
+    m_lap.clear();
+    m_match = 0;
+}
+
+void LapTrace::addFix(double latitude, double longitude, int lapTime)
+{
+    Point point = project(latitude, longitude);
+    point.time = lapTime;
+    point.distance = 0;
+    if (!m_lap.isEmpty())
+    {
+        const Point &previous = m_lap.last();
+        point.distance = previous.distance + qSqrt((point.x - previous.x) * (point.x - previous.x)
+                                                   + (point.y - previous.y) * (point.y - previous.y));
+    }
+    m_lap.append(point);
+}
+
+void LapTrace::keepAsReference()
+{
+    m_reference = m_lap;
+}
+
+void LapTrace::clear()
+{
+    m_lap.clear();
+    m_reference.clear();
+    m_match = 0;
+}
+
+bool LapTrace::delta(double latitude, double longitude, int lapTime, qreal &seconds)
+{
+    if (!hasReference())
+        return false;
+    const Point point = project(latitude, longitude);
+    const int segments = m_reference.size() - 1;
+    int segment;
+    double fraction;
+    // one segment back, in case the car is a little slower than the last match
+    double offset = nearest(point, qMax(0, m_match - 1), qMin(segments, m_match + SEARCH_WINDOW), segment, fraction);
+    if (offset > MAX_OFFSET_M * MAX_OFFSET_M)
+    {
+        offset = nearest(point, 0, segments, segment, fraction);
+        if (offset > MAX_OFFSET_M * MAX_OFFSET_M)
+            return false;
+    }
+    m_match = segment;
+    const Point &from = m_reference.at(segment);
+    const Point &to = m_reference.at(segment + 1);
+    const double referenceTime = from.time + fraction * (to.time - from.time);
+    seconds = (lapTime - referenceTime) / 1000.0;
+    return true;
+}
+
+LapTrace::Point LapTrace::project(double latitude, double longitude) const
+{
+    Point point;
+    point.x = (longitude - m_originLongitude) * m_metresPerDegreeLongitude;
+    point.y = (latitude - m_originLatitude) * METRES_PER_DEGREE_LATITUDE;
+    return point;
+}
+
+double LapTrace::nearest(const Point &point, int first, int last, int &segment, double &fraction) const
+{
+    double best = -1;
+    for (int i = first; i < last; i++)
+    {
+        const Point &from = m_reference.at(i);
+        const Point &to = m_reference.at(i + 1);
+        const double segmentX = to.x - from.x;
+        const double segmentY = to.y - from.y;
+        const double length = segmentX * segmentX + segmentY * segmentY;
+        double t = 0;
+        if (length > 0)
+            t = qBound(0.0, ((point.x - from.x) * segmentX + (point.y - from.y) * segmentY) / length, 1.0);
+        const double dx = from.x + t * segmentX - point.x;
+        const double dy = from.y + t * segmentY - point.y;
+        const double distance = dx * dx + dy * dy;
+        if (best < 0 || distance < best)
+        {
+            best = distance;
+            segment = i;
+            fraction = t;
+        }
+    }
+    return best < 0 ? MAX_OFFSET_M * MAX_OFFSET_M * 4 : best;
+}
@@ -0,0 +1,55 @@
+#ifndef LAPTRACE_H
+#define LAPTRACE_H
+
+#include <QVector>
+
+/*
+ * Trace of the fixes of a lap, indexed by the distance driven, for the predictive lap delta.
+ *
+ * The current lap is recorded fix by fix and becomes the reference when it is the best lap. For
+ * every fix the nearest point on the reference polyline is searched in a window of segments
+ * from the last match on, so a fix costs O(1); only when the car is not found there (first fix,
+ * off track, ...) the whole reference is searched. The delta is the current lap time minus the
+ * reference time interpolated at that point.
+ */
+class LapTrace
+{
+public:
+    static const int SEARCH_WINDOW = 25;
+    static const qreal MAX_OFFSET_M;
+
+    LapTrace();
+
+    // Positions are kept in metres around the origin, ex. the finish line
+    void setOrigin(double latitude, double longitude);
+    void startLap();
+    void addFix(double latitude, double longitude, int lapTime);
+    void keepAsReference();
+    void clear();
+
+    bool hasReference() const { return m_reference.size() > 1; }
+    // Seconds the current lap is behind (positive) or ahead of the reference
+    bool delta(double latitude, double longitude, int lapTime, qreal &seconds);
+
+private:
+    struct Point
+    {
+        double x;
+        double y;
+        double distance; // from the start of the lap, m
+        int time;        // lap time, ms
+    };
+
+    Point project(double latitude, double longitude) const;
+    // Nearest point on the segments first..last-1 of the reference; returns the squared distance
+    double nearest(const Point &point, int first, int last, int &segment, double &fraction) const;
+
+    QVector<Point> m_lap;
+    QVector<Point> m_reference;
+    int m_match;
+    double m_originLatitude;
+    double m_originLongitude;
+    double m_metresPerDegreeLongitude;
+};
+
+#endif // LAPTRACE_H
@@ -0,0 +1,104 @@
+/**
+ * Test of the predictive lap delta.
+ *
+ * Two laps of a 300 m radius circle are driven with 10 Hz fixes. The first lap is at a constant
+ * speed and becomes the reference. The second lap is driven 2 m further out, 10 % slower on the
+ * first half and 10 % faster on the second half, so the delta grows to its largest at half
+ * distance and then shrinks; at every fix it is compared with the time difference of the two
+ * laps at that point of the circle. A fix far off the track has no delta.
+ *
+ * Usage:
+ *   laptracetest
+ * Returns 0 when every delta is within TOLERANCE_S.
+ */
+#include "laptrace.h"
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+const double ORIGIN_LATITUDE = -26.0751;
+const double ORIGIN_LONGITUDE = 28.7551;
+const double METRES_PER_DEGREE_LATITUDE = 111319.49;
+const double RADIUS = 300;
+const double LAP_TIME_MS = 60000;
+const int FIX_INTERVAL_MS = 100;
+const double TOLERANCE_S = 0.005;
+
+// Position at an angle from the start, in radians, on a circle around the centre of the track,
+// which is RADIUS east of the origin
+void position(double angle, double radius, double &latitude, double &longitude)
+{
+    const double metresPerDegreeLongitude = METRES_PER_DEGREE_LATITUDE * cos(ORIGIN_LATITUDE * M_PI / 180);
+    latitude = ORIGIN_LATITUDE + radius * sin(angle) / METRES_PER_DEGREE_LATITUDE;
+    longitude = ORIGIN_LONGITUDE + (RADIUS - radius * cos(angle)) / metresPerDegreeLongitude;
+}
+
+// Lap time of the second lap at an angle
+double secondLapTime(double angle)
+{
+    const double rate = 2 * M_PI / LAP_TIME_MS;
+    if (angle < M_PI)
+        return angle / (0.9 * rate);
+    return M_PI / (0.9 * rate) + (angle - M_PI) / (1.1 * rate);
+}
+
+int main()
+{
+    LapTrace trace;
+    trace.setOrigin(ORIGIN_LATITUDE, ORIGIN_LONGITUDE);
+    trace.startLap();
+    for (int time = 0; time <= LAP_TIME_MS; time += FIX_INTERVAL_MS) {
+        double latitude;
+        double longitude;
+        position(2 * M_PI * time / LAP_TIME_MS, RADIUS, latitude, longitude);
+        trace.addFix(latitude, longitude, time);
+    }
+    trace.keepAsReference();
+
+    bool passed = true;
+    int deltas = 0;
+    double largest = 0;
+    trace.startLap();
+    const int secondLapEnd = int(secondLapTime(2 * M_PI));
+    for (int time = 0; time <= secondLapEnd; time += FIX_INTERVAL_MS) {
+        // the angle at this time, found by bisection as the lap time only grows with it
+        double low = 0;
+        double high = 2 * M_PI;
+        for (int i = 0; i < 60; i++) {
+            const double middle = (low + high) / 2;
+            (secondLapTime(middle) < time ? low : high) = middle;
+        }
+        const double angle = (low + high) / 2;
+        double latitude;
+        double longitude;
+        position(angle, RADIUS + 2, latitude, longitude);
+        trace.addFix(latitude, longitude, time);
+        qreal seconds;
+        if (!trace.delta(latitude, longitude, time, seconds)) {
+            cerr << "No delta at " << time << " ms" << endl;
+            passed = false;
+            continue;
+        }
+        deltas++;
+        const double expected = (time - angle * LAP_TIME_MS / (2 * M_PI)) / 1000;
+        largest = max(largest, seconds);
+        if (fabs(seconds - expected) > TOLERANCE_S) {
+            cerr << "Delta at " << time << " ms: " << seconds << " s, expected " << expected << " s" << endl;
+            passed = false;
+        }
+    }
+
+    qreal seconds;
+    double latitude;
+    double longitude;
+    position(M_PI / 2, RADIUS + 100, latitude, longitude);
+    if (trace.delta(latitude, longitude, 20000, seconds)) {
+        cerr << "Delta 100 m off the track" << endl;
+        passed = false;
+    }
+
+    cout << deltas << " deltas, largest " << largest << " s" << endl;
+    cout << (passed ? "Passed" : "Failed") << endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,14 @@
+# Test of the predictive lap delta; drives two laps on a circle (see laptracetest.cpp).
+TEMPLATE = app
+TARGET = laptracetest
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ..
+
+SOURCES += laptracetest.cpp \
+    ../laptrace.cpp
+
+HEADERS += ../laptrace.h
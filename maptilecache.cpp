@@ -0,0 +1,412 @@
+#include "maptilecache.h"
+#include "trackdatabase.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QPoint>
+#include <QPointF>
+#include <QVariantMap>
+#include <QRunnable>
+#include <QtEndian>
+#include <QtMath>
+#include <QDebug>
+#include <cstring>
+
+const char *MapTileCache::DEFAULT_DIRECTORY = "/home/pi/maptiles/";
+const char *MapTileCache::ARCHIVE_FILE = "tiles.pack";
+
+namespace {
+// Archive: magic, version, count, then count entries (zoom, x, y, size, offset) and the tile data;
+// little endian
+const char ARCHIVE_MAGIC[4] = { 'P', 'T', 'M', 'T' };
+const quint32 ARCHIVE_VERSION = 1;
+const int ARCHIVE_HEADER_SIZE = 12;
+const int ARCHIVE_ENTRY_SIZE = 24;
+// steps along the track outline, in tiles
+const double OUTLINE_STEP = 0.25;
+
+class MapTilePrefetch : public QRunnable
+{
+public:
+    MapTilePrefetch(MapTileCache *cache, int generation, int zoom, const QVector<QPoint> &tiles)
+        : m_cache(cache)
+        , m_generation(generation)
+        , m_zoom(zoom)
+        , m_tiles(tiles)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        foreach (const QPoint &tile, m_tiles) {
+            if (m_cache->prefetchCancelled(m_generation))
+                return;
+            m_cache->tile(m_zoom, tile.x(), tile.y());
+        }
+    }
+
+private:
+    MapTileCache *m_cache;
+    int m_generation;
+    int m_zoom;
+    QVector<QPoint> m_tiles;
+};
+
+class MapTileLoad : public QRunnable
+{
+public:
+    explicit MapTileLoad(MapTileCache *cache)
+        : m_cache(cache)
+    {
+    }
+
+    void run() Q_DECL_OVERRIDE
+    {
+        m_cache->loadTiles();
+    }
+
+private:
+    MapTileCache *m_cache;
+};
+
+QPointF midpoint(const TimingLine &line)
+{
+    return QPointF((line.longitude1 + line.longitude2) / 2, (line.latitude1 + line.latitude2) / 2);
+}
+}
+
+MapTileCache::MapTileCache(QObject *parent)
+    : QObject(parent)
+    , m_tracks(Q_NULLPTR)
+    , m_archiveData(Q_NULLPTR)
+    , m_loadStarted(false)
+{
+}
+
+MapTileCache::MapTileCache(TrackDatabase *tracks, const QString &directory, QObject *parent)
+    : QObject(parent)
+    , m_tracks(tracks)
+    , m_directory(directory)
+    , m_archiveData(Q_NULLPTR)
+    , m_loadStarted(false)
+{
+    m_images.setMaxCost(DEFAULT_MEMORY_BUDGET_MB * 1024);
+    m_prefetchPool.setMaxThreadCount(1);
+}
+
+MapTileCache::~MapTileCache()
+{
+    m_stopping.store(1);
+    m_prefetchGeneration.fetchAndAddOrdered(1);
+    m_prefetchPool.waitForDone();
+}
+
+quint64 MapTileCache::key(int zoom, int x, int y)
+{
+    return (quint64(zoom) << 48) | (quint64(quint32(x)) << 24) | quint32(y);
+}
+
+double MapTileCache::tileX(double longitude, int zoom)
+{
+    return (longitude + 180) / 360 * (1 << zoom);
+}
+
+double MapTileCache::tileY(double latitude, int zoom)
+{
+    const double radians = qDegreesToRadians(latitude);
+    return (1 - std::log(std::tan(radians) + 1 / std::cos(radians)) / M_PI) / 2 * (1 << zoom);
+}
+
+double MapTileCache::tileLongitude(double x, int zoom)
+{
+    return x / (1 << zoom) * 360 - 180;
+}
+
+double MapTileCache::tileLatitude(double y, int zoom)
+{
+    return qRadiansToDegrees(std::atan(std::sinh(M_PI * (1 - 2 * y / (1 << zoom)))));
+}
+
+bool MapTileCache::loadArchive()
+{
+    m_archive.setFileName(QDir(m_directory).filePath(ARCHIVE_FILE));
+    if (!m_archive.open(QIODevice::ReadOnly))
+        return false;
+    const qint64 size = m_archive.size();
+    const uchar *data = size >= ARCHIVE_HEADER_SIZE ? m_archive.map(0, size) : Q_NULLPTR;
+    const quint32 count = data ? qFromLittleEndian<quint32>(data + 8) : 0;
+    bool valid = data && memcmp(data, ARCHIVE_MAGIC, 4) == 0
+            && qFromLittleEndian<quint32>(data + 4) == ARCHIVE_VERSION
+            && ARCHIVE_HEADER_SIZE + qint64(count) * ARCHIVE_ENTRY_SIZE <= size;
+    QHash<quint64, Entry> index;
+    for (quint32 i = 0; valid && i < count; i++) {
+        const uchar *entry = data + ARCHIVE_HEADER_SIZE + i * ARCHIVE_ENTRY_SIZE;
+        Entry tile;
+        tile.size = int(qFromLittleEndian<quint32>(entry + 12));
+        tile.offset = qint64(qFromLittleEndian<quint64>(entry + 16));
+        valid = tile.size >= 0 && tile.offset >= 0 && tile.offset + tile.size <= size;
+        index.insert(key(int(qFromLittleEndian<quint32>(entry)), int(qFromLittleEndian<quint32>(entry + 4)),
+                         int(qFromLittleEndian<quint32>(entry + 8))), tile);
+    }
+    if (!valid) {
+        qDebug() << "Map tile archive" << m_archive.fileName() << "is damaged";
+        m_archive.close();
+        return false;
+    }
+    QMutexLocker locker(&m_mutex);
+    m_archiveData = data;
+    m_index = index;
+    return true;
+}
+
+// osm_100-l-<map>-<zoom>-<x>-<y>.png; of a tile in several map types the lowest is used (sorted by name)
+QHash<quint64, MapTileCache::Entry> MapTileCache::scanDirectory()
+{
+    QHash<quint64, Entry> index;
+    const QFileInfoList files = QDir(m_directory).entryInfoList(QStringList() << "osm_100-*", QDir::Files);
+    foreach (const QFileInfo &file, files) {
+        const QStringList fields = file.completeBaseName().split('-');
+        bool zoomOk, xOk, yOk;
+        const int zoom = fields.value(3).toInt(&zoomOk);
+        const int x = fields.value(4).toInt(&xOk);
+        const int y = fields.value(5).toInt(&yOk);
+        if (fields.size() != 6 || !zoomOk || !xOk || !yOk)
+            continue;
+        const quint64 tileKey = key(zoom, x, y);
+        if (index.contains(tileKey))
+            continue;
+        Entry tile;
+        tile.fileName = file.filePath();
+        tile.offset = 0;
+        tile.size = int(file.size());
+        index.insert(tileKey, tile);
+    }
+    QMutexLocker locker(&m_mutex);
+    m_index = index;
+    return index;
+}
+
+void MapTileCache::load()
+{
+    if (m_loadStarted)
+        return;
+    m_loadStarted = true;
+    // queued before any prefetch, which finds the tiles indexed then
+    m_prefetchPool.start(new MapTileLoad(this));
+}
+
+void MapTileCache::loadTiles()
+{
+    if (loadArchive()) {
+        emit tilesLoaded();
+        return;
+    }
+    // the tiles are read from their files until the archive is mapped
+    const QHash<quint64, Entry> index = scanDirectory();
+    emit tilesLoaded();
+    if (!index.isEmpty() && writeArchive(index))
+        loadArchive();
+}
+
+// The tiles are copied one at a time after the room for the entries; the header and the entries
+// are written last, once the sizes of the tiles are known
+bool MapTileCache::writeArchive(const QHash<quint64, Entry> &index)
+{
+    QSaveFile file(QDir(m_directory).filePath(ARCHIVE_FILE));
+    const qint64 dataOffset = ARCHIVE_HEADER_SIZE + qint64(index.size()) * ARCHIVE_ENTRY_SIZE;
+    if (!file.open(QIODevice::WriteOnly) || !file.seek(dataOffset)) {
+        qDebug() << "Map tiles not packed:" << file.errorString();
+        return false;
+    }
+    QByteArray entries;
+    entries.reserve(index.size() * ARCHIVE_ENTRY_SIZE);
+    quint32 count = 0;
+    qint64 offset = dataOffset;
+    for (QHash<quint64, Entry>::const_iterator tile = index.constBegin(); tile != index.constEnd(); ++tile) {
+        // not committed, so the partial archive is discarded
+        if (m_stopping.load())
+            return false;
+        const QByteArray data = encoded(tile.value(), Q_NULLPTR);
+        if (data.isEmpty())
+            continue;
+        if (file.write(data) != data.size()) {
+            qDebug() << "Map tiles not packed:" << file.errorString();
+            return false;
+        }
+        uchar entry[ARCHIVE_ENTRY_SIZE];
+        qToLittleEndian<quint32>(quint32(tile.key() >> 48), entry);
+        qToLittleEndian<quint32>(quint32((tile.key() >> 24) & 0xFFFFFF), entry + 4);
+        qToLittleEndian<quint32>(quint32(tile.key() & 0xFFFFFF), entry + 8);
+        qToLittleEndian<quint32>(quint32(data.size()), entry + 12);
+        qToLittleEndian<quint64>(quint64(offset), entry + 16);
+        entries.append(reinterpret_cast<const char *>(entry), ARCHIVE_ENTRY_SIZE);
+        offset += data.size();
+        count++;
+    }
+    uchar header[ARCHIVE_HEADER_SIZE];
+    memcpy(header, ARCHIVE_MAGIC, 4);
+    qToLittleEndian<quint32>(ARCHIVE_VERSION, header + 4);
+    qToLittleEndian<quint32>(count, header + 8);
+    if (!file.seek(0) || file.write(reinterpret_cast<const char *>(header), ARCHIVE_HEADER_SIZE) != ARCHIVE_HEADER_SIZE
+            || file.write(entries) != entries.size() || !file.commit()) {
+        qDebug() << "Map tiles not packed:" << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void MapTileCache::setMemoryBudget(const int &megabytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_images.setMaxCost(qMax(1, megabytes) * 1024);
+}
+
+QVariantList MapTileCache::tilesAround(const double &latitude, const double &longitude, const int &zoom, const int &radius) const
+{
+    QVariantList tiles;
+    const double centreX = tileX(longitude, zoom);
+    const double centreY = tileY(latitude, zoom);
+    const double tileRadius = double(radius) / TILE_SIZE;
+    const int last = (1 << zoom) - 1;
+    for (int y = qMax(0, int(std::floor(centreY - tileRadius))); y <= qMin(last, int(std::floor(centreY + tileRadius))); y++) {
+        for (int x = qMax(0, int(std::floor(centreX - tileRadius))); x <= qMin(last, int(std::floor(centreX + tileRadius))); x++) {
+            QVariantMap tile;
+            tile.insert(QStringLiteral("zoom"), zoom);
+            tile.insert(QStringLiteral("x"), x);
+            tile.insert(QStringLiteral("y"), y);
+            tile.insert(QStringLiteral("latitude"), tileLatitude(y, zoom));
+            tile.insert(QStringLiteral("longitude"), tileLongitude(x, zoom));
+            tiles.append(tile);
+        }
+    }
+    return tiles;
+}
+
+QString MapTileCache::tileKey(const double &latitude, const double &longitude, const int &zoom) const
+{
+    return QString("%1/%2/%3").arg(zoom).arg(int(std::floor(tileX(longitude, zoom)))).arg(int(std::floor(tileY(latitude, zoom))));
+}
+
+void MapTileCache::prefetchTrack(const QString &name, const int &zoom)
+{
+    const int generation = m_prefetchGeneration.fetchAndAddOrdered(1) + 1;
+    const int index = m_tracks ? m_tracks->indexOf(name) : -1;
+    if (index < 0 || zoom < 0 || zoom > 24)
+        return;
+    const Track &track = m_tracks->track(index);
+    // the map centre, then the timing lines in the order they are driven
+    QVector<QPointF> outline;
+    outline.append(QPointF(track.longitude, track.latitude));
+    if (track.hasFinishLine) {
+        outline.append(midpoint(track.finishLine));
+        foreach (const TimingLine &line, track.sectorLines)
+            outline.append(midpoint(line));
+        outline.append(midpoint(track.finishLine));
+    }
+
+    // half of the budget, so the prefetch does not push out the tiles in view
+    int budget;
+    {
+        QMutexLocker locker(&m_mutex);
+        budget = m_images.maxCost() / (TILE_SIZE * TILE_SIZE * 4 / 1024) / 2;
+    }
+    QVector<QPoint> tiles;
+    QSet<quint64> queued;
+    const int last = (1 << zoom) - 1;
+    for (int i = 0; i < outline.size(); i++) {
+        const QPointF from(tileX(outline.at(i).x(), zoom), tileY(outline.at(i).y(), zoom));
+        // the centre is on its own, the lines are joined
+        const QPointF to = i > 1 ? QPointF(tileX(outline.at(i - 1).x(), zoom), tileY(outline.at(i - 1).y(), zoom)) : from;
+        const int steps = qMax(1, int(std::ceil(qMax(qAbs(to.x() - from.x()), qAbs(to.y() - from.y())) / OUTLINE_STEP)));
+        for (int step = 0; step <= steps; step++) {
+            const QPointF point = from + (to - from) * step / steps;
+            for (int dy = -PREFETCH_RADIUS_TILES; dy <= PREFETCH_RADIUS_TILES; dy++) {
+                for (int dx = -PREFETCH_RADIUS_TILES; dx <= PREFETCH_RADIUS_TILES; dx++) {
+                    const int x = int(std::floor(point.x())) + dx;
+                    const int y = int(std::floor(point.y())) + dy;
+                    if (x < 0 || y < 0 || x > last || y > last || queued.contains(key(zoom, x, y)))
+                        continue;
+                    queued.insert(key(zoom, x, y));
+                    tiles.append(QPoint(x, y));
+                }
+            }
+        }
+    }
+    if (tiles.size() > budget)
+        tiles.resize(budget);
+    m_prefetchPool.start(new MapTilePrefetch(this, generation, zoom, tiles));
+}
+
+QByteArray MapTileCache::encoded(const Entry &entry, const uchar *archiveData)
+{
+    if (entry.fileName.isEmpty())
+        return QByteArray::fromRawData(reinterpret_cast<const char *>(archiveData) + entry.offset, entry.size);
+    QFile file(entry.fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return QByteArray();
+    return file.readAll();
+}
+
+QImage MapTileCache::decode(quint64 tileKey)
+{
+    Entry entry;
+    const uchar *archiveData;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (QImage *image = m_images.object(tileKey))
+            return *image;
+        QHash<quint64, Entry>::const_iterator tile = m_index.constFind(tileKey);
+        if (tile == m_index.constEnd())
+            return QImage();
+        entry = tile.value();
+        archiveData = m_archiveData;
+    }
+    const QImage image = QImage::fromData(encoded(entry, archiveData));
+    if (!image.isNull()) {
+        QMutexLocker locker(&m_mutex);
+        m_images.insert(tileKey, new QImage(image), qMax(1, image.byteCount() / 1024));
+    }
+    return image;
+}
+
+QImage MapTileCache::tile(int zoom, int x, int y)
+{
+    const quint64 tileKey = key(zoom, x, y);
+    QImage image = decode(tileKey);
+    for (int level = 1; image.isNull() && level <= MAX_OVERZOOM && zoom - level >= 0; level++) {
+        const QImage parent = decode(key(zoom - level, x >> level, y >> level));
+        if (parent.isNull())
+            continue;
+        const int size = parent.width() >> level;
+        const int mask = (1 << level) - 1;
+        image = parent.copy((x & mask) * size, (y & mask) * size, size, size)
+                .scaled(TILE_SIZE, TILE_SIZE, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+        QMutexLocker locker(&m_mutex);
+        m_images.insert(tileKey, new QImage(image), qMax(1, image.byteCount() / 1024));
+    }
+    return image;
+}
+
+MapTileImageProvider::MapTileImageProvider(MapTileCache *cache)
+    : QQuickImageProvider(QQuickImageProvider::Image, QQuickImageProvider::ForceAsynchronousImageLoading)
+    , m_cache(cache)
+    , m_blank(MapTileCache::TILE_SIZE, MapTileCache::TILE_SIZE, QImage::Format_ARGB32_Premultiplied)
+{
+    m_blank.fill(Qt::transparent);
+}
+
+QImage MapTileImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    const QStringList fields = id.split('/');
+    QImage image;
+    if (fields.size() == 3)
+        image = m_cache->tile(fields.at(0).toInt(), fields.at(1).toInt(), fields.at(2).toInt());
+    if (image.isNull())
+        image = m_blank;
+    if (!image.isNull() && requestedSize.isValid() && requestedSize != image.size())
+        image = image.scaled(requestedSize, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+    if (size)
+        *size = image.size();
+    return image;
+}
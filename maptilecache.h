@@ -0,0 +1,113 @@
+#ifndef MAPTILECACHE_H
+#define MAPTILECACHE_H
+
+#include <QObject>
+#include <QHash>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
+#include <QFile>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QVariantList>
+#include <QQuickImageProvider>
+
+class TrackDatabase;
+
+/*
+ * The offline map tiles (osm_100-l-<map>-<zoom>-<x>-<y>.png/jpg as used by the osm plugin),
+ * indexed by zoom, x and y and drawn by the laptimer as image://maptiles/<zoom>/<x>/<y> when the
+ * setting laptimer/tileCache is on; otherwise the osm plugin reads the directory itself.
+ *
+ * load() maps ARCHIVE_FILE, so a start only reads its index. Without an archive the directory is
+ * scanned, the tiles are served from their files and packed into the archive meanwhile. Both run
+ * in the background. Delete the archive after adding tiles to the directory. Decoded tiles are
+ * kept in a least recently used cache within the memory budget; the tiles along a track are
+ * decoded in the background when it is selected, so the view does not decode while it moves. A
+ * missing tile is cut out of a tile of a lower zoom (up to MAX_OVERZOOM levels).
+ *
+ * Thread safe: tiles are decoded by the image provider threads and the prefetch.
+ */
+class MapTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    static const int TILE_SIZE = 256;
+    static const int MAX_OVERZOOM = 3;
+    static const int DEFAULT_MEMORY_BUDGET_MB = 32;
+    // tiles prefetched around each point of the track outline
+    static const int PREFETCH_RADIUS_TILES = 1;
+    static const char *DEFAULT_DIRECTORY;
+    static const char *ARCHIVE_FILE;
+
+    explicit MapTileCache(QObject *parent = 0);
+    explicit MapTileCache(TrackDatabase *tracks, const QString &directory = QString(DEFAULT_DIRECTORY), QObject *parent = 0);
+    ~MapTileCache();
+
+    // Maps the archive, or indexes the directory and packs it into the archive; in the background
+    Q_INVOKABLE void load();
+    Q_INVOKABLE void setMemoryBudget(const int &megabytes);
+    // Tiles of the zoom that cover radius pixels around the position, each with the coordinate
+    // of its top left corner: [{zoom, x, y, latitude, longitude}, ...]
+    Q_INVOKABLE QVariantList tilesAround(const double &latitude, const double &longitude, const int &zoom, const int &radius) const;
+    // Changes only when the position moves to another tile; the tiles around it are updated then
+    Q_INVOKABLE QString tileKey(const double &latitude, const double &longitude, const int &zoom) const;
+    // Decodes the tiles along the finish and sector lines of a track in the background
+    Q_INVOKABLE void prefetchTrack(const QString &name, const int &zoom);
+
+    QImage tile(int zoom, int x, int y);
+    bool prefetchCancelled(int generation) const { return m_prefetchGeneration.load() != generation; }
+    // Run by load() in the prefetch thread
+    void loadTiles();
+
+signals:
+    // The tiles are indexed; emitted from the prefetch thread
+    void tilesLoaded();
+
+private:
+    struct Entry
+    {
+        QString fileName; // if not in the archive
+        qint64 offset;
+        int size;
+    };
+
+    static quint64 key(int zoom, int x, int y);
+    static double tileX(double longitude, int zoom);
+    static double tileY(double latitude, int zoom);
+    static double tileLongitude(double x, int zoom);
+    static double tileLatitude(double y, int zoom);
+    bool loadArchive();
+    QHash<quint64, Entry> scanDirectory();
+    bool writeArchive(const QHash<quint64, Entry> &index);
+    static QByteArray encoded(const Entry &entry, const uchar *archiveData);
+    QImage decode(quint64 tileKey);
+
+    TrackDatabase *m_tracks;
+    QString m_directory;
+    QFile m_archive;
+    const uchar *m_archiveData;
+    QHash<quint64, Entry> m_index;
+    QCache<quint64, QImage> m_images; // cost in KB
+    mutable QMutex m_mutex;
+    QThreadPool m_prefetchPool;
+    QAtomicInt m_prefetchGeneration;
+    QAtomicInt m_stopping;
+    bool m_loadStarted;
+};
+
+// image://maptiles/<zoom>/<x>/<y>, loaded outside the GUI thread
+class MapTileImageProvider : public QQuickImageProvider
+{
+public:
+    explicit MapTileImageProvider(MapTileCache *cache);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) Q_DECL_OVERRIDE;
+
+private:
+    MapTileCache *m_cache;
+    QImage m_blank; // for the tiles that are missing, which QML would warn about each time
+};
+
+#endif // MAPTILECACHE_H
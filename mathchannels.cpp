@@ -0,0 +1,147 @@
+#include "mathchannels.h"
+#include "dashboard.h"
+#include "derivedchannels.h"
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+const char *MathChannels::DEFAULT_FILE = "/home/pi/MathChannels.txt";
+
+MathChannels::MathChannels(QObject *parent)
+    : MathChannels(Q_NULLPTR, Q_NULLPTR, parent)
+{
+}
+
+MathChannels::MathChannels(DashBoard *dashboard, DerivedChannels *derivedChannels, QObject *parent)
+    : QObject(parent)
+    , m_dashboard(dashboard)
+    , m_derivedChannels(derivedChannels)
+{
+}
+
+MathChannels::~MathChannels()
+{
+    qDeleteAll(m_channels);
+}
+
+bool MathChannels::load(const QString &fileName)
+{
+    clear();
+    QStringList errors;
+    QFile file(fileName);
+    if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream stream(&file);
+        int lineNumber = 0;
+        while (!stream.atEnd()) {
+            const QString line = stream.readLine().trimmed();
+            lineNumber++;
+            if (line.isEmpty() || line.startsWith('#'))
+                continue;
+            // the expression may contain commas itself, ex. min(a, b)
+            const int nameStart = line.indexOf(',') + 1;
+            const int expressionStart = nameStart > 0 ? line.indexOf(',', nameStart) + 1 : 0;
+            QString error;
+            if (expressionStart <= 0)
+                error = "expected output,name,expression";
+            else
+                addChannel(line.left(nameStart - 1).trimmed(), line.mid(nameStart, expressionStart - nameStart - 1).trimmed(),
+                           line.mid(expressionStart), &error);
+            if (!error.isEmpty())
+                errors.append(QString("%1 line %2: %3").arg(fileName).arg(lineNumber).arg(error));
+        }
+    }
+    foreach (const QString &error, errors)
+        qDebug() << error;
+    if (m_errors != errors) {
+        m_errors = errors;
+        emit errorsChanged(m_errors);
+    }
+    emit channelsChanged();
+    return errors.isEmpty();
+}
+
+void MathChannels::clear()
+{
+    if (m_channels.isEmpty())
+        return;
+    foreach (MathChannel *channel, m_channels) {
+        m_derivedChannels->removeChannel(channel->derivedId);
+        channel->outputProperty.write(m_dashboard, 0);
+    }
+    qDeleteAll(m_channels);
+    m_channels.clear();
+    emit channelsChanged();
+}
+
+bool MathChannels::addChannel(const QString &output, const QString &name, const QString &expression, QString *error)
+{
+    if (!m_dashboard || !m_derivedChannels)
+        return false;
+    const QMetaObject *metaObject = m_dashboard->metaObject();
+    const int outputIndex = metaObject->indexOfProperty(output.toLatin1().constData());
+    if (!output.startsWith("Mathchannel") || outputIndex < 0) {
+        *error = QString("output must be Mathchannel1 to Mathchannel%1").arg(MAX_CHANNELS);
+        return false;
+    }
+    foreach (const MathChannel *channel, m_channels) {
+        if (channel->output == output) {
+            *error = output + " is already used";
+            return false;
+        }
+    }
+
+    MathChannel *channel = new MathChannel;
+    channel->output = output;
+    channel->name = name.isEmpty() ? output : name;
+    channel->outputProperty = metaObject->property(outputIndex);
+    QStringList inputNames;
+    const MathExpression::Resolver resolveInput = [&](const QString &input) {
+        int slot = inputNames.indexOf(input);
+        if (slot >= 0)
+            return slot;
+        const int index = metaObject->indexOfProperty(input.toLatin1().constData());
+        if (index < 0)
+            return -1;
+        inputNames.append(input);
+        channel->inputs.append(metaObject->property(index));
+        return inputNames.size() - 1;
+    };
+    if (!channel->expression.compile(expression, resolveInput, error)) {
+        delete channel;
+        return false;
+    }
+    channel->inputValues.resize(channel->inputs.size());
+    channel->derivedId = m_derivedChannels->addChannel(QStringList() << output, inputNames,
+                                                       [this, channel]() { compute(channel); });
+    if (channel->derivedId < 0) {
+        *error = output + " depends on itself through other math channels";
+        delete channel;
+        return false;
+    }
+    m_channels.append(channel);
+    return true;
+}
+
+// Called for every change of an input; reads the inputs and writes the output without allocating
+void MathChannels::compute(MathChannel *channel)
+{
+    for (int i = 0; i < channel->inputs.size(); i++)
+        channel->inputValues[i] = channel->inputs[i].read(m_dashboard).toReal();
+    channel->outputProperty.write(m_dashboard, channel->expression.evaluate(channel->inputValues.constData()));
+}
+
+QStringList MathChannels::outputs() const
+{
+    QStringList outputs;
+    foreach (const MathChannel *channel, m_channels)
+        outputs.append(channel->output);
+    return outputs;
+}
+
+QStringList MathChannels::names() const
+{
+    QStringList names;
+    foreach (const MathChannel *channel, m_channels)
+        names.append(channel->name);
+    return names;
+}
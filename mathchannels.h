@@ -0,0 +1,69 @@
+#ifndef MATHCHANNELS_H
+#define MATHCHANNELS_H
+
+#include <QObject>
+#include <QVector>
+#include <QStringList>
+#include <QMetaProperty>
+#include "mathexpression.h"
+
+class DashBoard;
+class DerivedChannels;
+
+/*
+ * User defined math channels, loaded from a file with a line per channel:
+ *
+ *   # output,name,expression
+ *   Mathchannel1,Boost,MAP - ambipress
+ *   Mathchannel2,AFR,lambda * 14.7
+ *
+ * Inputs are DashBoard channels; the output is one of Mathchannel1 to Mathchannel8, so it can be
+ * picked in the gauges (and their warnings) like any other channel and is added to the logs.
+ * The expressions are computed as derived channels, when one of their inputs changed.
+ * An expression may use its own output, ex. max(Mathchannel3, BoostPres) holds the peak.
+ */
+class MathChannels : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList errors READ errors NOTIFY errorsChanged)
+
+public:
+    static const char *DEFAULT_FILE;
+    static const int MAX_CHANNELS = 8;
+
+    explicit MathChannels(QObject *parent = 0);
+    explicit MathChannels(DashBoard *dashboard, DerivedChannels *derivedChannels, QObject *parent = 0);
+    ~MathChannels();
+
+    Q_INVOKABLE bool load(const QString &fileName = QString(DEFAULT_FILE));
+    Q_INVOKABLE void clear();
+
+    QStringList outputs() const;
+    QStringList names() const;
+    QStringList errors() const { return m_errors; }
+
+signals:
+    void channelsChanged();
+    void errorsChanged(QStringList errors);
+
+private:
+    struct MathChannel {
+        QString output;
+        QString name;
+        MathExpression expression;
+        QVector<QMetaProperty> inputs;
+        QVector<qreal> inputValues;
+        QMetaProperty outputProperty;
+        int derivedId;
+    };
+
+    bool addChannel(const QString &output, const QString &name, const QString &expression, QString *error);
+    void compute(MathChannel *channel);
+
+    DashBoard *m_dashboard;
+    DerivedChannels *m_derivedChannels;
+    QVector<MathChannel *> m_channels;
+    QStringList m_errors;
+};
+
+#endif // MATHCHANNELS_H
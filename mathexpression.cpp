@@ -0,0 +1,366 @@
+#include "mathexpression.h"
+#include <QtMath>
+
+/*
+ * Recursive descent parser; emits the bytecode in postfix order while parsing.
+ *
+ * expression := additive (('<' | '>' | '<=' | '>=' | '==' | '!=') additive)?
+ * additive   := term (('+' | '-') term)*
+ * term       := unary (('*' | '/') unary)*
+ * unary      := '-' unary | power
+ * power      := primary ('^' unary)?
+ * primary    := number | input | function '(' expression (',' expression)* ')' | '(' expression ')'
+ */
+class MathExpressionParser
+{
+public:
+    MathExpressionParser(const QString &text, const MathExpression::Resolver &resolveInput)
+        : m_text(text)
+        , m_resolveInput(resolveInput)
+        , m_pos(0)
+        , m_depth(0)
+        , m_maxDepth(0)
+    {
+    }
+
+    bool parse()
+    {
+        if (!parseExpression())
+            return false;
+        skipSpaces();
+        if (m_pos < m_text.size())
+            return fail(QStringLiteral("unexpected '%1'").arg(m_text.at(m_pos)));
+        return true;
+    }
+
+    QVector<MathExpression::Instruction> code;
+    QString error;
+    int maxDepth() const { return m_maxDepth; }
+
+private:
+    bool fail(const QString &message)
+    {
+        if (error.isEmpty())
+            error = message + QStringLiteral(" at %1").arg(m_pos + 1);
+        return false;
+    }
+
+    void emitOp(MathExpression::OpCode op, int input = -1, qreal constant = 0)
+    {
+        const MathExpression::Instruction instruction = {op, input, constant};
+        code.append(instruction);
+        switch (op) {
+        case MathExpression::PushConstant:
+        case MathExpression::PushInput:
+            m_depth++;
+            break;
+        case MathExpression::Negate:
+        case MathExpression::Abs:
+        case MathExpression::Sqrt:
+            break;
+        case MathExpression::Select:
+            m_depth -= 2;
+            break;
+        default:
+            m_depth--;
+            break;
+        }
+        m_maxDepth = qMax(m_maxDepth, m_depth);
+    }
+
+    void skipSpaces()
+    {
+        while (m_pos < m_text.size() && m_text.at(m_pos).isSpace())
+            m_pos++;
+    }
+
+    bool accept(const char *token)
+    {
+        skipSpaces();
+        const QLatin1String latin1(token);
+        if (!m_text.midRef(m_pos).startsWith(latin1))
+            return false;
+        m_pos += latin1.size();
+        return true;
+    }
+
+    bool parseExpression()
+    {
+        if (!parseAdditive())
+            return false;
+        // two character operators first
+        static const struct { const char *token; MathExpression::OpCode op; } comparisons[] = {
+            {"<=", MathExpression::LessEqual}, {">=", MathExpression::GreaterEqual},
+            {"==", MathExpression::Equal}, {"!=", MathExpression::NotEqual},
+            {"<", MathExpression::Less}, {">", MathExpression::Greater}
+        };
+        for (size_t i = 0; i < sizeof(comparisons) / sizeof(comparisons[0]); i++) {
+            if (accept(comparisons[i].token)) {
+                if (!parseAdditive())
+                    return false;
+                emitOp(comparisons[i].op);
+                break;
+            }
+        }
+        return true;
+    }
+
+    bool parseAdditive()
+    {
+        if (!parseTerm())
+            return false;
+        for (;;) {
+            if (accept("+")) {
+                if (!parseTerm())
+                    return false;
+                emitOp(MathExpression::Add);
+            } else if (accept("-")) {
+                if (!parseTerm())
+                    return false;
+                emitOp(MathExpression::Subtract);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseTerm()
+    {
+        if (!parseUnary())
+            return false;
+        for (;;) {
+            if (accept("*")) {
+                if (!parseUnary())
+                    return false;
+                emitOp(MathExpression::Multiply);
+            } else if (accept("/")) {
+                if (!parseUnary())
+                    return false;
+                emitOp(MathExpression::Divide);
+            } else {
+                return true;
+            }
+        }
+    }
+
+    bool parseUnary()
+    {
+        if (accept("-")) {
+            if (!parseUnary())
+                return false;
+            emitOp(MathExpression::Negate);
+            return true;
+        }
+        return parsePower();
+    }
+
+    bool parsePower()
+    {
+        if (!parsePrimary())
+            return false;
+        if (accept("^")) {
+            if (!parseUnary())
+                return false;
+            emitOp(MathExpression::Power);
+        }
+        return true;
+    }
+
+    bool parsePrimary()
+    {
+        skipSpaces();
+        if (m_pos >= m_text.size())
+            return fail(QStringLiteral("unexpected end"));
+        const QChar c = m_text.at(m_pos);
+        if (c == QLatin1Char('(')) {
+            m_pos++;
+            if (!parseExpression())
+                return false;
+            return accept(")") || fail(QStringLiteral("missing ')'"));
+        }
+        if (c.isDigit() || c == QLatin1Char('.'))
+            return parseNumber();
+        if (c.isLetter() || c == QLatin1Char('_'))
+            return parseIdentifier();
+        return fail(QStringLiteral("unexpected '%1'").arg(c));
+    }
+
+    bool parseNumber()
+    {
+        const int start = m_pos;
+        while (m_pos < m_text.size() && (m_text.at(m_pos).isDigit() || m_text.at(m_pos) == QLatin1Char('.')))
+            m_pos++;
+        // exponent, ex. 1e-3
+        if (m_pos < m_text.size() && (m_text.at(m_pos) == QLatin1Char('e') || m_text.at(m_pos) == QLatin1Char('E'))) {
+            int end = m_pos + 1;
+            if (end < m_text.size() && (m_text.at(end) == QLatin1Char('+') || m_text.at(end) == QLatin1Char('-')))
+                end++;
+            if (end < m_text.size() && m_text.at(end).isDigit()) {
+                m_pos = end;
+                while (m_pos < m_text.size() && m_text.at(m_pos).isDigit())
+                    m_pos++;
+            }
+        }
+        bool ok = false;
+        const qreal value = m_text.midRef(start, m_pos - start).toDouble(&ok);
+        if (!ok) {
+            m_pos = start;
+            return fail(QStringLiteral("invalid number"));
+        }
+        emitOp(MathExpression::PushConstant, -1, value);
+        return true;
+    }
+
+    bool parseIdentifier()
+    {
+        const int start = m_pos;
+        while (m_pos < m_text.size() && (m_text.at(m_pos).isLetterOrNumber() || m_text.at(m_pos) == QLatin1Char('_')))
+            m_pos++;
+        const QString name = m_text.mid(start, m_pos - start);
+        if (accept("("))
+            return parseFunction(name, start);
+        const int input = m_resolveInput ? m_resolveInput(name) : -1;
+        if (input < 0) {
+            m_pos = start;
+            return fail(QStringLiteral("unknown channel '%1'").arg(name));
+        }
+        emitOp(MathExpression::PushInput, input);
+        return true;
+    }
+
+    bool parseFunction(const QString &name, int start)
+    {
+        static const struct { const char *name; int arguments; MathExpression::OpCode op; } functions[] = {
+            {"abs", 1, MathExpression::Abs}, {"sqrt", 1, MathExpression::Sqrt},
+            {"min", 2, MathExpression::Min}, {"max", 2, MathExpression::Max},
+            {"if", 3, MathExpression::Select}
+        };
+        for (size_t i = 0; i < sizeof(functions) / sizeof(functions[0]); i++) {
+            if (name != QLatin1String(functions[i].name))
+                continue;
+            for (int argument = 0; argument < functions[i].arguments; argument++) {
+                if (argument > 0 && !accept(","))
+                    return fail(QStringLiteral("%1 takes %2 arguments").arg(name).arg(functions[i].arguments));
+                if (!parseExpression())
+                    return false;
+            }
+            if (!accept(")"))
+                return fail(QStringLiteral("missing ')'"));
+            emitOp(functions[i].op);
+            return true;
+        }
+        m_pos = start;
+        return fail(QStringLiteral("unknown function '%1'").arg(name));
+    }
+
+    const QString &m_text;
+    const MathExpression::Resolver &m_resolveInput;
+    int m_pos;
+    int m_depth;
+    int m_maxDepth;
+};
+
+MathExpression::MathExpression()
+{
+}
+
+bool MathExpression::compile(const QString &text, const Resolver &resolveInput, QString *error)
+{
+    MathExpressionParser parser(text, resolveInput);
+    if (!parser.parse()) {
+        m_code.clear();
+        m_stack.clear();
+        if (error)
+            *error = parser.error;
+        return false;
+    }
+    m_code = parser.code;
+    m_stack.resize(parser.maxDepth());
+    return true;
+}
+
+qreal MathExpression::evaluate(const qreal *inputs) const
+{
+    if (m_code.isEmpty())
+        return 0;
+    qreal *stack = m_stack.data();
+    int top = -1;
+    const Instruction *instruction = m_code.constData();
+    const Instruction *end = instruction + m_code.size();
+    for (; instruction != end; ++instruction) {
+        switch (instruction->op) {
+        case PushConstant:
+            stack[++top] = instruction->constant;
+            break;
+        case PushInput:
+            stack[++top] = inputs[instruction->input];
+            break;
+        case Add:
+            top--;
+            stack[top] += stack[top + 1];
+            break;
+        case Subtract:
+            top--;
+            stack[top] -= stack[top + 1];
+            break;
+        case Multiply:
+            top--;
+            stack[top] *= stack[top + 1];
+            break;
+        case Divide:
+            top--;
+            stack[top] = stack[top + 1] == 0 ? 0 : stack[top] / stack[top + 1];
+            break;
+        case Power:
+            top--;
+            stack[top] = qPow(stack[top], stack[top + 1]);
+            break;
+        case Negate:
+            stack[top] = -stack[top];
+            break;
+        case Less:
+            top--;
+            stack[top] = stack[top] < stack[top + 1] ? 1 : 0;
+            break;
+        case Greater:
+            top--;
+            stack[top] = stack[top] > stack[top + 1] ? 1 : 0;
+            break;
+        case LessEqual:
+            top--;
+            stack[top] = stack[top] <= stack[top + 1] ? 1 : 0;
+            break;
+        case GreaterEqual:
+            top--;
+            stack[top] = stack[top] >= stack[top + 1] ? 1 : 0;
+            break;
+        case Equal:
+            top--;
+            stack[top] = stack[top] == stack[top + 1] ? 1 : 0;
+            break;
+        case NotEqual:
+            top--;
+            stack[top] = stack[top] != stack[top + 1] ? 1 : 0;
+            break;
+        case Abs:
+            stack[top] = qAbs(stack[top]);
+            break;
+        case Sqrt:
+            stack[top] = stack[top] < 0 ? 0 : qSqrt(stack[top]);
+            break;
+        case Min:
+            top--;
+            stack[top] = qMin(stack[top], stack[top + 1]);
+            break;
+        case Max:
+            top--;
+            stack[top] = qMax(stack[top], stack[top + 1]);
+            break;
+        case Select:
+            top -= 2;
+            stack[top] = stack[top] != 0 ? stack[top + 1] : stack[top + 2];
+            break;
+        }
+    }
+    return stack[0];
+}
@@ -0,0 +1,63 @@
+#ifndef MATHEXPRESSION_H
+#define MATHEXPRESSION_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/*
+ * An expression of a math channel, ex. "MAP - ambipress" or "if(rpm > 0, injms * rpm / 1200, 0)".
+ *
+ * Compiled once into a stack based bytecode; evaluating it does not allocate. Supports numbers,
+ * inputs, + - * / ^, comparisons (1 or 0), parentheses and the functions abs, sqrt, min, max and
+ * if(condition, then, else). Division by zero gives 0, so a gauge never shows inf.
+ */
+class MathExpression
+{
+public:
+    // Returns the input slot of an identifier, -1 if it is unknown
+    typedef std::function<int(const QString &)> Resolver;
+
+    MathExpression();
+
+    bool compile(const QString &text, const Resolver &resolveInput, QString *error = 0);
+    bool isValid() const { return !m_code.isEmpty(); }
+    // inputs are indexed by the slots given by the resolver
+    qreal evaluate(const qreal *inputs) const;
+
+private:
+    friend class MathExpressionParser;
+
+    enum OpCode {
+        PushConstant,
+        PushInput,
+        Add,
+        Subtract,
+        Multiply,
+        Divide,
+        Power,
+        Negate,
+        Less,
+        Greater,
+        LessEqual,
+        GreaterEqual,
+        Equal,
+        NotEqual,
+        Abs,
+        Sqrt,
+        Min,
+        Max,
+        Select
+    };
+
+    struct Instruction {
+        OpCode op;
+        int input;
+        qreal constant;
+    };
+
+    QVector<Instruction> m_code;
+    mutable QVector<qreal> m_stack; // sized for the deepest point of the code
+};
+
+#endif // MATHEXPRESSION_H
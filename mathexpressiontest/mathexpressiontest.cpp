@@ -0,0 +1,103 @@
+/**
+ * Test of the math channel expressions.
+ *
+ * Expressions for operator precedence and associativity, if(), the functions and division by
+ * zero are evaluated with fixed inputs and compared with their known results. Expressions with
+ * an unknown channel or a syntax error must not compile.
+ *
+ * Usage:
+ *   mathexpressiontest
+ * Returns 0 when every expression gives its result.
+ */
+#include "mathexpression.h"
+#include <iostream>
+#include <cmath>
+
+using namespace std;
+
+const char *INPUT_NAMES[] = {"MAP", "ambipress", "rpm", "injms", "LAMBDA"};
+const qreal INPUTS[] = {150, 101.3, 6000, 5, 0.85};
+const int INPUT_COUNT = sizeof(INPUTS) / sizeof(INPUTS[0]);
+
+struct Case {
+    const char *text;
+    qreal result;
+};
+
+const Case CASES[] = {
+    // precedence and associativity
+    {"2 + 3 * 4", 14},
+    {"(2 + 3) * 4", 20},
+    {"10 - 2 - 3", 5},
+    {"8 / 4 / 2", 1},
+    {"2 ^ 3 ^ 2", 512},
+    {"-2 ^ 2", -4},
+    {"2 * -3", -6},
+    {"1 + 2 < 4", 1},
+    {"2 * 3 == 6", 1},
+    {"MAP - ambipress", 48.7},
+    {"LAMBDA * 14.7", 12.495},
+    // if
+    {"if(rpm > 0, injms * rpm / 1200, 0)", 25},
+    {"if(rpm < 0, 1, 2)", 2},
+    {"if(rpm >= 6000, if(MAP > 200, 1, 2), 3)", 2},
+    {"if(0, 1 / 0, 7)", 7},
+    // functions
+    {"min(1, max(2, 3))", 1},
+    {"abs(-3) + sqrt(16)", 7},
+    // division by zero gives 0
+    {"1 / 0", 0},
+    {"MAP / (rpm - rpm)", 0},
+    {"1 + 1 / 0", 1},
+    // numbers
+    {"1e3 + .5", 1000.5},
+};
+
+// do not compile
+const char *ERRORS[] = {
+    "MAP + boost",
+    "unknown(1)",
+    "MAP +",
+    "min(1)",
+    "(1 + 2",
+    "1 < 2 < 3",
+    "",
+};
+
+int resolve(const QString &name)
+{
+    for (int i = 0; i < INPUT_COUNT; i++) {
+        if (name == QLatin1String(INPUT_NAMES[i]))
+            return i;
+    }
+    return -1;
+}
+
+int main()
+{
+    bool passed = true;
+    for (const Case &test : CASES) {
+        MathExpression expression;
+        QString error;
+        if (!expression.compile(QString::fromLatin1(test.text), resolve, &error)) {
+            cerr << test.text << ": " << error.toStdString() << endl;
+            passed = false;
+            continue;
+        }
+        const qreal result = expression.evaluate(INPUTS);
+        if (qAbs(result - test.result) > 1e-9) {
+            cerr << test.text << " = " << result << ", expected " << test.result << endl;
+            passed = false;
+        }
+    }
+    for (const char *text : ERRORS) {
+        MathExpression expression;
+        QString error;
+        if (expression.compile(QString::fromLatin1(text), resolve, &error) || expression.isValid() || error.isEmpty()) {
+            cerr << "\"" << text << "\" compiled" << endl;
+            passed = false;
+        }
+    }
+    cout << (passed ? "Passed" : "Failed") << endl;
+    return passed ? 0 : 1;
+}
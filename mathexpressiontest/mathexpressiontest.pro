@@ -0,0 +1,14 @@
+# Test of the math channel expressions; evaluates expressions with known results (see mathexpressiontest.cpp).
+TEMPLATE = app
+TARGET = mathexpressiontest
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ..
+
+SOURCES += mathexpressiontest.cpp \
+    ../mathexpression.cpp
+
+HEADERS += ../mathexpression.h
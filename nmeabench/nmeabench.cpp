@@ -0,0 +1,121 @@
+/**
+ * Benchmark of the NMEA parser.
+ *
+ * A 25 Hz multi constellation epoch (RMC, GGA, 4 GSA, 12 GSV) is fed to the parser in chunks,
+ * as it arrives from the serial port, and the RMC and GGA fields read by the GPS class are
+ * parsed. Before the benchmark the same stream is split at every chunk size up to its length,
+ * with corrupted sentences in between, and the sentences found are checked.
+ *
+ * Usage:
+ *   nmeabench [epochs]
+ */
+#include "nmeaparser.h"
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+
+/**
+ * Returns $<body>*hh\r\n
+ */
+string sentence(const string &body)
+{
+    unsigned char checksum = 0;
+    for (size_t i = 0; i < body.size(); i++)
+        checksum ^= static_cast<unsigned char>(body[i]);
+    char tail[8];
+    snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+    return "$" + body + tail;
+}
+
+struct Counts {
+    int sentences;
+    int rmc;
+    int gga;
+    double sum; // of the parsed fields, so they are not optimized away
+};
+
+void feed(NmeaParser &parser, const string &stream, size_t chunk, Counts &counts)
+{
+    for (size_t pos = 0; pos < stream.size(); pos += chunk) {
+        const char *data = stream.data() + pos;
+        int size = int(min(chunk, stream.size() - pos));
+        while (size > 0) {
+            const int used = parser.feed(data, size);
+            data += used;
+            size -= used;
+            if (!parser.hasSentence())
+                continue;
+            counts.sentences++;
+            double value;
+            int time;
+            if (parser.isType("RMC")) {
+                counts.rmc++;
+                if (parser.fieldTime(1, time))
+                    counts.sum += time;
+                if (parser.fieldCoordinate(3, value))
+                    counts.sum += value;
+                if (parser.fieldCoordinate(5, value))
+                    counts.sum += value;
+                if (parser.fieldDouble(7, value))
+                    counts.sum += value;
+            } else if (parser.isType("GGA")) {
+                counts.gga++;
+                if (parser.fieldInt(6, time))
+                    counts.sum += time;
+                if (parser.fieldDouble(9, value))
+                    counts.sum += value;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    const int epochs = argc > 1 ? atoi(argv[1]) : 250000;
+    if (epochs <= 0) {
+        cerr << "Usage: nmeabench [epochs]" << endl;
+        return 1;
+    }
+
+    const string rmc = sentence("GNRMC,123519.40,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W,A");
+    const string gga = sentence("GNGGA,123519.40,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    string epoch = rmc + gga;
+    for (int i = 0; i < 4; i++)
+        epoch += sentence("GNGSA,A,3,01,02,03,04,05,06,07,08,09,10,11,12,1.2,0.9,0.8,1");
+    for (int i = 0; i < 12; i++)
+        epoch += sentence("GPGSV,3,1,12,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45");
+
+    // a UBX frame, a wrong checksum, a checksum that is not hex and a cut off sentence between the valid ones
+    string wrongChecksum = rmc;
+    wrongChecksum[10] = '9';
+    string notHex = rmc;
+    notHex[notHex.size() - 4] = 'G';
+    const string stream = string("\xb5\x62\x05\x01\x02\x00\x06\x08", 8) + rmc + gga + wrongChecksum + notHex
+            + "$GPTXT,cut off" + rmc;
+    for (size_t chunk = 1; chunk <= stream.size(); chunk++) {
+        NmeaParser parser;
+        Counts counts = {0, 0, 0, 0};
+        feed(parser, stream, chunk, counts);
+        if (counts.sentences != 3 || counts.rmc != 2 || counts.gga != 1 || parser.errors() != 3) {
+            cerr << "Chunks of " << chunk << " bytes: " << counts.sentences << " sentences, "
+                 << parser.errors() << " errors" << endl;
+            return 1;
+        }
+    }
+
+    NmeaParser parser;
+    Counts counts = {0, 0, 0, 0};
+    const chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (int i = 0; i < epochs; i++)
+        feed(parser, epoch, 64, counts);
+    const double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Epoch of " << epoch.size() << " bytes, " << epochs << " epochs in " << seconds << " s" << endl;
+    cout << seconds / epochs * 1e6 << " us per epoch, " << epoch.size() * double(epochs) / seconds / 1e6
+         << " MB/s (" << counts.sentences << " sentences, checksum " << counts.sum << ")" << endl;
+    return 0;
+}
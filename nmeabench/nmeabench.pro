@@ -0,0 +1,13 @@
+# Benchmark of the NMEA parser; feeds recorded style epochs as the serial port would (see nmeabench.cpp).
+TEMPLATE = app
+TARGET = nmeabench
+
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += nmeabench.cpp \
+    ../nmeaparser.cpp
+
+HEADERS += ../nmeaparser.h
@@ -0,0 +1,191 @@
+#include "nmeaparser.h"
+#include <cstring>
+#include <cmath>
+
+NmeaParser::NmeaParser()
+    : m_length(0)
+    , m_fieldCount(0)
+    , m_checksum(0)
+    , m_expectedChecksum(0)
+    , m_state(WaitStart)
+    , m_hasSentence(false)
+    , m_errors(0)
+{
+}
+
+void NmeaParser::reset()
+{
+    m_length = 0;
+    m_fieldCount = 1;
+    m_fieldStart[0] = 0;
+    m_checksum = 0;
+    m_state = Body;
+}
+
+int NmeaParser::hexValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    return -1;
+}
+
+int NmeaParser::feed(const char *data, int size)
+{
+    m_hasSentence = false;
+    for (int i = 0; i < size; i++) {
+        const char c = data[i];
+        switch (m_state) {
+        case WaitStart:
+            if (c == '$')
+                reset();
+            break;
+        case Body:
+            if (c == '$') {
+                // the previous sentence was cut off
+                m_errors++;
+                reset();
+            } else if (c == '*') {
+                m_state = Checksum1;
+            } else if (c == '\r' || c == '\n' || m_length >= MAX_SENTENCE) {
+                // no checksum or too long
+                m_errors++;
+                m_state = WaitStart;
+            } else {
+                m_checksum ^= static_cast<unsigned char>(c);
+                if (c == ',') {
+                    if (m_fieldCount >= MAX_FIELDS) {
+                        m_errors++;
+                        m_state = WaitStart;
+                        break;
+                    }
+                    m_fieldStart[m_fieldCount++] = m_length + 1;
+                }
+                m_sentence[m_length++] = c;
+            }
+            break;
+        case Checksum1:
+            if (hexValue(c) < 0) {
+                m_errors++;
+                m_state = WaitStart;
+                break;
+            }
+            m_expectedChecksum = hexValue(c) << 4;
+            m_state = Checksum2;
+            break;
+        case Checksum2:
+            m_state = WaitStart;
+            if (hexValue(c) < 0 || (m_expectedChecksum | hexValue(c)) != m_checksum) {
+                m_errors++;
+                break;
+            }
+            // the end of the last field
+            m_fieldStart[m_fieldCount] = m_length + 1;
+            m_hasSentence = true;
+            return i + 1;
+        }
+    }
+    return size;
+}
+
+const char *NmeaParser::fieldBegin(int field) const
+{
+    return m_sentence + m_fieldStart[field];
+}
+
+const char *NmeaParser::fieldEnd(int field) const
+{
+    return m_sentence + m_fieldStart[field + 1] - 1;
+}
+
+bool NmeaParser::isType(const char *type) const
+{
+    const int length = static_cast<int>(strlen(type));
+    return fieldEnd(0) - fieldBegin(0) == length + 2 && memcmp(fieldBegin(0) + 2, type, length) == 0;
+}
+
+bool NmeaParser::isTalker(const char *talker) const
+{
+    return fieldEnd(0) - fieldBegin(0) > 2 && memcmp(fieldBegin(0), talker, 2) == 0;
+}
+
+bool NmeaParser::isFieldEmpty(int field) const
+{
+    return field >= m_fieldCount || fieldBegin(field) == fieldEnd(field);
+}
+
+char NmeaParser::fieldChar(int field) const
+{
+    return isFieldEmpty(field) ? 0 : *fieldBegin(field);
+}
+
+bool NmeaParser::fieldInt(int field, int &value) const
+{
+    double number;
+    if (!fieldDouble(field, number))
+        return false;
+    value = static_cast<int>(number);
+    return true;
+}
+
+// Plain decimal numbers only, which is all NMEA uses; independent of the locale
+bool NmeaParser::fieldDouble(int field, double &value) const
+{
+    if (isFieldEmpty(field))
+        return false;
+    const char *c = fieldBegin(field);
+    const char *end = fieldEnd(field);
+    bool negative = false;
+    if (*c == '-' || *c == '+') {
+        negative = *c == '-';
+        c++;
+    }
+    double number = 0;
+    double scale = 0;
+    bool digits = false;
+    for (; c != end; c++) {
+        if (*c >= '0' && *c <= '9') {
+            number = number * 10 + (*c - '0');
+            if (scale)
+                scale *= 10;
+            digits = true;
+        } else if (*c == '.' && !scale) {
+            scale = 1;
+        } else {
+            return false;
+        }
+    }
+    if (!digits)
+        return false;
+    if (scale)
+        number /= scale;
+    value = negative ? -number : number;
+    return true;
+}
+
+bool NmeaParser::fieldCoordinate(int field, double &degrees) const
+{
+    double value;
+    if (!fieldDouble(field, value))
+        return false;
+    const double wholeDegrees = std::floor(value / 100);
+    degrees = wholeDegrees + (value - wholeDegrees * 100) / 60;
+    const char direction = fieldChar(field + 1);
+    if (direction == 'S' || direction == 'W')
+        degrees = -degrees;
+    return true;
+}
+
+bool NmeaParser::fieldTime(int field, int &msecs) const
+{
+    double value;
+    if (!fieldDouble(field, value))
+        return false;
+    const int hhmm = static_cast<int>(value / 100);
+    const double seconds = value - hhmm * 100;
+    msecs = static_cast<int>(std::floor(((hhmm / 100) * 3600 + (hhmm % 100) * 60 + seconds) * 1000 + 0.5));
+    return true;
+}
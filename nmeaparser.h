@@ -0,0 +1,76 @@
+#ifndef NMEAPARSER_H
+#define NMEAPARSER_H
+
+/*
+ * Incremental NMEA 0183 sentence parser.
+ *
+ * Bytes are fed as they arrive from the serial port, in chunks of any size; every sentence in a
+ * chunk is returned, one at a time. The sentence is checked against its *hh checksum and split
+ * into fields in a fixed buffer, and the fields are parsed to numbers in place, so nothing is
+ * allocated. Bytes outside of a sentence (ex. UBX binary frames) are skipped.
+ *
+ * Usage:
+ *   while (size > 0) {
+ *       const int used = parser.feed(data, size);
+ *       data += used;
+ *       size -= used;
+ *       if (parser.hasSentence())
+ *           ... parser.isType("RMC"), parser.fieldDouble(7, speed) ...
+ *   }
+ */
+class NmeaParser
+{
+public:
+    // the standard allows 82 characters; some receivers send longer proprietary sentences
+    static const int MAX_SENTENCE = 128;
+    static const int MAX_FIELDS = 40;
+
+    NmeaParser();
+
+    // Consumes bytes up to the end of the next valid sentence; returns the number of bytes used
+    int feed(const char *data, int size);
+    bool hasSentence() const { return m_hasSentence; }
+
+    // Sentence formatter without the talker, ex. "RMC" for $GPRMC and $GNRMC
+    bool isType(const char *type) const;
+    // Talker of the sentence, ex. "GP" or "GN"
+    bool isTalker(const char *talker) const;
+
+    int fieldCount() const { return m_fieldCount; }
+    bool isFieldEmpty(int field) const;
+    char fieldChar(int field) const;
+    bool fieldInt(int field, int &value) const;
+    bool fieldDouble(int field, double &value) const;
+    // ddmm.mmmm / dddmm.mmmm and the N/S/E/W field after it, in decimal degrees
+    bool fieldCoordinate(int field, double &degrees) const;
+    // hhmmss.ss; milliseconds since midnight
+    bool fieldTime(int field, int &msecs) const;
+
+    // Sentences rejected because of their checksum or length
+    unsigned long errors() const { return m_errors; }
+
+private:
+    enum State {
+        WaitStart,
+        Body,
+        Checksum1,
+        Checksum2
+    };
+
+    void reset();
+    const char *fieldBegin(int field) const;
+    const char *fieldEnd(int field) const;
+    static int hexValue(char c);
+
+    char m_sentence[MAX_SENTENCE];
+    int m_length;
+    int m_fieldStart[MAX_FIELDS + 1];
+    int m_fieldCount;
+    unsigned char m_checksum;
+    int m_expectedChecksum;
+    State m_state;
+    bool m_hasSentence;
+    unsigned long m_errors;
+};
+
+#endif // NMEAPARSER_H
@@ -0,0 +1,92 @@
+#include "odometerjournal.h"
+#include <QSaveFile>
+#include <QList>
+#include <QDebug>
+#include <unistd.h>
+
+// km or miles, the same unit as the odometer
+const qreal OdometerJournal::JOURNAL_DISTANCE = 0.5;
+
+OdometerJournal::OdometerJournal(const QString &fileName)
+    : m_fileName(fileName)
+    , m_file(fileName)
+    , m_writtenOdometer(-1)
+    , m_writtenTrip(-1)
+    , m_records(0)
+{
+    m_sinceWrite.start();
+}
+
+// odometer,trip,crc
+QByteArray OdometerJournal::record(qreal odometer, qreal trip)
+{
+    const QByteArray payload = QByteArray::number(odometer, 'f', 3) + ',' + QByteArray::number(trip, 'f', 3);
+    return payload + ',' + QByteArray::number(qChecksum(payload.constData(), payload.size())) + '\n';
+}
+
+bool OdometerJournal::load(qreal &odometer, qreal &trip)
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+    bool valid = false;
+    m_records = 0;
+    while (!file.atEnd()) {
+        const QByteArray line = file.readLine().trimmed();
+        m_records++;
+        const int crcStart = line.lastIndexOf(',');
+        if (crcStart < 0)
+            continue;
+        const QByteArray payload = line.left(crcStart);
+        bool ok = false;
+        const quint16 crc = line.mid(crcStart + 1).toUShort(&ok);
+        const QList<QByteArray> values = payload.split(',');
+        if (!ok || values.size() != 2 || crc != qChecksum(payload.constData(), payload.size()))
+            continue;
+        odometer = values[0].toDouble();
+        trip = values[1].toDouble();
+        valid = true;
+    }
+    if (valid) {
+        m_writtenOdometer = odometer;
+        m_writtenTrip = trip;
+    }
+    return valid;
+}
+
+void OdometerJournal::update(qreal odometer, qreal trip, bool force)
+{
+    if (odometer == m_writtenOdometer && trip == m_writtenTrip)
+        return;
+    if (!force && qAbs(odometer - m_writtenOdometer) < JOURNAL_DISTANCE && qAbs(trip - m_writtenTrip) < JOURNAL_DISTANCE
+            && !m_sinceWrite.hasExpired(JOURNAL_INTERVAL_MS))
+        return;
+    m_writtenOdometer = odometer;
+    m_writtenTrip = trip;
+    m_sinceWrite.restart();
+    if (m_records >= MAX_RECORDS && compact(odometer, trip))
+        return;
+    if (!m_file.isOpen() && !m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        qDebug() << "Could not open odometer journal" << m_fileName;
+        return;
+    }
+    m_file.write(record(odometer, trip));
+    // flush() only hands the record to the page cache, which a power cut within the writeback
+    // delay would still lose
+    m_file.flush();
+    fdatasync(m_file.handle());
+    m_records++;
+}
+
+// Replaces the journal by a single record; the old journal stays valid until the new one is complete
+bool OdometerJournal::compact(qreal odometer, qreal trip)
+{
+    m_file.close();
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly) || file.write(record(odometer, trip)) < 0 || !file.commit()) {
+        qDebug() << "Could not compact odometer journal" << m_fileName;
+        return false;
+    }
+    m_records = 1;
+    return true;
+}
@@ -0,0 +1,42 @@
+#ifndef ODOMETERJOURNAL_H
+#define ODOMETERJOURNAL_H
+
+#include <QString>
+#include <QFile>
+#include <QElapsedTimer>
+
+/*
+ * Keeps the odometer and trip meter on the SD card with few writes.
+ *
+ * A record (odometer, trip, CRC) is appended every JOURNAL_DISTANCE, every JOURNAL_INTERVAL_MS
+ * while the values change and whenever a write is forced (ex. the car stopped, so a following
+ * ignition off loses nothing). Each record is synced to the card when it is written. On load the last record with a valid CRC is used, so a record torn
+ * by a power cut only loses that record. Once the journal has MAX_RECORDS it is replaced
+ * atomically by a single record.
+ */
+class OdometerJournal
+{
+public:
+    static const qreal JOURNAL_DISTANCE;
+    static const int JOURNAL_INTERVAL_MS = 60000;
+    static const int MAX_RECORDS = 2000;
+
+    explicit OdometerJournal(const QString &fileName);
+
+    // Returns false if there is no valid record
+    bool load(qreal &odometer, qreal &trip);
+    void update(qreal odometer, qreal trip, bool force = false);
+
+private:
+    static QByteArray record(qreal odometer, qreal trip);
+    bool compact(qreal odometer, qreal trip);
+
+    QString m_fileName;
+    QFile m_file;
+    QElapsedTimer m_sinceWrite;
+    qreal m_writtenOdometer;
+    qreal m_writtenTrip;
+    int m_records;
+};
+
+#endif // ODOMETERJOURNAL_H
@@ -0,0 +1,43 @@
+#include "sampleclock.h"
+#include <QElapsedTimer>
+
+namespace {
+const int MSECS_PER_DAY = 86400000;
+
+QElapsedTimer &clock()
+{
+    static QElapsedTimer timer;
+    if (!timer.isValid())
+        timer.start();
+    return timer;
+}
+
+bool hasReference = false;
+qint64 referenceSampleTime = 0;
+int referenceTimeOfDay = 0;
+}
+
+qint64 SampleClock::now()
+{
+    return clock().elapsed();
+}
+
+void SampleClock::setGpsReference(qint64 sampleTime, int gpsTimeOfDay)
+{
+    hasReference = true;
+    referenceSampleTime = sampleTime;
+    referenceTimeOfDay = gpsTimeOfDay;
+}
+
+bool SampleClock::hasGpsReference()
+{
+    return hasReference;
+}
+
+int SampleClock::gpsTimeOfDay(qint64 sampleTime)
+{
+    if (!hasReference)
+        return -1;
+    const qint64 timeOfDay = (referenceTimeOfDay + sampleTime - referenceSampleTime) % MSECS_PER_DAY;
+    return int(timeOfDay < 0 ? timeOfDay + MSECS_PER_DAY : timeOfDay);
+}
@@ -0,0 +1,25 @@
+#ifndef SAMPLECLOCK_H
+#define SAMPLECLOCK_H
+
+#include <QtGlobal>
+
+/*
+ * The monotonic clock every sample is stamped with when it is received, in ms since the start
+ * of the application. Unlike QTime::currentTime it does not jump when the system time is set
+ * (GPS, NTP), so samples of different sources (ECU, UDP, GPS, IMU) can be put side by side.
+ *
+ * The GPS is the reference to align with other recordings: each fix sets the UTC time of day
+ * it was taken at against the sample time it was received at.
+ */
+class SampleClock
+{
+public:
+    static qint64 now();
+
+    static void setGpsReference(qint64 sampleTime, int gpsTimeOfDay);
+    static bool hasGpsReference();
+    // UTC ms of the day at a sample time, -1 without a fix
+    static int gpsTimeOfDay(qint64 sampleTime);
+};
+
+#endif // SAMPLECLOCK_H
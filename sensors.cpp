@@ -11,6 +11,8 @@
 
 #include "sensors.h"
 #include "dashboard.h"
+#include "gpsimufusion.h"
+#include "channelhistory.h"
 #include <QAccelerometer>
 #include <QAccelerometerReading>
 #include <QGyroscope>
@@ -22,9 +24,23 @@
 #include <QDebug>
 #include <QDateTime>
 
+const qreal Sensors::DEFAULT_IMU_CUTOFF_HZ = 10;
+
+namespace {
+const qreal STANDARD_GRAVITY = 9.80665;
+const qreal MS2_TO_G = 0.10197162129779;
+const int CALIBRATION_SECONDS = 1;
+}
+
 Sensors::Sensors(QObject *parent)
     : QObject(parent)
     , m_dashboard(Q_NULLPTR)
+    , m_fusion(Q_NULLPTR)
+    , m_channelHistory(Q_NULLPTR)
+    , m_imuRate(DEFAULT_IMU_RATE)
+    , m_accelFilter(STANDARD_GRAVITY)
+    , m_accelBuffer(IMU_BUFFER_CAPACITY)
+    , m_gyroBuffer(IMU_BUFFER_CAPACITY)
 
 {
 
@@ -32,6 +48,12 @@ Sensors::Sensors(QObject *parent)
 Sensors::Sensors(DashBoard *dashboard, QObject *parent)
     : QObject(parent)
     , m_dashboard(dashboard)
+    , m_fusion(Q_NULLPTR)
+    , m_channelHistory(Q_NULLPTR)
+    , m_imuRate(DEFAULT_IMU_RATE)
+    , m_accelFilter(STANDARD_GRAVITY)
+    , m_accelBuffer(IMU_BUFFER_CAPACITY)
+    , m_gyroBuffer(IMU_BUFFER_CAPACITY)
     , Compass(Q_NULLPTR)
     , Accelerometer(Q_NULLPTR)
     , Gyroscope(Q_NULLPTR)
@@ -45,6 +67,51 @@ Sensors::Sensors(DashBoard *dashboard, QObject *parent)
 
 
 {
+    m_accelFilter.setCutoff(DEFAULT_IMU_CUTOFF_HZ);
+    m_gyroFilter.setCutoff(DEFAULT_IMU_CUTOFF_HZ);
+    connect(&m_batchTimer, &QTimer::timeout, this, &Sensors::processImuBatch);
+}
+void Sensors::setFusion(GpsImuFusion *fusion)
+{
+    m_fusion = fusion;
+}
+void Sensors::setChannelHistory(ChannelHistory *channelHistory)
+{
+    m_channelHistory = channelHistory;
+    if (!m_channelHistory)
+        return;
+    const char *const channels[] = {"accelx", "accely", "accelz", "gyrox", "gyroy", "gyroz"};
+    for (int i = 0; i < 6; i++)
+        m_historySlots[i] = m_channelHistory->addChannel(QLatin1String(channels[i]));
+}
+void Sensors::setImuRate(const int &rate)
+{
+    if (rate <= 0 || rate == m_imuRate)
+        return;
+    m_imuRate = rate;
+    if (Accelerometer)
+        startImu(Accelerometer);
+    if (Gyroscope)
+        startImu(Gyroscope);
+}
+void Sensors::setImuCutoff(const qreal &cutoffHz)
+{
+    m_accelFilter.setCutoff(cutoffHz);
+    m_gyroFilter.setCutoff(cutoffHz);
+}
+void Sensors::calibrateImu()
+{
+    m_accelFilter.calibrate(m_imuRate * CALIBRATION_SECONDS);
+    m_gyroFilter.calibrate(m_imuRate * CALIBRATION_SECONDS);
+}
+// The data rate of a sensor only changes when it is started
+void Sensors::startImu(QSensor *sensor)
+{
+    sensor->stop();
+    sensor->setDataRate(m_imuRate);
+    sensor->start();
+    if (!m_batchTimer.isActive())
+        m_batchTimer.start(BATCH_INTERVAL_MS);
 }
 void Sensors::Comp()
 {
@@ -57,19 +124,23 @@ void Sensors::Comp()
 }
 void Sensors::Accel()
 {
+if (Accelerometer)
+    return;
 Accelerometer = new QAccelerometer(this);
 connect(Accelerometer, SIGNAL(readingChanged()), this, SLOT(updateAccel()));
 connect(Accelerometer, SIGNAL(sensorError(int)), this, SLOT(error(int)));
-Accelerometer->setDataRate(1);
-Accelerometer->start();
+m_accelFilter.calibrate(m_imuRate * CALIBRATION_SECONDS);
+startImu(Accelerometer);
 }
 void Sensors::Gyro()
 {
+if (Gyroscope)
+    return;
 Gyroscope = new QGyroscope(this);
 connect(Gyroscope, SIGNAL(readingChanged()), this, SLOT(updateGyro()));
 connect(Gyroscope, SIGNAL(sensorError(int)), this, SLOT(error(int)));
-Gyroscope->setDataRate(1);
-Gyroscope->start();
+m_gyroFilter.calibrate(m_imuRate * CALIBRATION_SECONDS);
+startImu(Gyroscope);
 }
 
 void Sensors::Temperature()
@@ -117,9 +188,11 @@ void Sensors::updateAccel()
     accel_reading = Accelerometer->reading();
 ;
     if(accel_reading != 0) {
-        m_dashboard->setaccelx(accel_reading->x()*0.10197162129779);
-        m_dashboard->setaccely(accel_reading->y()*0.10197162129779);
-        m_dashboard->setaccelz(accel_reading->z()*0.10197162129779);
+        ImuSample sample = { SampleClock::now(), accel_reading->x(), accel_reading->y(), accel_reading->z() };
+        m_accelFilter.apply(accel_reading->timestamp(), sample);
+        m_accelBuffer.append(sample);
+        if (m_fusion)
+            m_fusion->addAcceleration(sample.y);
         /*text_accel = QDateTime::currentDateTime().toString() +
                 + "Acceleration  x = " + QString::number(accel_reading->x())+ "y ="
                 + QString::number(accel_reading->y())+ "z ="+ QString::number(accel_reading->z());
@@ -134,10 +207,60 @@ void Sensors::updateAccel()
 void Sensors::updateGyro()
 {
     gyro_reading = Gyroscope->reading();
-    if(accel_reading != 0) {
-        m_dashboard->setgyrox(gyro_reading->x());
-        m_dashboard->setgyroy(gyro_reading->y());
-        m_dashboard->setgyroz(gyro_reading->z());
+    if(gyro_reading != 0) {
+        ImuSample sample = { SampleClock::now(), gyro_reading->x(), gyro_reading->y(), gyro_reading->z() };
+        m_gyroFilter.apply(gyro_reading->timestamp(), sample);
+        m_gyroBuffer.append(sample);
+        if (m_fusion)
+            m_fusion->addYawRate(sample.z);
+    }
+}
+// Full rate to the channel history, the mean of the batch to the DashBoard
+void Sensors::processImuBatch()
+{
+    if (m_accelBuffer.size()) {
+        qreal x = 0;
+        qreal y = 0;
+        qreal z = 0;
+        for (int i = 0; i < m_accelBuffer.size(); i++) {
+            const ImuSample &sample = m_accelBuffer.at(i);
+            x += sample.x;
+            y += sample.y;
+            z += sample.z;
+            if (m_channelHistory) {
+                m_channelHistory->recordAt(m_historySlots[0], sample.timeMs, sample.x * MS2_TO_G);
+                m_channelHistory->recordAt(m_historySlots[1], sample.timeMs, sample.y * MS2_TO_G);
+                m_channelHistory->recordAt(m_historySlots[2], sample.timeMs, sample.z * MS2_TO_G);
+            }
+        }
+        const qreal scale = MS2_TO_G / m_accelBuffer.size();
+        // the mean is of the middle of the batch
+        SampleTimeScope scope(m_dashboard, m_accelBuffer.at(m_accelBuffer.size() / 2).timeMs);
+        m_dashboard->setaccelx(x * scale);
+        m_dashboard->setaccely(y * scale);
+        m_dashboard->setaccelz(z * scale);
+        m_accelBuffer.clear();
+    }
+    if (m_gyroBuffer.size()) {
+        qreal x = 0;
+        qreal y = 0;
+        qreal z = 0;
+        for (int i = 0; i < m_gyroBuffer.size(); i++) {
+            const ImuSample &sample = m_gyroBuffer.at(i);
+            x += sample.x;
+            y += sample.y;
+            z += sample.z;
+            if (m_channelHistory) {
+                m_channelHistory->recordAt(m_historySlots[3], sample.timeMs, sample.x);
+                m_channelHistory->recordAt(m_historySlots[4], sample.timeMs, sample.y);
+                m_channelHistory->recordAt(m_historySlots[5], sample.timeMs, sample.z);
+            }
+        }
+        SampleTimeScope scope(m_dashboard, m_gyroBuffer.at(m_gyroBuffer.size() / 2).timeMs);
+        m_dashboard->setgyrox(x / m_gyroBuffer.size());
+        m_dashboard->setgyroy(y / m_gyroBuffer.size());
+        m_dashboard->setgyroz(z / m_gyroBuffer.size());
+        m_gyroBuffer.clear();
     }
 }
 void Sensors::updateAmbientSens()
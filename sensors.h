@@ -7,16 +7,29 @@
 #include <QCompass>
 #include <QAmbientTemperatureSensor>
 #include <QPressureSensor>
+#include <QTimer>
+#include "imubuffer.h"
 
 class Sensors;
 class DashBoard;
+class GpsImuFusion;
+class ChannelHistory;
 
+/*
+ * The accelerometer and gyroscope run at the IMU rate. Their readings are bias corrected,
+ * low pass filtered and passed to the GPS/IMU fusion as they come, which steps faster than the
+ * batches. They are also collected in a buffer that is handed on every BATCH_INTERVAL_MS: each
+ * sample goes to the channel history (charts, dyno), the DashBoard gets the mean of the batch.
+ */
 class Sensors : public QObject
 {
     Q_OBJECT
 
 public:
-
+    static const int DEFAULT_IMU_RATE = 100;
+    static const int BATCH_INTERVAL_MS = 50;
+    static const int IMU_BUFFER_CAPACITY = 512;
+    static const qreal DEFAULT_IMU_CUTOFF_HZ;
 
     explicit Sensors(QObject *parent = 0);
     explicit Sensors(DashBoard *dashboard, QObject *parent = 0);
@@ -25,6 +38,14 @@ public:
     Q_INVOKABLE void Gyro();
     Q_INVOKABLE void Temperature();
     Q_INVOKABLE void Pressure();
+    // Accelerometer and gyroscope readings are passed on to the GPS/IMU fusion
+    void setFusion(GpsImuFusion *fusion);
+    void setChannelHistory(ChannelHistory *channelHistory);
+    // Samples per second of the accelerometer and gyroscope; restarts them when running
+    Q_INVOKABLE void setImuRate(const int &rate);
+    Q_INVOKABLE void setImuCutoff(const qreal &cutoffHz);
+    // Takes the bias from the next second of samples, the car has to stand still; also done when a sensor starts
+    Q_INVOKABLE void calibrateImu();
 
 
 public slots:
@@ -35,8 +56,21 @@ public slots:
     void updatePressureSens();
     void error(int);
 
+private slots:
+    void processImuBatch();
+
 private:
     DashBoard *m_dashboard;
+    GpsImuFusion *m_fusion;
+    ChannelHistory *m_channelHistory;
+    int m_historySlots[6]; // accelx, accely, accelz, gyrox, gyroy, gyroz
+    int m_imuRate;
+    ImuFilter m_accelFilter;
+    ImuFilter m_gyroFilter;
+    ImuBuffer m_accelBuffer;
+    ImuBuffer m_gyroBuffer;
+    QTimer m_batchTimer;
+    void startImu(QSensor *sensor);
 
     QCompass *Compass;
     QAccelerometer *Accelerometer;
@@ -0,0 +1,173 @@
+#include "trackdatabase.h"
+#include <QFile>
+#include <QTextStream>
+#include <QtMath>
+#include <QDebug>
+
+const char *TrackDatabase::RESOURCE_FILE = ":/GPSTracks/Tracks.txt";
+const char *TrackDatabase::DEFAULT_FILE = "/home/pi/Tracks.txt";
+const qreal TrackDatabase::CELL_SIZE = 0.1;
+const qreal TrackDatabase::DETECT_DISTANCE_M = 3000;
+
+static const double METRES_PER_DEGREE = 111319.49;
+
+TrackDatabase::TrackDatabase(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool TrackDatabase::load(const QString &fileName)
+{
+    clear();
+    QStringList errors;
+    loadFile(RESOURCE_FILE, errors);
+    if (QFile::exists(fileName))
+        loadFile(fileName, errors);
+    foreach (const QString &error, errors)
+        qDebug() << error;
+    emit tracksChanged();
+    return errors.isEmpty();
+}
+
+void TrackDatabase::clear()
+{
+    m_tracks.clear();
+    m_grid.clear();
+}
+
+bool TrackDatabase::loadFile(const QString &fileName, QStringList &errors)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        errors.append(QString("%1: %2").arg(fileName).arg(file.errorString()));
+        return false;
+    }
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    int lineNumber = 0;
+    while (!stream.atEnd()) {
+        const QString line = stream.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty() || line.startsWith('#'))
+            continue;
+        const QStringList fields = line.split(';');
+        const QStringList centre = fields.value(1).split(',');
+        Track track;
+        track.name = fields.at(0).trimmed();
+        bool ok = centre.size() == 4 && !track.name.isEmpty();
+        bool number;
+        track.latitude = centre.value(0).toDouble(&number);
+        ok = ok && number;
+        track.longitude = centre.value(1).toDouble(&number);
+        ok = ok && number;
+        track.zoomLevel = centre.value(2).toDouble(&number);
+        ok = ok && number;
+        track.bearing = centre.value(3).toDouble(&number);
+        ok = ok && number;
+        track.hasFinishLine = !fields.value(2).trimmed().isEmpty();
+        if (track.hasFinishLine)
+            ok = ok && parseLine(fields.at(2), track.finishLine);
+        if (!fields.value(3).trimmed().isEmpty()) {
+            foreach (const QString &text, fields.at(3).split('|')) {
+                TimingLine sector;
+                ok = ok && parseLine(text, sector);
+                track.sectorLines.append(sector);
+            }
+        }
+        track.hasPitLane = !fields.value(4).trimmed().isEmpty();
+        if (track.hasPitLane)
+            ok = ok && parseLine(fields.at(4), track.pitEntry) && parseLine(fields.value(5), track.pitExit);
+        if (!ok) {
+            errors.append(QString("%1 line %2: expected name;latitude,longitude,zoom,bearing;finish;sectors;pit entry;pit exit")
+                          .arg(fileName).arg(lineNumber));
+            continue;
+        }
+        // a track of a later file (the user file) replaces the track of the same name
+        const int existing = indexOf(track.name);
+        if (existing >= 0) {
+            const Track &replaced = m_tracks.at(existing);
+            const qint64 replacedCell = cell(row(replaced.latitude), column(replaced.longitude));
+            m_grid[replacedCell].removeOne(existing);
+            if (m_grid[replacedCell].isEmpty())
+                m_grid.remove(replacedCell);
+            m_tracks[existing] = track;
+        } else {
+            m_tracks.append(track);
+        }
+        m_grid[cell(row(track.latitude), column(track.longitude))].append(existing >= 0 ? existing : m_tracks.size() - 1);
+    }
+    return true;
+}
+
+bool TrackDatabase::parseLine(const QString &text, TimingLine &line)
+{
+    const QStringList values = text.split(',');
+    if (values.size() != 4)
+        return false;
+    bool ok[4];
+    line.latitude1 = values.at(0).toDouble(&ok[0]);
+    line.longitude1 = values.at(1).toDouble(&ok[1]);
+    line.latitude2 = values.at(2).toDouble(&ok[2]);
+    line.longitude2 = values.at(3).toDouble(&ok[3]);
+    return ok[0] && ok[1] && ok[2] && ok[3];
+}
+
+int TrackDatabase::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_tracks.size(); i++) {
+        if (m_tracks.at(i).name == name)
+            return i;
+    }
+    return -1;
+}
+
+int TrackDatabase::trackAt(double latitude, double longitude) const
+{
+    // a cell is at least DETECT_DISTANCE_M wide (up to about 74 degrees), so the neighbours are enough
+    const int centreRow = row(latitude);
+    const int centreColumn = column(longitude);
+    const double metresPerDegreeLongitude = METRES_PER_DEGREE * qCos(qDegreesToRadians(latitude));
+    int nearest = -1;
+    double nearestDistance = DETECT_DISTANCE_M * DETECT_DISTANCE_M;
+    for (int r = centreRow - 1; r <= centreRow + 1; r++) {
+        for (int c = centreColumn - 1; c <= centreColumn + 1; c++) {
+            const QHash<qint64, QVector<int> >::const_iterator it = m_grid.constFind(cell(r, c));
+            if (it == m_grid.constEnd())
+                continue;
+            foreach (int index, it.value()) {
+                const Track &track = m_tracks.at(index);
+                const double dy = (track.latitude - latitude) * METRES_PER_DEGREE;
+                const double dx = (track.longitude - longitude) * metresPerDegreeLongitude;
+                const double distance = dx * dx + dy * dy;
+                if (distance < nearestDistance) {
+                    nearestDistance = distance;
+                    nearest = index;
+                }
+            }
+        }
+    }
+    return nearest;
+}
+
+QStringList TrackDatabase::names() const
+{
+    QStringList names;
+    foreach (const Track &track, m_tracks)
+        names.append(track.name);
+    return names;
+}
+
+qint64 TrackDatabase::cell(int row, int column)
+{
+    return (qint64(row) << 32) | quint32(column);
+}
+
+int TrackDatabase::row(double latitude)
+{
+    return qFloor(latitude / CELL_SIZE);
+}
+
+int TrackDatabase::column(double longitude)
+{
+    return qFloor(longitude / CELL_SIZE);
+}
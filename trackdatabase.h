@@ -0,0 +1,85 @@
+#ifndef TRACKDATABASE_H
+#define TRACKDATABASE_H
+
+#include <QObject>
+#include <QVector>
+#include <QHash>
+#include <QStringList>
+
+// A timing line across the track, ex. the finish line
+struct TimingLine
+{
+    double latitude1;
+    double longitude1;
+    double latitude2;
+    double longitude2;
+};
+
+struct Track
+{
+    QString name;
+    double latitude;   // map centre
+    double longitude;
+    qreal zoomLevel;
+    qreal bearing;
+    bool hasFinishLine;
+    TimingLine finishLine;
+    QVector<TimingLine> sectorLines;
+    bool hasPitLane;
+    TimingLine pitEntry;
+    TimingLine pitExit;
+};
+
+/*
+ * Tracks, loaded from files with a line per track:
+ *
+ *   # name;latitude,longitude,zoom,bearing;finish line;sector lines;pit entry;pit exit
+ *   Zwartkops;-25.809960,28.111175,16.6,0;-25.809477,28.112105,-25.809404,28.112276;;;
+ *
+ * A line is latitude1,longitude1,latitude2,longitude2; sector lines are separated by '|' and
+ * the fields after the map centre may be empty. The tracks shipped in the resources are loaded
+ * first, then the user file; a track of the user file replaces the shipped track of the same name.
+ *
+ * The tracks are in a grid of CELL_SIZE degree cells by their centre, so the track at a position
+ * is found by looking at the 3x3 cells around it, however many tracks there are.
+ */
+class TrackDatabase : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QStringList names READ names NOTIFY tracksChanged)
+
+public:
+    static const char *RESOURCE_FILE;
+    static const char *DEFAULT_FILE;
+    static const qreal CELL_SIZE;
+    // farther from the centre of a track is not on that track
+    static const qreal DETECT_DISTANCE_M;
+
+    explicit TrackDatabase(QObject *parent = 0);
+
+    Q_INVOKABLE bool load(const QString &fileName = QString(DEFAULT_FILE));
+    Q_INVOKABLE void clear();
+
+    int size() const { return m_tracks.size(); }
+    const Track &track(int index) const { return m_tracks.at(index); }
+    Q_INVOKABLE int indexOf(const QString &name) const;
+    // Index of the nearest track within DETECT_DISTANCE_M of the position, -1 if there is none
+    int trackAt(double latitude, double longitude) const;
+
+    QStringList names() const;
+
+signals:
+    void tracksChanged();
+
+private:
+    bool loadFile(const QString &fileName, QStringList &errors);
+    static bool parseLine(const QString &text, TimingLine &line);
+    static qint64 cell(int row, int column);
+    static int row(double latitude);
+    static int column(double longitude);
+
+    QVector<Track> m_tracks;
+    QHash<qint64, QVector<int> > m_grid;
+};
+
+#endif // TRACKDATABASE_H
@@ -0,0 +1,117 @@
+/**
+ * Test of the track database.
+ *
+ * The shipped tracks are loaded with a user file that moves one of them and adds tracks next to
+ * the borders of the grid cells, at the equator and the prime meridian and with a farther
+ * track in the cell of the position. Every shipped track must be found at its centre and the
+ * tracks across a border must be found from the other side. A user file with an invalid line
+ * must fail to load but keep its valid tracks.
+ *
+ * Usage:
+ *   trackdatabasetest
+ * Returns 0 when every track is found where expected.
+ */
+#include "trackdatabase.h"
+#include <QDir>
+#include <QFile>
+#include <QTextStream>
+#include <iostream>
+
+using namespace std;
+
+const char *USER_TRACKS =
+        "# moved from -26.074283,28.751711\n"
+        "Redstar;-26.2,28.9,16,0;;;;\n"
+        "Equator;0.0001,-0.0001,16,0;;;;\n"
+        "Border;10.0001,20.0001,16,0;;;;\n"
+        "Inside;9.98,19.99,16,0;;;;\n";
+
+struct Lookup {
+    double latitude;
+    double longitude;
+    const char *track; // 0 = none
+};
+
+const Lookup LOOKUPS[] = {
+    {-26.2, 28.9, "Redstar"},
+    {-26.074283, 28.751711, 0},
+    // across both borders, into the diagonal cell
+    {-0.0001, 0.0001, "Equator"},
+    // 22 m across the border, while Inside is 2 km away in the same cell
+    {9.9999, 19.9999, "Border"},
+    {10.0001, 19.9999, "Border"},
+    {10.05, 20.05, 0},
+};
+
+bool writeFile(const QString &fileName, const QString &text)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+        return false;
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+    stream << text;
+    return true;
+}
+
+bool checkLookups(const TrackDatabase &tracks)
+{
+    bool passed = true;
+    for (const Lookup &lookup : LOOKUPS) {
+        const int found = tracks.trackAt(lookup.latitude, lookup.longitude);
+        const int expected = lookup.track ? tracks.indexOf(QString::fromUtf8(lookup.track)) : -1;
+        if (found != expected || (lookup.track && expected < 0)) {
+            cerr << "At " << lookup.latitude << "," << lookup.longitude << ": "
+                 << (found < 0 ? string("no track") : tracks.track(found).name.toStdString()) << ", expected "
+                 << (lookup.track ? lookup.track : "no track") << endl;
+            passed = false;
+        }
+    }
+    return passed;
+}
+
+int main()
+{
+    const QString fileName = QDir::temp().filePath("trackdatabasetest.txt");
+    bool passed = true;
+
+    TrackDatabase shipped;
+    if (!shipped.load(QString())) {
+        cerr << "Shipped tracks did not load" << endl;
+        passed = false;
+    }
+    for (int i = 0; i < shipped.size(); i++) {
+        const Track &track = shipped.track(i);
+        if (shipped.trackAt(track.latitude, track.longitude) != i) {
+            cerr << track.name.toStdString() << " not found at its centre" << endl;
+            passed = false;
+        }
+    }
+
+    TrackDatabase tracks;
+    if (!writeFile(fileName, QString::fromUtf8(USER_TRACKS)) || !tracks.load(fileName)) {
+        cerr << "User tracks did not load" << endl;
+        passed = false;
+    }
+    // Redstar is replaced, not added
+    if (tracks.size() != shipped.size() + 3 || tracks.names().count("Redstar") != 1) {
+        cerr << tracks.size() << " tracks, expected " << shipped.size() + 3 << endl;
+        passed = false;
+    }
+    passed = checkLookups(tracks) && passed;
+
+    TrackDatabase invalid;
+    if (!writeFile(fileName, QString::fromUtf8(USER_TRACKS) + "Invalid;10,20,16;;;;\n") || invalid.load(fileName)) {
+        cerr << "User file with an invalid line loaded" << endl;
+        passed = false;
+    }
+    if (invalid.size() != tracks.size() || invalid.indexOf("Invalid") >= 0) {
+        cerr << invalid.size() << " tracks with an invalid line, expected " << tracks.size() << endl;
+        passed = false;
+    }
+    passed = checkLookups(invalid) && passed;
+
+    QFile::remove(fileName);
+    cout << (passed ? "Passed" : "Failed") << endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,16 @@
+# Test of the track database; loads the shipped and a user track file and finds tracks (see trackdatabasetest.cpp).
+TEMPLATE = app
+TARGET = trackdatabasetest
+
+CONFIG += console c++11
+CONFIG -= app_bundle
+QT = core
+
+INCLUDEPATH += ..
+
+SOURCES += trackdatabasetest.cpp \
+    ../trackdatabase.cpp
+
+HEADERS += ../trackdatabase.h
+
+RESOURCES += trackdatabasetest.qrc
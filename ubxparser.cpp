@@ -0,0 +1,173 @@
+#include "ubxparser.h"
+#include <cstring>
+
+namespace {
+// UBX is little endian
+uint16_t readU2(const unsigned char *p)
+{
+    return static_cast<uint16_t>(p[0] | (p[1] << 8));
+}
+
+uint32_t readU4(const unsigned char *p)
+{
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8)
+            | (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+int32_t readI4(const unsigned char *p)
+{
+    return static_cast<int32_t>(readU4(p));
+}
+}
+
+UbxParser::UbxParser()
+    : m_payload(m_buffer)
+    , m_class(0)
+    , m_id(0)
+    , m_length(0)
+    , m_received(0)
+    , m_ckA(0)
+    , m_ckB(0)
+    , m_state(Sync1)
+    , m_hasFrame(false)
+    , m_errors(0)
+{
+}
+
+void UbxParser::addChecksum(unsigned char c)
+{
+    m_ckA += c;
+    m_ckB += m_ckA;
+}
+
+int UbxParser::feed(const char *data, int size)
+{
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(data);
+    m_hasFrame = false;
+    for (int i = 0; i < size; i++) {
+        const unsigned char c = bytes[i];
+        switch (m_state) {
+        case Sync1:
+            if (c == SYNC1)
+                m_state = Sync2;
+            break;
+        case Sync2:
+            m_state = c == SYNC2 ? Class : (c == SYNC1 ? Sync2 : Sync1);
+            break;
+        case Class:
+            m_class = c;
+            m_ckA = 0;
+            m_ckB = 0;
+            addChecksum(c);
+            m_state = Id;
+            break;
+        case Id:
+            m_id = c;
+            addChecksum(c);
+            m_state = Length1;
+            break;
+        case Length1:
+            m_length = c;
+            addChecksum(c);
+            m_state = Length2;
+            break;
+        case Length2:
+            m_length |= c << 8;
+            addChecksum(c);
+            if (m_length > MAX_PAYLOAD) {
+                m_errors++;
+                m_state = Sync1;
+                break;
+            }
+            m_received = 0;
+            m_payload = m_buffer;
+            m_state = m_length ? Payload : ChecksumA;
+            break;
+        case Payload: {
+            const int available = size - i < m_length - m_received ? size - i : m_length - m_received;
+            const unsigned char *chunk = bytes + i;
+            // the frame is returned after its checksum, so the chunk is only used in place when
+            // the checksum is in it as well; otherwise the chunk is gone by then
+            if (m_received == 0 && i + m_length + 2 <= size)
+                m_payload = chunk;
+            else
+                memcpy(m_buffer + m_received, chunk, available);
+            for (int j = 0; j < available; j++)
+                addChecksum(chunk[j]);
+            m_received += available;
+            i += available - 1;
+            if (m_received == m_length)
+                m_state = ChecksumA;
+            break;
+        }
+        case ChecksumA:
+            if (c == m_ckA) {
+                m_state = ChecksumB;
+            } else {
+                m_errors++;
+                m_state = Sync1;
+            }
+            break;
+        case ChecksumB:
+            m_state = Sync1;
+            if (c != m_ckB) {
+                m_errors++;
+                break;
+            }
+            m_hasFrame = true;
+            return i + 1;
+        }
+    }
+    return size;
+}
+
+bool UbxParser::navPvt(UbxNavPvt &pvt) const
+{
+    // 84 bytes up to u-blox 7, 92 bytes from u-blox 8 on; the fields we use are in both
+    if (!m_hasFrame || m_class != CLASS_NAV || m_id != ID_NAV_PVT || m_length < 84)
+        return false;
+    const unsigned char *p = m_payload;
+    pvt.iTOW = readU4(p);
+    pvt.year = readU2(p + 4);
+    pvt.month = p[6];
+    pvt.day = p[7];
+    pvt.hour = p[8];
+    pvt.min = p[9];
+    pvt.sec = p[10];
+    pvt.valid = p[11];
+    pvt.nano = readI4(p + 16);
+    pvt.fixType = p[20];
+    pvt.flags = p[21];
+    pvt.numSV = p[23];
+    pvt.lon = readI4(p + 24);
+    pvt.lat = readI4(p + 28);
+    pvt.hMSL = readI4(p + 36);
+    pvt.hAcc = readU4(p + 40);
+    pvt.velN = readI4(p + 48);
+    pvt.velE = readI4(p + 52);
+    pvt.velD = readI4(p + 56);
+    pvt.gSpeed = readI4(p + 60);
+    pvt.headMot = readI4(p + 64);
+    pvt.sAcc = readU4(p + 68);
+    return true;
+}
+
+bool UbxParser::acknowledge(bool &acknowledged, unsigned char &messageClass, unsigned char &messageId) const
+{
+    if (!m_hasFrame || m_class != CLASS_ACK || m_length != 2)
+        return false;
+    acknowledged = m_id == ID_ACK_ACK;
+    messageClass = m_payload[0];
+    messageId = m_payload[1];
+    return true;
+}
+
+void UbxParser::checksum(const unsigned char *data, int size, unsigned char &ckA, unsigned char &ckB)
+{
+    ckA = 0;
+    ckB = 0;
+    for (int i = 0; i < size; i++) {
+        ckA += data[i];
+        ckB += ckA;
+    }
+}
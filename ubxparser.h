@@ -0,0 +1,108 @@
+#ifndef UBXPARSER_H
+#define UBXPARSER_H
+
+#include <stdint.h>
+
+/*
+ * Incremental u-blox UBX binary protocol framer.
+ *
+ * Bytes are fed as they arrive from the serial port, in chunks of any size; every frame in a chunk
+ * is returned, one at a time, after its 8 bit Fletcher checksum was checked. When the whole
+ * payload and the checksum of a frame are inside the chunk, payload() points into the chunk
+ * itself, otherwise the pieces are assembled in a fixed buffer; the payload is valid until the
+ * next feed() and, in place, as long as the chunk. Bytes outside of a frame (ex. NMEA sentences)
+ * are skipped.
+ */
+
+// UBX-NAV-PVT, units as sent by the receiver
+struct UbxNavPvt
+{
+    uint32_t iTOW;      // GPS time of week of the navigation epoch, ms
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;
+    uint8_t min;
+    uint8_t sec;
+    uint8_t valid;      // validDate, validTime, fullyResolved
+    int32_t nano;       // fraction of the second, ns
+    uint8_t fixType;    // 0 no fix, 1 dead reckoning, 2 2D, 3 3D, 4 GNSS + dead reckoning, 5 time only
+    uint8_t flags;      // gnssFixOK, diffSoln, ...
+    uint8_t numSV;
+    int32_t lon;        // deg * 1e-7
+    int32_t lat;        // deg * 1e-7
+    int32_t hMSL;       // height above mean sea level, mm
+    uint32_t hAcc;      // mm
+    int32_t velN;       // mm/s
+    int32_t velE;       // mm/s
+    int32_t velD;       // mm/s
+    int32_t gSpeed;     // ground speed, mm/s
+    int32_t headMot;    // heading of motion, deg * 1e-5
+    uint32_t sAcc;      // mm/s
+};
+
+class UbxParser
+{
+public:
+    static const unsigned char SYNC1 = 0xB5;
+    static const unsigned char SYNC2 = 0x62;
+    static const unsigned char CLASS_NAV = 0x01;
+    static const unsigned char CLASS_ACK = 0x05;
+    static const unsigned char CLASS_CFG = 0x06;
+    static const unsigned char ID_NAV_PVT = 0x07;
+    static const unsigned char ID_ACK_NAK = 0x00;
+    static const unsigned char ID_ACK_ACK = 0x01;
+    // larger than any message we use; a bigger length means we are out of sync
+    static const int MAX_PAYLOAD = 512;
+
+    UbxParser();
+
+    // Consumes bytes up to the end of the next valid frame; returns the number of bytes used
+    int feed(const char *data, int size);
+    bool hasFrame() const { return m_hasFrame; }
+
+    unsigned char messageClass() const { return m_class; }
+    unsigned char messageId() const { return m_id; }
+    int payloadLength() const { return m_length; }
+    const unsigned char *payload() const { return m_payload; }
+
+    // Decodes the current frame; false if it is not a NAV-PVT
+    bool navPvt(UbxNavPvt &pvt) const;
+    // Class and id of the command the current ACK-ACK / ACK-NAK frame answers
+    bool acknowledge(bool &acknowledged, unsigned char &messageClass, unsigned char &messageId) const;
+
+    // Frames rejected because of their checksum or length
+    unsigned long errors() const { return m_errors; }
+
+    // Fletcher checksum over class, id, length and payload, ex. to build a frame to send
+    static void checksum(const unsigned char *data, int size, unsigned char &ckA, unsigned char &ckB);
+
+private:
+    enum State {
+        Sync1,
+        Sync2,
+        Class,
+        Id,
+        Length1,
+        Length2,
+        Payload,
+        ChecksumA,
+        ChecksumB
+    };
+
+    void addChecksum(unsigned char c);
+
+    unsigned char m_buffer[MAX_PAYLOAD];
+    const unsigned char *m_payload;
+    unsigned char m_class;
+    unsigned char m_id;
+    int m_length;
+    int m_received;
+    unsigned char m_ckA;
+    unsigned char m_ckB;
+    State m_state;
+    bool m_hasFrame;
+    unsigned long m_errors;
+};
+
+#endif // UBXPARSER_H
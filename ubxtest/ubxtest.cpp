@@ -0,0 +1,142 @@
+/**
+ * Test of the UBX framer.
+ *
+ * A stream of a NAV-PVT frame, an ACK-ACK frame, a NAV-PVT frame with a corrupted payload and
+ * another NAV-PVT frame, with an NMEA sentence in front, is split in two chunks at every offset
+ * and then fed in chunks of every size. Each chunk is copied to its own buffer, which is freed
+ * as soon as the parser has used it, as the serial port buffer would be, so a payload that
+ * still points into a previous chunk is caught by the address sanitizer.
+ *
+ * Usage:
+ *   ubxtest
+ * Returns 0 when every split decodes the same frames.
+ */
+#include "ubxparser.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+
+using namespace std;
+
+typedef vector<unsigned char> Bytes;
+
+const int32_t LATITUDE = -260752000;
+const int32_t LONGITUDE = 287550600;
+const int32_t GROUND_SPEED = 27778;
+const unsigned char SATELLITES = 14;
+const unsigned char ID_CFG_RATE = 0x08;
+
+Bytes frame(unsigned char messageClass, unsigned char messageId, const Bytes &payload)
+{
+    const unsigned char header[] = {UbxParser::SYNC1, UbxParser::SYNC2, messageClass, messageId,
+                                    static_cast<unsigned char>(payload.size() & 0xFF),
+                                    static_cast<unsigned char>(payload.size() >> 8)};
+    Bytes frame(header, header + sizeof(header));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    unsigned char ckA;
+    unsigned char ckB;
+    UbxParser::checksum(&frame[2], int(frame.size()) - 2, ckA, ckB);
+    frame.push_back(ckA);
+    frame.push_back(ckB);
+    return frame;
+}
+
+void writeI4(Bytes &payload, int offset, int32_t value)
+{
+    for (int i = 0; i < 4; i++)
+        payload[offset + i] = static_cast<unsigned char>(uint32_t(value) >> (8 * i));
+}
+
+struct Counts {
+    int pvt;
+    int ack;
+    int wrong; // frames decoded with other values than sent
+};
+
+void handleFrame(const UbxParser &parser, Counts &counts)
+{
+    UbxNavPvt pvt;
+    bool acknowledged;
+    unsigned char messageClass;
+    unsigned char messageId;
+    if (parser.navPvt(pvt)) {
+        counts.pvt++;
+        if (pvt.lat != LATITUDE || pvt.lon != LONGITUDE || pvt.gSpeed != GROUND_SPEED || pvt.numSV != SATELLITES)
+            counts.wrong++;
+    } else if (parser.acknowledge(acknowledged, messageClass, messageId)) {
+        counts.ack++;
+        if (!acknowledged || messageClass != UbxParser::CLASS_CFG || messageId != ID_CFG_RATE)
+            counts.wrong++;
+    } else {
+        counts.wrong++;
+    }
+}
+
+// Feeds the bytes [first, end) of the stream from a buffer that is freed afterwards
+void feedChunk(UbxParser &parser, const Bytes &stream, size_t first, size_t end, Counts &counts)
+{
+    char *chunk = new char[end - first];
+    memcpy(chunk, &stream[first], end - first);
+    const char *data = chunk;
+    int size = int(end - first);
+    while (size > 0) {
+        const int used = parser.feed(data, size);
+        data += used;
+        size -= used;
+        if (parser.hasFrame())
+            handleFrame(parser, counts);
+    }
+    delete[] chunk;
+}
+
+bool check(const char *test, size_t at, const UbxParser &parser, const Counts &counts)
+{
+    if (counts.pvt == 2 && counts.ack == 1 && counts.wrong == 0 && parser.errors() == 1)
+        return true;
+    cerr << test << " " << at << ": " << counts.pvt << " NAV-PVT, " << counts.ack << " ACK, "
+         << counts.wrong << " wrong, " << parser.errors() << " errors" << endl;
+    return false;
+}
+
+int main()
+{
+    Bytes pvtPayload(92, 0);
+    writeI4(pvtPayload, 24, LONGITUDE);
+    writeI4(pvtPayload, 28, LATITUDE);
+    writeI4(pvtPayload, 60, GROUND_SPEED);
+    pvtPayload[20] = 3;
+    pvtPayload[21] = 0x01;
+    pvtPayload[23] = SATELLITES;
+    const Bytes pvt = frame(UbxParser::CLASS_NAV, UbxParser::ID_NAV_PVT, pvtPayload);
+    const unsigned char acknowledged[] = {UbxParser::CLASS_CFG, ID_CFG_RATE};
+    const Bytes ackPayload(acknowledged, acknowledged + sizeof(acknowledged));
+    const Bytes ack = frame(UbxParser::CLASS_ACK, UbxParser::ID_ACK_ACK, ackPayload);
+    Bytes corrupted = pvt;
+    corrupted[40] ^= 0x01;
+
+    const string nmea = "$GPTXT,01,01,02,u-blox*00\r\n";
+    Bytes stream(nmea.begin(), nmea.end());
+    stream.insert(stream.end(), pvt.begin(), pvt.end());
+    stream.insert(stream.end(), ack.begin(), ack.end());
+    stream.insert(stream.end(), corrupted.begin(), corrupted.end());
+    stream.insert(stream.end(), pvt.begin(), pvt.end());
+
+    bool passed = true;
+    for (size_t split = 0; split <= stream.size(); split++) {
+        UbxParser parser;
+        Counts counts = {0, 0, 0};
+        feedChunk(parser, stream, 0, split, counts);
+        feedChunk(parser, stream, split, stream.size(), counts);
+        passed = check("Split at", split, parser, counts) && passed;
+    }
+    for (size_t chunk = 1; chunk <= stream.size(); chunk++) {
+        UbxParser parser;
+        Counts counts = {0, 0, 0};
+        for (size_t first = 0; first < stream.size(); first += chunk)
+            feedChunk(parser, stream, first, min(first + chunk, stream.size()), counts);
+        passed = check("Chunks of", chunk, parser, counts) && passed;
+    }
+    cout << (passed ? "Passed" : "Failed") << endl;
+    return passed ? 0 : 1;
+}
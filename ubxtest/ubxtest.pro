@@ -0,0 +1,13 @@
+# Test of the UBX framer; splits frames at every offset (see ubxtest.cpp).
+TEMPLATE = app
+TARGET = ubxtest
+
+CONFIG += console c++11
+CONFIG -= qt app_bundle
+
+INCLUDEPATH += ..
+
+SOURCES += ubxtest.cpp \
+    ../ubxparser.cpp
+
+HEADERS += ../ubxparser.h
@@ -49,6 +49,7 @@ void udpreceiver::processPendingDatagrams()
     while (udpSocket->hasPendingDatagrams()) {
         datagram.resize(int(udpSocket->pendingDatagramSize()));
         udpSocket->readDatagram(datagram.data(), datagram.size());
+        SampleTimeScope received(m_dashboard, SampleClock::now());
 
         QDataStream in(&datagram, QIODevice::ReadOnly);
         QString raw = datagram.data();
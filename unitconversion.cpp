@@ -0,0 +1,52 @@
+#include "unitconversion.h"
+
+static bool isImperial(const QString &units)
+{
+    return units == QLatin1String("imperial");
+}
+
+UnitConversionPlan::UnitConversionPlan()
+    : m_speedImperial(false)
+    , m_speedCorrection(1)
+{
+}
+
+void UnitConversionPlan::setTemperatureUnits(const QString &units)
+{
+    m_conversions[Temperature] = isImperial(units) ? UnitConversion(1.8, 32) : UnitConversion();
+}
+
+void UnitConversionPlan::setPressureUnits(const QString &units)
+{
+    const bool imperial = isImperial(units);
+    m_conversions[Pressure] = imperial ? UnitConversion(0.145038, 0) : UnitConversion();
+    m_conversions[BoostPressure] = imperial ? UnitConversion(14.2233, 0) : UnitConversion();
+    m_conversions[BoostVacuum] = imperial ? UnitConversion(0.039370079197446, 0) : UnitConversion();
+}
+
+void UnitConversionPlan::setSpeedUnits(const QString &units)
+{
+    m_speedImperial = isImperial(units);
+    resolveSpeed();
+}
+
+void UnitConversionPlan::setSpeedCorrection(const qreal &speedpercent)
+{
+    m_speedCorrection = speedpercent;
+    resolveSpeed();
+}
+
+void UnitConversionPlan::resolveSpeed()
+{
+    const qreal scale = m_speedImperial ? 0.621371 : 1;
+    m_conversions[Speed] = UnitConversion(scale, 0);
+    m_conversions[CorrectedSpeed] = UnitConversion(scale * m_speedCorrection, 0);
+}
+
+void UnitConversionPlan::convert(Quantity quantity, const qreal *values, qreal *converted, int count) const
+{
+    const qreal scale = m_conversions[quantity].scale;
+    const qreal offset = m_conversions[quantity].offset;
+    for (int i = 0; i < count; i++)
+        converted[i] = values[i] * scale + offset;
+}
@@ -0,0 +1,55 @@
+#ifndef UNITCONVERSION_H
+#define UNITCONVERSION_H
+
+#include <QString>
+
+/*
+ * Converts channel values from the units the ECUs report (metric) to the units selected
+ * for display. The selected units are resolved once, when they change, into a
+ * scale/offset per quantity; setters then only apply a multiply-add.
+ */
+struct UnitConversion
+{
+    qreal scale;
+    qreal offset;
+
+    UnitConversion() : scale(1), offset(0) {}
+    UnitConversion(qreal s, qreal o) : scale(s), offset(o) {}
+    qreal apply(const qreal &value) const { return value * scale + offset; }
+};
+
+class UnitConversionPlan
+{
+public:
+    enum Quantity {
+        Temperature,      // °C -> °F
+        Pressure,         // kPa/bar -> psi
+        BoostPressure,    // kg/cm2 -> psi (positive boost)
+        BoostVacuum,      // mmHg -> inHg (vacuum)
+        Speed,            // km/h -> mph
+        CorrectedSpeed,   // Speed including the speed correction percentage
+        QuantityCount
+    };
+
+    UnitConversionPlan();
+
+    // Each setting is "metric" or "imperial"; anything else is treated as metric
+    void setTemperatureUnits(const QString &units);
+    void setPressureUnits(const QString &units);
+    void setSpeedUnits(const QString &units);
+    void setSpeedCorrection(const qreal &speedpercent);
+
+    const UnitConversion &conversion(Quantity quantity) const { return m_conversions[quantity]; }
+    qreal convert(Quantity quantity, const qreal &value) const { return m_conversions[quantity].apply(value); }
+    // Converts a batch of channels of the same quantity
+    void convert(Quantity quantity, const qreal *values, qreal *converted, int count) const;
+
+private:
+    void resolveSpeed();
+
+    bool m_speedImperial;
+    qreal m_speedCorrection;
+    UnitConversion m_conversions[QuantityCount];
+};
+
+#endif // UNITCONVERSION_H
@@ -28,6 +28,8 @@ if nc -zw5 www.github.com 443; then
 		mkdir /home/pi/maptiles
 		cp -a /home/pi/src/GPSTracks/. /home/pi/maptiles
                 fi
+# The map tiles are packed again at the next start
+		rm -f /home/pi/maptiles/tiles.pack
 # Check if there is a build folder
 		if [ -d /home/pi/build ]; then
 		echo "Delete previous build folder"